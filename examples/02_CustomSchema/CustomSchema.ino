@@ -11,6 +11,7 @@
 #include <IonConnect.h>
 
 IonConnectDevice ion;
+IonConnect::ConfigHandle updateInterval;
 
 // Define custom configuration schema
 const char* customSchema = R"json({
@@ -111,6 +112,9 @@ void setup() {
     
     Serial.println("✓ Custom schema loaded");
     
+    // Bind hot-path fields once; reads are then O(1)
+    updateInterval = ion.getConfigHandle("update_interval");
+    
     // Register callbacks
     ion.onConnect([]() {
         Serial.println("\n✓ WiFi Connected!");
@@ -127,7 +131,7 @@ void setup() {
         Serial.println("  Update Interval: " + updateInterval + "s");
         Serial.println("  Log Level: " + logLevel);
         
-        if (mqttEnabled == "true") {
+        if (ion.getConfigBool("mqtt_enabled")) {
             String mqttHost = ion.getConfig("mqtt_host");
             String mqttPort = ion.getConfig("mqtt_port");
             String mqttUser = ion.getConfig("mqtt_user");
@@ -137,7 +141,7 @@ void setup() {
             Serial.println("  Username: " + mqttUser);
             
             // Here you would initialize your MQTT client
-            // connectMQTT(mqttHost, mqttPort.toInt(), mqttUser, mqttPass);
+            // connectMQTT(mqttHost, ion.getConfigInt("mqtt_port"), mqttUser, mqttPass);
         }
     });
     
@@ -159,7 +163,7 @@ void loop() {
     
     // Your application logic here
     static uint32_t lastUpdate = 0;
-    uint32_t interval = ion.getConfig("update_interval").toInt() * 1000;
+    uint32_t interval = updateInterval.getInt() * 1000;
     
     if (ion.isConnected() && millis() - lastUpdate > interval) {
         lastUpdate = millis();
@@ -81,6 +81,10 @@ public:
         )html";
     }
     
+    const char* getConfigInterest() override {
+        return "device_name";   // Only notified when these keys change
+    }
+    
     void onConfigChanged(const String& key, const String& value) override {
         Serial.println("[Plugin] Config changed: " + key + " = " + value);
     }
@@ -162,7 +166,7 @@ void loop() {
  *    - Fetch data from your API
  * 
  * 4. Events:
- *    - React to config changes
+ *    - React to config changes (filtered by getConfigInterest())
  *    - Monitor WiFi status
  *    - Update internal state
  * 
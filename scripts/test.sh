@@ -116,6 +116,17 @@ echo -e "${BLUE}8. Code Quality Tests${NC}\n"
 run_test "All headers have include guards" "find src -name '*.h' -exec grep -l '#ifndef' {} + | wc -l | grep -q '[0-9]'"
 run_test "Main header exists and is clean" "test -f src/IonConnect.h && ! grep -q 'FIXME' src/IonConnect.h"
 
+echo -e "${BLUE}9. Host Tests${NC}\n"
+
+# Library sources built for the PC against test/host/mock; the full output
+# (including benchmark figures) goes to _host_build/host_tests.log
+if command -v "${CXX:-g++}" > /dev/null; then
+    mkdir -p _host_build
+    run_test "Host tests and benchmarks" "test/host/run.sh > _host_build/host_tests.log 2>&1"
+else
+    echo -e "${YELLOW}Skipped: no C++ compiler${NC}\n"
+fi
+
 # Summary
 echo -e "${BLUE}========================================${NC}"
 echo -e "${BLUE}  Test Summary${NC}"
@@ -37,6 +37,10 @@ struct IonConfig {
     bool autoReconnect = true;
     uint32_t connectionTimeoutMs = 10000;   
 #endif
+    IPMode ipMode = IP_DHCP;                // For networks without their own (setNetworkIP)
+    IPSettings staticIP;                    // When ipMode is IP_STATIC
+    NetworkScoring networkScoring = SCORING_WEIGHTED;  // How to pick among saved networks in range
+    uint8_t scoringHysteresis = 8;          // Score lead needed to leave the last network (0 = none)
     
     // Features (automatically set by ION_MINIMAL_MODE in IonTypes.h)
     bool enableBLE = ION_ENABLE_BLE;        
@@ -58,6 +62,9 @@ struct IonConfig {
     String hostname = "";                   // mDNS hostname (auto-generated if empty)
     bool enableCaptivePortal = true;        // DNS redirect
     uint16_t webServerPort = 80;
+    uint32_t configCommitDelayMs = 1000;    // Coalesce config writes (0 = write on every save)
+    StorageBackend storageBackend = STORAGE_DEFAULT;  // STORAGE_LITTLEFS needs ION_USE_LITTLEFS
+    bool asyncCommit = true;                // Portal/BLE saves commit on a worker, not in the handler
     
     IonConfig() {}
     
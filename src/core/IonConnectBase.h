@@ -5,6 +5,12 @@
 #include <functional>
 #include "IonTypes.h"
 #include "IonConfig.h"
+#include "../modules/ConfigHandle.h"
+#include "../modules/ConfigTransaction.h"
+
+#if ION_ENABLE_PLUGINS
+#include "../plugins/IonPlugin.h"
+#endif
 
 namespace IonConnect {
 
@@ -31,10 +37,20 @@ public:
     // Configuration
     virtual String getConfig(const String& key) = 0;
     virtual bool setConfig(const String& key, const String& value) = 0;
+    virtual int32_t getConfigInt(const String& key, int32_t defaultValue = 0) = 0;
+    virtual bool getConfigBool(const String& key, bool defaultValue = false) = 0;
+    virtual float getConfigFloat(const String& key, float defaultValue = 0.0f) = 0;
+    virtual bool setConfigInt(const String& key, int32_t value) = 0;
+    virtual bool setConfigBool(const String& key, bool value) = 0;
+    virtual bool setConfigFloat(const String& key, float value) = 0;
+    virtual ConfigHandle getConfigHandle(const String& key) = 0; // Bind once, read in O(1)
+    virtual ConfigTransaction beginConfigTransaction() = 0; // All-or-nothing batch update
     virtual bool loadConfigSchema(const char* jsonSchema) = 0;
+    virtual bool loadConfigSchema(const ConfigField* table, size_t count, const char* jsonSchema) = 0;
     virtual String exportConfig() = 0; // JSON backup
     virtual bool importConfig(const String& json) = 0; // Restore
     virtual bool clearConfig() = 0;
+    virtual bool flushConfig() = 0; // Write pending changes now (e.g. before restart)
     
     // WiFi Management
     virtual bool connect() = 0;
@@ -42,11 +58,14 @@ public:
     virtual bool isConnected() = 0;
     virtual WiFiState getStatus() = 0;
     virtual bool addNetwork(const String& ssid, const String& pass, int priority = 0) = 0;
+    virtual bool setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings = IPSettings()) = 0; // Saved network only
     
     // Event Callbacks
     virtual void onConnect(std::function<void()> cb) = 0;
     virtual void onDisconnect(std::function<void()> cb) = 0;
     virtual void onConfigSaved(std::function<void()> cb) = 0;
+    virtual void onConfigChange(const char* keys, std::function<void(const String&, const String&)> cb) = 0; // keys: "a,b" or nullptr for all
+    virtual void onConfigMigration(std::function<void(uint32_t, uint32_t)> cb) = 0; // Register before init()
     virtual void onPortalStart(std::function<void()> cb) = 0;
     virtual void onPortalTimeout(std::function<void()> cb) = 0;
     virtual void onError(std::function<void(IonError, const char*)> cb) = 0;
@@ -55,6 +74,11 @@ public:
     virtual void setPortalPassword(const String& password) = 0;
     virtual void setAccessToken(const String& token) = 0;
     
+#if ION_ENABLE_PLUGINS
+    // Plugins (register before begin())
+    virtual bool registerPlugin(IonPlugin* plugin) = 0;
+#endif
+    
 #if ION_ENABLE_DIAGNOSTICS
     // Diagnostics
     virtual DiagnosticsData getDiagnostics() = 0;
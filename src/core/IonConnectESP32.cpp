@@ -11,8 +11,10 @@ IonConnectESP32::IonConnectESP32()
     : initialized(false), portalActive(false), portalStartTime(0), portalTimeout(0) {
     
     storage = new StorageNVS();
+    commitWorker = nullptr;
     configManager = new ConfigManager(storage);
     wifiCore = new WiFiConnectionCore(configManager);
+    scoringPolicy = nullptr;
     securityManager = new SecurityManager();
     webPortal = new WebPortal(configManager, wifiCore, securityManager);
     
@@ -20,18 +22,28 @@ IonConnectESP32::IonConnectESP32()
     diagnostics = new DiagnosticsCollector();
     webPortal->setDiagnosticsCollector(diagnostics);
     #endif
+    
+    #if ION_ENABLE_PLUGINS
+    pluginRegistry = new PluginRegistry();
+    #endif
 }
 
 IonConnectESP32::~IonConnectESP32() {
     delete webPortal;
     delete securityManager;
     delete wifiCore;
+    delete scoringPolicy;
     delete configManager;
+    delete commitWorker;        // Commits anything still requested
     delete storage;
     
     #if ION_ENABLE_DIAGNOSTICS
     delete diagnostics;
     #endif
+    
+    #if ION_ENABLE_PLUGINS
+    delete pluginRegistry;
+    #endif
 }
 
 bool IonConnectESP32::init(const char* name, const IonConfig& cfg) {
@@ -46,16 +58,46 @@ bool IonConnectESP32::init(const char* name, const IonConfig& cfg) {
     ION_LOG("Initializing IonConnect for ESP32");
     ION_LOG("Device: %s", deviceName.c_str());
     
+    // Switch to LittleFS storage if requested
+    if (config.storageBackend == STORAGE_LITTLEFS) {
+        #if ION_USE_LITTLEFS
+        if (LittleFS.begin(true)) {
+            delete storage;
+            storage = new StorageLittleFS();
+            configManager->setStorage(storage);
+            webPortal->setKeepFilesystemMounted(true);
+        } else {
+            ION_LOG_W("LittleFS mount failed, using NVS");
+        }
+        #else
+        ION_LOG_W("LittleFS disabled, using NVS");
+        #endif
+    }
+    
     // Initialize storage
     if (!storage->begin()) {
         ION_LOG_E("Failed to initialize storage");
         return false;
     }
     
+    // Commit worker: NVS can be committed from its own task, the others
+    // are committed from handle()
+    if (config.asyncCommit) {
+        commitWorker = new CommitWorker(storage, config.storageBackend == STORAGE_DEFAULT);
+        commitWorker->onComplete([this](bool success) {
+            if (portalActive) {
+                webPortal->broadcastCommit(success);
+            }
+        });
+        commitWorker->begin();
+        configManager->setCommitWorker(commitWorker);
+    }
+    
     // Load default schema if no custom schema loaded
     loadDefaultSchema();
     
     // Load configuration
+    configManager->setCommitDelay(config.configCommitDelayMs);
     configManager->load();
     
     // Setup security
@@ -70,6 +112,13 @@ bool IonConnectESP32::init(const char* name, const IonConfig& cfg) {
     wifiCore->setMaxReconnectAttempts(config.maxReconnectAttempts);
     wifiCore->setReconnectDelay(config.reconnectDelayMs);
     wifiCore->setConnectionTimeout(config.connectionTimeoutMs);
+    wifiCore->setIPDefaults(config.ipMode, config.staticIP);
+    if (config.networkScoring == SCORING_RSSI) {
+        scoringPolicy = new RSSIScoringPolicy();
+    } else {
+        scoringPolicy = new WeightedScoringPolicy();
+    }
+    wifiCore->setScoringPolicy(scoringPolicy, config.scoringHysteresis);
     
     // Register WiFi callbacks
     wifiCore->onConnect([this]() {
@@ -78,11 +127,17 @@ bool IonConnectESP32::init(const char* name, const IonConfig& cfg) {
             webPortal->broadcastStatus("connected", wifiCore->getSSID(), 
                                       wifiCore->getIP().toString());
         }
+        #if ION_ENABLE_PLUGINS
+        pluginRegistry->notifyWiFiConnect();
+        #endif
         if (connectCallback) connectCallback();
     });
     
     wifiCore->onDisconnect([this]() {
         ION_LOG("WiFi disconnected");
+        #if ION_ENABLE_PLUGINS
+        pluginRegistry->notifyWiFiDisconnect();
+        #endif
         if (disconnectCallback) disconnectCallback();
     });
     
@@ -112,6 +167,13 @@ bool IonConnectESP32::begin() {
     // Load saved networks
     wifiCore->loadNetworks();
     
+    #if ION_ENABLE_PLUGINS
+    // Start plugins: config events are filtered by each plugin's interest
+    pluginRegistry->initAll(this);
+    pluginRegistry->subscribeAll(configManager);
+    pluginRegistry->registerAllRoutes(webPortal->getServer());
+    #endif
+    
     // Check if we have credentials
     String ssid = configManager->get("wifi_ssid");
     
@@ -136,6 +198,16 @@ void IonConnectESP32::handle() {
     // Handle WiFi state machine
     wifiCore->handle();
     
+    // Deliver config change events, write coalesced changes
+    configManager->handle();
+    if (commitWorker) {
+        commitWorker->step();
+    }
+    
+    #if ION_ENABLE_PLUGINS
+    pluginRegistry->handleAll();
+    #endif
+    
     // Handle web portal
     if (portalActive) {
         webPortal->handle();
@@ -179,6 +251,11 @@ bool IonConnectESP32::startPortal(uint32_t timeoutSeconds) {
     portalStartTime = millis();
     portalTimeout = timeoutSeconds * 1000;
     
+    // Network list ready by the time the page opens
+    if (wifiCore->getScanAge() > WiFiConnectionCore::SCAN_CACHE_TTL) {
+        wifiCore->startScan();
+    }
+    
     IPAddress ip = WiFi.softAPIP();
     ION_LOG("Portal started: %s", ip.toString().c_str());
     ION_LOG("SSID: %s", generateAPSSID().c_str());
@@ -212,10 +289,46 @@ bool IonConnectESP32::setConfig(const String& key, const String& value) {
     return configManager->set(key, value);
 }
 
+int32_t IonConnectESP32::getConfigInt(const String& key, int32_t defaultValue) {
+    return configManager->getInt(key, defaultValue);
+}
+
+bool IonConnectESP32::getConfigBool(const String& key, bool defaultValue) {
+    return configManager->getBool(key, defaultValue);
+}
+
+float IonConnectESP32::getConfigFloat(const String& key, float defaultValue) {
+    return configManager->getFloat(key, defaultValue);
+}
+
+bool IonConnectESP32::setConfigInt(const String& key, int32_t value) {
+    return configManager->setInt(key, value);
+}
+
+bool IonConnectESP32::setConfigBool(const String& key, bool value) {
+    return configManager->setBool(key, value);
+}
+
+bool IonConnectESP32::setConfigFloat(const String& key, float value) {
+    return configManager->setFloat(key, value);
+}
+
+ConfigHandle IonConnectESP32::getConfigHandle(const String& key) {
+    return configManager->getHandle(key);
+}
+
+ConfigTransaction IonConnectESP32::beginConfigTransaction() {
+    return configManager->beginTransaction();
+}
+
 bool IonConnectESP32::loadConfigSchema(const char* jsonSchema) {
     return configManager->loadSchema(jsonSchema);
 }
 
+bool IonConnectESP32::loadConfigSchema(const ConfigField* table, size_t count, const char* jsonSchema) {
+    return configManager->loadSchema(table, count, jsonSchema);
+}
+
 String IonConnectESP32::exportConfig() {
     return configManager->exportJSON();
 }
@@ -228,6 +341,10 @@ bool IonConnectESP32::clearConfig() {
     return configManager->clear();
 }
 
+bool IonConnectESP32::flushConfig() {
+    return configManager->flush();
+}
+
 bool IonConnectESP32::connect() {
     String ssid = configManager->get("wifi_ssid");
     String pass = configManager->get("wifi_pass");
@@ -256,6 +373,10 @@ bool IonConnectESP32::addNetwork(const String& ssid, const String& pass, int pri
     return wifiCore->addNetwork(ssid, pass, priority);
 }
 
+bool IonConnectESP32::setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings) {
+    return wifiCore->setNetworkIP(ssid, mode, settings);
+}
+
 void IonConnectESP32::onConnect(std::function<void()> cb) {
     connectCallback = cb;
 }
@@ -268,6 +389,14 @@ void IonConnectESP32::onConfigSaved(std::function<void()> cb) {
     configSavedCallback = cb;
 }
 
+void IonConnectESP32::onConfigChange(const char* keys, std::function<void(const String&, const String&)> cb) {
+    configManager->onChange(keys, cb);
+}
+
+void IonConnectESP32::onConfigMigration(std::function<void(uint32_t, uint32_t)> cb) {
+    configManager->onSchemaMigration(cb);
+}
+
 void IonConnectESP32::onPortalStart(std::function<void()> cb) {
     portalStartCallback = cb;
 }
@@ -290,6 +419,12 @@ void IonConnectESP32::setAccessToken(const String& token) {
     securityManager->setAccessToken(token);
 }
 
+#if ION_ENABLE_PLUGINS
+bool IonConnectESP32::registerPlugin(IonPlugin* plugin) {
+    return pluginRegistry->registerPlugin(plugin);
+}
+#endif
+
 #if ION_ENABLE_DIAGNOSTICS
 DiagnosticsData IonConnectESP32::getDiagnostics() {
     if (diagnostics) {
@@ -355,9 +490,9 @@ String IonConnectESP32::generateAPSSID() {
 }
 
 void IonConnectESP32::loadDefaultSchema() {
-    if (configManager->getFields().size() == 0) {
+    if (configManager->getFieldCount() == 0) {
         ION_LOG("Loading default schema");
-        configManager->loadSchema(DEFAULT_SCHEMA);
+        configManager->loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA);
     }
 }
 
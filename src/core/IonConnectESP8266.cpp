@@ -11,8 +11,10 @@ IonConnectESP8266::IonConnectESP8266()
     : initialized(false), portalActive(false), portalStartTime(0), portalTimeout(0) {
     
     storage = new StorageEEPROM();
+    commitWorker = nullptr;
     configManager = new ConfigManager(storage);
     wifiCore = new WiFiConnectionCore(configManager);
+    scoringPolicy = nullptr;
     securityManager = new SecurityManager();
     webPortal = new WebPortal(configManager, wifiCore, securityManager);
     
@@ -20,18 +22,28 @@ IonConnectESP8266::IonConnectESP8266()
     diagnostics = new DiagnosticsCollector();
     webPortal->setDiagnosticsCollector(diagnostics);
     #endif
+    
+    #if ION_ENABLE_PLUGINS
+    pluginRegistry = new PluginRegistry();
+    #endif
 }
 
 IonConnectESP8266::~IonConnectESP8266() {
     delete webPortal;
     delete securityManager;
     delete wifiCore;
+    delete scoringPolicy;
     delete configManager;
+    delete commitWorker;        // Commits anything still requested
     delete storage;
     
     #if ION_ENABLE_DIAGNOSTICS
     delete diagnostics;
     #endif
+    
+    #if ION_ENABLE_PLUGINS
+    delete pluginRegistry;
+    #endif
 }
 
 bool IonConnectESP8266::init(const char* name, const IonConfig& cfg) {
@@ -46,16 +58,45 @@ bool IonConnectESP8266::init(const char* name, const IonConfig& cfg) {
     ION_LOG("Initializing IonConnect for ESP8266");
     ION_LOG("Device: %s", deviceName.c_str());
     
+    // Switch to LittleFS storage if requested
+    if (config.storageBackend == STORAGE_LITTLEFS) {
+        #if ION_USE_LITTLEFS
+        if (LittleFS.begin()) {
+            delete storage;
+            storage = new StorageLittleFS();
+            configManager->setStorage(storage);
+            webPortal->setKeepFilesystemMounted(true);
+        } else {
+            ION_LOG_W("LittleFS mount failed, using EEPROM");
+        }
+        #else
+        ION_LOG_W("LittleFS disabled, using EEPROM");
+        #endif
+    }
+    
     // Initialize storage
     if (!storage->begin()) {
         ION_LOG_E("Failed to initialize storage");
         return false;
     }
     
+    // Commit worker: no tasks here, handle() runs the commits
+    if (config.asyncCommit) {
+        commitWorker = new CommitWorker(storage, false);
+        commitWorker->onComplete([this](bool success) {
+            if (portalActive) {
+                webPortal->broadcastCommit(success);
+            }
+        });
+        commitWorker->begin();
+        configManager->setCommitWorker(commitWorker);
+    }
+    
     // Load default schema if no custom schema loaded
     loadDefaultSchema();
     
     // Load configuration
+    configManager->setCommitDelay(config.configCommitDelayMs);
     configManager->load();
     
     // Setup security
@@ -70,6 +111,13 @@ bool IonConnectESP8266::init(const char* name, const IonConfig& cfg) {
     wifiCore->setMaxReconnectAttempts(config.maxReconnectAttempts);
     wifiCore->setReconnectDelay(config.reconnectDelayMs);
     wifiCore->setConnectionTimeout(config.connectionTimeoutMs);
+    wifiCore->setIPDefaults(config.ipMode, config.staticIP);
+    if (config.networkScoring == SCORING_RSSI) {
+        scoringPolicy = new RSSIScoringPolicy();
+    } else {
+        scoringPolicy = new WeightedScoringPolicy();
+    }
+    wifiCore->setScoringPolicy(scoringPolicy, config.scoringHysteresis);
     
     // Register WiFi callbacks
     wifiCore->onConnect([this]() {
@@ -78,11 +126,17 @@ bool IonConnectESP8266::init(const char* name, const IonConfig& cfg) {
             webPortal->broadcastStatus("connected", wifiCore->getSSID(), 
                                       wifiCore->getIP().toString());
         }
+        #if ION_ENABLE_PLUGINS
+        pluginRegistry->notifyWiFiConnect();
+        #endif
         if (connectCallback) connectCallback();
     });
     
     wifiCore->onDisconnect([this]() {
         ION_LOG("WiFi disconnected");
+        #if ION_ENABLE_PLUGINS
+        pluginRegistry->notifyWiFiDisconnect();
+        #endif
         if (disconnectCallback) disconnectCallback();
     });
     
@@ -112,6 +166,13 @@ bool IonConnectESP8266::begin() {
     // Load saved networks
     wifiCore->loadNetworks();
     
+    #if ION_ENABLE_PLUGINS
+    // Start plugins: config events are filtered by each plugin's interest
+    pluginRegistry->initAll(this);
+    pluginRegistry->subscribeAll(configManager);
+    pluginRegistry->registerAllRoutes(webPortal->getServer());
+    #endif
+    
     // Check if we have credentials
     String ssid = configManager->get("wifi_ssid");
     
@@ -136,6 +197,16 @@ void IonConnectESP8266::handle() {
     // Handle WiFi state machine
     wifiCore->handle();
     
+    // Deliver config change events, write coalesced changes
+    configManager->handle();
+    if (commitWorker) {
+        commitWorker->step();
+    }
+    
+    #if ION_ENABLE_PLUGINS
+    pluginRegistry->handleAll();
+    #endif
+    
     // Handle web portal
     if (portalActive) {
         webPortal->handle();
@@ -179,6 +250,11 @@ bool IonConnectESP8266::startPortal(uint32_t timeoutSeconds) {
     portalStartTime = millis();
     portalTimeout = timeoutSeconds * 1000;
     
+    // Network list ready by the time the page opens
+    if (wifiCore->getScanAge() > WiFiConnectionCore::SCAN_CACHE_TTL) {
+        wifiCore->startScan();
+    }
+    
     IPAddress ip = WiFi.softAPIP();
     ION_LOG("Portal started: %s", ip.toString().c_str());
     ION_LOG("SSID: %s", generateAPSSID().c_str());
@@ -212,10 +288,46 @@ bool IonConnectESP8266::setConfig(const String& key, const String& value) {
     return configManager->set(key, value);
 }
 
+int32_t IonConnectESP8266::getConfigInt(const String& key, int32_t defaultValue) {
+    return configManager->getInt(key, defaultValue);
+}
+
+bool IonConnectESP8266::getConfigBool(const String& key, bool defaultValue) {
+    return configManager->getBool(key, defaultValue);
+}
+
+float IonConnectESP8266::getConfigFloat(const String& key, float defaultValue) {
+    return configManager->getFloat(key, defaultValue);
+}
+
+bool IonConnectESP8266::setConfigInt(const String& key, int32_t value) {
+    return configManager->setInt(key, value);
+}
+
+bool IonConnectESP8266::setConfigBool(const String& key, bool value) {
+    return configManager->setBool(key, value);
+}
+
+bool IonConnectESP8266::setConfigFloat(const String& key, float value) {
+    return configManager->setFloat(key, value);
+}
+
+ConfigHandle IonConnectESP8266::getConfigHandle(const String& key) {
+    return configManager->getHandle(key);
+}
+
+ConfigTransaction IonConnectESP8266::beginConfigTransaction() {
+    return configManager->beginTransaction();
+}
+
 bool IonConnectESP8266::loadConfigSchema(const char* jsonSchema) {
     return configManager->loadSchema(jsonSchema);
 }
 
+bool IonConnectESP8266::loadConfigSchema(const ConfigField* table, size_t count, const char* jsonSchema) {
+    return configManager->loadSchema(table, count, jsonSchema);
+}
+
 String IonConnectESP8266::exportConfig() {
     return configManager->exportJSON();
 }
@@ -228,6 +340,10 @@ bool IonConnectESP8266::clearConfig() {
     return configManager->clear();
 }
 
+bool IonConnectESP8266::flushConfig() {
+    return configManager->flush();
+}
+
 bool IonConnectESP8266::connect() {
     String ssid = configManager->get("wifi_ssid");
     String pass = configManager->get("wifi_pass");
@@ -256,6 +372,10 @@ bool IonConnectESP8266::addNetwork(const String& ssid, const String& pass, int p
     return wifiCore->addNetwork(ssid, pass, priority);
 }
 
+bool IonConnectESP8266::setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings) {
+    return wifiCore->setNetworkIP(ssid, mode, settings);
+}
+
 void IonConnectESP8266::onConnect(std::function<void()> cb) {
     connectCallback = cb;
 }
@@ -268,6 +388,14 @@ void IonConnectESP8266::onConfigSaved(std::function<void()> cb) {
     configSavedCallback = cb;
 }
 
+void IonConnectESP8266::onConfigChange(const char* keys, std::function<void(const String&, const String&)> cb) {
+    configManager->onChange(keys, cb);
+}
+
+void IonConnectESP8266::onConfigMigration(std::function<void(uint32_t, uint32_t)> cb) {
+    configManager->onSchemaMigration(cb);
+}
+
 void IonConnectESP8266::onPortalStart(std::function<void()> cb) {
     portalStartCallback = cb;
 }
@@ -290,6 +418,12 @@ void IonConnectESP8266::setAccessToken(const String& token) {
     securityManager->setAccessToken(token);
 }
 
+#if ION_ENABLE_PLUGINS
+bool IonConnectESP8266::registerPlugin(IonPlugin* plugin) {
+    return pluginRegistry->registerPlugin(plugin);
+}
+#endif
+
 #if ION_ENABLE_DIAGNOSTICS
 DiagnosticsData IonConnectESP8266::getDiagnostics() {
     if (diagnostics) {
@@ -355,9 +489,9 @@ String IonConnectESP8266::generateAPSSID() {
 }
 
 void IonConnectESP8266::loadDefaultSchema() {
-    if (configManager->getFields().size() == 0) {
+    if (configManager->getFieldCount() == 0) {
         ION_LOG("Loading default schema");
-        configManager->loadSchema(DEFAULT_SCHEMA);
+        configManager->loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA);
     }
 }
 
@@ -6,7 +6,9 @@
 #if ION_PLATFORM_ESP8266
 
 #include "../storage/StorageEEPROM.h"
+#include "../storage/StorageLittleFS.h"
 #include "../modules/ConfigManager.h"
+#include "../modules/CommitWorker.h"
 #include "../modules/WiFiConnectionCore.h"
 #include "../modules/SecurityManager.h"
 #include "../modules/WebPortal.h"
@@ -15,6 +17,10 @@
 #include "../modules/DiagnosticsCollector.h"
 #endif
 
+#if ION_ENABLE_PLUGINS
+#include "../modules/PluginRegistry.h"
+#endif
+
 #include <ESP8266WiFi.h>
 
 namespace IonConnect {
@@ -41,10 +47,20 @@ public:
     // Configuration
     String getConfig(const String& key) override;
     bool setConfig(const String& key, const String& value) override;
+    int32_t getConfigInt(const String& key, int32_t defaultValue = 0) override;
+    bool getConfigBool(const String& key, bool defaultValue = false) override;
+    float getConfigFloat(const String& key, float defaultValue = 0.0f) override;
+    bool setConfigInt(const String& key, int32_t value) override;
+    bool setConfigBool(const String& key, bool value) override;
+    bool setConfigFloat(const String& key, float value) override;
+    ConfigHandle getConfigHandle(const String& key) override;
+    ConfigTransaction beginConfigTransaction() override;
     bool loadConfigSchema(const char* jsonSchema) override;
+    bool loadConfigSchema(const ConfigField* table, size_t count, const char* jsonSchema) override;
     String exportConfig() override;
     bool importConfig(const String& json) override;
     bool clearConfig() override;
+    bool flushConfig() override;
     
     // WiFi Management
     bool connect() override;
@@ -52,11 +68,14 @@ public:
     bool isConnected() override;
     WiFiState getStatus() override;
     bool addNetwork(const String& ssid, const String& pass, int priority = 0) override;
+    bool setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings = IPSettings()) override;
     
     // Event Callbacks
     void onConnect(std::function<void()> cb) override;
     void onDisconnect(std::function<void()> cb) override;
     void onConfigSaved(std::function<void()> cb) override;
+    void onConfigChange(const char* keys, std::function<void(const String&, const String&)> cb) override;
+    void onConfigMigration(std::function<void(uint32_t, uint32_t)> cb) override;
     void onPortalStart(std::function<void()> cb) override;
     void onPortalTimeout(std::function<void()> cb) override;
     void onError(std::function<void(IonError, const char*)> cb) override;
@@ -65,6 +84,11 @@ public:
     void setPortalPassword(const String& password) override;
     void setAccessToken(const String& token) override;
     
+#if ION_ENABLE_PLUGINS
+    // Plugins
+    bool registerPlugin(IonPlugin* plugin) override;
+#endif
+    
 #if ION_ENABLE_DIAGNOSTICS
     // Diagnostics
     DiagnosticsData getDiagnostics() override;
@@ -80,9 +104,11 @@ private:
     uint32_t portalTimeout;
     
     // Core modules
-    StorageEEPROM* storage;
+    StorageProvider* storage;
+    CommitWorker* commitWorker;
     ConfigManager* configManager;
     WiFiConnectionCore* wifiCore;
+    ScoringPolicy* scoringPolicy;
     SecurityManager* securityManager;
     WebPortal* webPortal;
     
@@ -90,6 +116,10 @@ private:
     DiagnosticsCollector* diagnostics;
     #endif
     
+    #if ION_ENABLE_PLUGINS
+    PluginRegistry* pluginRegistry;
+    #endif
+    
     // Callbacks
     std::function<void()> connectCallback;
     std::function<void()> disconnectCallback;
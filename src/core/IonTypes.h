@@ -2,6 +2,7 @@
 #define ION_TYPES_H
 
 #include <Arduino.h>
+#include <IPAddress.h>
 #include <functional>
 
 // Platform detection
@@ -82,6 +83,32 @@
     #endif
 #endif
 
+// Store non-schema config keys as a compact binary snapshot instead of JSON
+// text. On by default where everything shares the 4 KB EEPROM image.
+#ifndef ION_BINARY_CONFIG
+    #if ION_PLATFORM_ESP8266
+        #define ION_BINARY_CONFIG 1
+    #else
+        #define ION_BINARY_CONFIG 0
+    #endif
+#endif
+
+// Keep two copies of the non-schema config blob and switch to a new one only
+// once it is stored. StorageEEPROM already double-buffers its whole image.
+#ifndef ION_CONFIG_AB
+    #if ION_PLATFORM_ESP8266
+        #define ION_CONFIG_AB 0
+    #else
+        #define ION_CONFIG_AB 1
+    #endif
+#endif
+
+// Flash sector for StorageEEPROM's second slot (ESP8266). 0 picks the unused
+// sector below EEPROM when the flash layout has one; set it if yours doesn't.
+#ifndef ION_EEPROM_BACKUP_SECTOR
+    #define ION_EEPROM_BACKUP_SECTOR 0
+#endif
+
 #ifndef ION_USE_ASYNC_WEBSERVER
     #if ION_MINIMAL_MODE
         #define ION_USE_ASYNC_WEBSERVER 0  // Use basic ESP8266WebServer for minimal mode
@@ -109,6 +136,15 @@
     #define ION_MAX_CONFIG_FIELDS 32
 #endif
 
+// Buffers per size class in the shared JSON document pool (see JsonPool)
+#ifndef ION_JSON_POOL_SLOTS
+    #if ION_MINIMAL_MODE
+        #define ION_JSON_POOL_SLOTS 1
+    #else
+        #define ION_JSON_POOL_SLOTS 2
+    #endif
+#endif
+
 namespace IonConnect {
 
 // WiFi States
@@ -122,6 +158,46 @@ enum WiFiState {
     WIFI_DISCONNECTED
 };
 
+// Where settings are persisted (IonConfig::storageBackend)
+enum StorageBackend : uint8_t {
+    STORAGE_DEFAULT,        // NVS on ESP32, EEPROM on ESP8266
+    STORAGE_LITTLEFS        // Files on LittleFS, for configs too large for the default
+};
+
+// How saved networks in range are ranked (IonConfig::networkScoring)
+enum NetworkScoring : uint8_t {
+    SCORING_WEIGHTED,       // RSSI, priority and connection history (WeightedScoringPolicy)
+    SCORING_RSSI            // Strongest signal only
+};
+
+// How a network gets its IP configuration (WiFiCredential::ipMode)
+enum IPMode : uint8_t {
+    IP_DEFAULT,             // IonConfig::ipMode
+    IP_DHCP,
+    IP_STATIC,              // The network's IPSettings
+    IP_CACHED_LEASE         // Last DHCP lease applied at once, renewed once connected
+};
+
+// IPv4 settings of a network: static addresses or a cached lease
+struct IPSettings {
+    IPAddress ip;
+    IPAddress gateway;
+    IPAddress subnet;
+    IPAddress dns;
+    
+    bool isSet() const { return (uint32_t)ip != 0; }
+};
+
+// Schema field input types (ConfigField::inputType)
+enum FieldType : uint8_t {
+    FIELD_TEXT,
+    FIELD_PASSWORD,
+    FIELD_NUMBER,
+    FIELD_CHECKBOX,
+    FIELD_SELECT,
+    FIELD_OTHER             // email, url, ...: handled as text
+};
+
 // Error codes
 enum IonError {
     ION_OK = 0,
@@ -140,8 +216,17 @@ struct WiFiCredential {
     String ssid;
     String password;
     int8_t priority = 0;        // Higher = preferred
-    uint32_t lastConnected = 0; // Timestamp
+    uint32_t lastConnected = 0; // Join sequence number, highest = joined last (0 = never)
     int8_t lastRSSI = 0;
+    uint8_t channel = 0;        // Of the last good association (0 = unknown)
+    uint8_t bssid[6] = {0};
+    IPMode ipMode = IP_DEFAULT;
+    IPSettings ipSettings;      // Static addresses, or the cached lease
+    uint8_t attempts = 0;       // Recent connection attempts (halved when the window fills)
+    uint8_t successes = 0;      // Of those, ones that joined and stayed up
+    uint16_t connectTime = 0;   // Average time to join, ms
+    uint8_t failStreak = 0;     // Failures since the last success (not saved)
+    uint32_t lastFailure = 0;   // millis() of the last failure (not saved)
     
     WiFiCredential() {}
     WiFiCredential(const String& s, const String& p, int8_t prio = 0) 
@@ -151,9 +236,11 @@ struct WiFiCredential {
 // Network scan result
 struct NetworkInfo {
     String ssid;
-    int8_t rssi;
+    int8_t rssi;                // Averaged over recent scans
     uint8_t encryption;
     uint8_t channel;
+    uint8_t bssid[6] = {0};
+    uint32_t lastSeen = 0;      // millis() of the last scan that saw it
     
     NetworkInfo() : rssi(0), encryption(0), channel(0) {}
     NetworkInfo(const String& s, int8_t r, uint8_t e, uint8_t c) 
@@ -161,27 +248,29 @@ struct NetworkInfo {
 };
 
 // Config field definition
+//
+// Plain descriptor so schemas can be compiled into PROGMEM tables
+// (see tools/web_builder/build_schema.py). String members are views and are
+// never owned: compiled schemas point them at flash, runtime schemas at the
+// parsed schema document. Read them through the *_P helpers (strcmp_P, FPSTR)
+// so both cases work on ESP8266. Member order is part of the generator format.
 struct ConfigField {
-    String id;
-    String label;
-    String type;
-    String defaultValue;
-    String placeholder;
-    bool required = false;
-    bool encrypted = false;
-    int minLength = 0;
-    int maxLength = 0;
-    int min = 0;
-    int max = 0;
-    String pattern;
-    String visibleIf;
-    String* options = nullptr;
-    size_t optionsCount = 0;
-    
-    ConfigField() {}
-    ~ConfigField() {
-        if (options) delete[] options;
-    }
+    const char* id;
+    const char* label;
+    const char* type;
+    const char* defaultValue;
+    const char* placeholder;
+    const char* pattern;
+    const char* visibleIf;
+    const char* const* options;
+    size_t optionsCount;
+    int minLength;
+    int maxLength;
+    int min;
+    int max;
+    bool required;
+    bool encrypted;
+    FieldType inputType;    // Parsed `type`, so hot paths never compare strings
 };
 
 #if ION_ENABLE_DIAGNOSTICS
@@ -191,6 +280,8 @@ struct DiagnosticsData {
     uint32_t heapFree = 0;
     uint32_t heapSize = 0;
     uint32_t heapMinFree = 0;
+    uint8_t jsonPoolPeak = 0;       // Most JSON buffers leased at once
+    uint32_t jsonPoolFallbacks = 0; // JSON documents that missed the pool
     
     // WiFi
     int8_t rssi = 0;
@@ -202,6 +293,11 @@ struct DiagnosticsData {
     uint32_t cpuFreq = 0;
     float cpuLoad = 0.0f;
     
+    // Storage (NVS on ESP32; 0 elsewhere)
+    uint32_t storageWrites = 0;     // Items written or erased
+    uint32_t storageWriteBytes = 0;
+    uint32_t storageCommits = 0;
+    
     // Application
     uint32_t apiRequests = 0;
     uint32_t apiErrors = 0;
@@ -3,6 +3,7 @@
 #if ION_PLATFORM_ESP32 && ION_ENABLE_BLE
 
 #include "../utils/Logger.h"
+#include "../utils/JsonPool.h"
 #include <ArduinoJson.h>
 
 namespace IonConnect {
@@ -117,7 +118,7 @@ void BLEHandler::onWrite(BLECharacteristic* pCharacteristic) {
 void BLEHandler::handleConfigWrite(const String& json) {
     ION_LOG("BLE config received");
     
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE);
     DeserializationError error = deserializeJson(doc, json);
     
     if (error) {
@@ -128,20 +129,25 @@ void BLEHandler::handleConfigWrite(const String& json) {
     
     JsonObject root = doc.as<JsonObject>();
     
-    // Save each field
+    // Stage every field, then validate and save them together
+    ConfigTransaction tx = config->beginTransaction();
     for (JsonPair kv : root) {
-        config->set(kv.key().c_str(), kv.value().as<String>());
+        tx.set(kv.key().c_str(), kv.value().as<String>());
     }
     
-    // Validate
-    if (!config->validate()) {
-        notifyStatus("{\"status\":\"error\",\"message\":\"Validation failed\"}");
-        return;
-    }
-    
-    // Save to storage
-    if (!config->save()) {
-        notifyStatus("{\"status\":\"error\",\"message\":\"Failed to save\"}");
+    if (!tx.commit()) {
+        if (!tx.failedKey().isEmpty()) {
+            // The key comes from the client and may need escaping
+            PooledJsonDocument reply(96 + tx.failedKey().length());
+            reply["status"] = "error";
+            reply["message"] = "Validation failed";
+            reply["field"] = tx.failedKey();
+            String status;
+            serializeJson(reply, status);
+            notifyStatus(status);
+        } else {
+            notifyStatus("{\"status\":\"error\",\"message\":\"Failed to save\"}");
+        }
         return;
     }
     
@@ -157,7 +163,12 @@ void BLEHandler::handleConfigWrite(const String& json) {
     String pass = config->get("wifi_pass");
     
     if (!ssid.isEmpty()) {
-        notifyStatus("{\"status\":\"connecting\",\"ssid\":\"" + ssid + "\"}");
+        PooledJsonDocument reply(96 + ssid.length());
+        reply["status"] = "connecting";
+        reply["ssid"] = ssid;
+        String status;
+        serializeJson(reply, status);
+        notifyStatus(status);
         wifi->connect(ssid, pass);
     }
 }
@@ -165,7 +176,7 @@ void BLEHandler::handleConfigWrite(const String& json) {
 void BLEHandler::handleControlCommand(const String& cmd) {
     ION_LOG("BLE control: %s", cmd.c_str());
     
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
     DeserializationError error = deserializeJson(doc, cmd);
     
     if (error) {
@@ -176,14 +187,15 @@ void BLEHandler::handleControlCommand(const String& cmd) {
     String command = doc["command"] | "";
     
     if (command == "scan") {
-        wifi->startScan();
-        notifyStatus("{\"status\":\"scanning\"}");
-        
-        // Wait for scan to complete
-        delay(3000);
+        // Recent results are sent at once; otherwise scan and wait
+        if (wifi->getScanAge() > WiFiConnectionCore::SCAN_CACHE_TTL) {
+            wifi->startScan();
+            notifyStatus("{\"status\":\"scanning\"}");
+            delay(3000);
+        }
         
-        auto networks = wifi->getScanResults();
-        DynamicJsonDocument resultDoc(ION_JSON_BUFFER_SIZE);
+        std::vector<NetworkInfo> networks = wifi->getScanResults();
+        PooledJsonDocument resultDoc(ION_JSON_BUFFER_SIZE);
         JsonArray arr = resultDoc["networks"].to<JsonArray>();
         
         for (const auto& net : networks) {
@@ -207,11 +219,12 @@ void BLEHandler::handleControlCommand(const String& cmd) {
         
     } else if (command == "reboot") {
         notifyStatus("{\"status\":\"rebooting\"}");
+        config->flush();
         delay(1000);
         ESP.restart();
         
     } else if (command == "clear") {
-        config->clear();
+        config->clearAsync();
         notifyStatus("{\"status\":\"cleared\"}");
     }
 }
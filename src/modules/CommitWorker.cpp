@@ -0,0 +1,149 @@
+#include "CommitWorker.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+// request() and isBusy() are called from the loop and the web/BLE tasks
+// while the commit task updates the same flags
+#if ION_PLATFORM_ESP32
+    #define WORKER_LOCK()   xSemaphoreTake(lock, portMAX_DELAY)
+    #define WORKER_UNLOCK() xSemaphoreGive(lock)
+#else
+    #define WORKER_LOCK()
+    #define WORKER_UNLOCK()
+#endif
+
+CommitWorker::CommitWorker(StorageProvider* storage, bool threaded)
+    : storage(storage), threaded(threaded), requested(false), running(false) {
+    #if ION_PLATFORM_ESP32
+    task = nullptr;
+    exited = xSemaphoreCreateBinary();
+    lock = xSemaphoreCreateMutex();
+    stopping = false;
+    #else
+    // No tasks to hand the work to; step() runs it from loop()
+    this->threaded = false;
+    #endif
+}
+
+CommitWorker::~CommitWorker() {
+    end();
+    
+    #if ION_PLATFORM_ESP32
+    vSemaphoreDelete(exited);
+    vSemaphoreDelete(lock);
+    #endif
+}
+
+bool CommitWorker::begin() {
+    #if ION_PLATFORM_ESP32
+    if (threaded && !task) {
+        stopping = false;
+        if (xTaskCreate(taskMain, "ion_commit", TASK_STACK, this, TASK_PRIORITY, &task) != pdPASS) {
+            task = nullptr;
+            threaded = false;
+            ION_LOG_W("Commit task not started, committing from loop()");
+        }
+    }
+    #endif
+    
+    return true;
+}
+
+void CommitWorker::end() {
+    #if ION_PLATFORM_ESP32
+    if (task) {
+        // The task finishes its commit and gives `exited` just before it
+        // deletes itself; nothing of this object is used after that
+        WORKER_LOCK();
+        stopping = true;
+        WORKER_UNLOCK();
+        xTaskNotifyGive(task);
+        xSemaphoreTake(exited, portMAX_DELAY);
+        task = nullptr;
+    }
+    #endif
+    
+    if (requested) {
+        run();
+    }
+}
+
+void CommitWorker::request() {
+    WORKER_LOCK();
+    requested = true;
+    WORKER_UNLOCK();
+    
+    #if ION_PLATFORM_ESP32
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    #endif
+}
+
+void CommitWorker::step() {
+    #if ION_PLATFORM_ESP32
+    if (task) {
+        return;
+    }
+    #endif
+    
+    if (requested) {
+        run();
+    }
+}
+
+bool CommitWorker::isBusy() {
+    WORKER_LOCK();
+    bool busy = requested || running;
+    WORKER_UNLOCK();
+    return busy;
+}
+
+void CommitWorker::onComplete(CompleteCallback callback) {
+    completeCallback = callback;
+}
+
+void CommitWorker::run() {
+    // Cleared first: a request() during the commit gets a commit of its own
+    WORKER_LOCK();
+    requested = false;
+    running = true;
+    WORKER_UNLOCK();
+    
+    uint32_t start = millis();
+    bool success = storage->commit();
+    ION_LOG("Storage commit %s in %lu ms", success ? "done" : "failed",
+            (unsigned long)(millis() - start));
+    
+    WORKER_LOCK();
+    running = false;
+    WORKER_UNLOCK();
+    if (completeCallback) {
+        completeCallback(success);
+    }
+}
+
+#if ION_PLATFORM_ESP32
+void CommitWorker::taskMain(void* arg) {
+    CommitWorker* worker = (CommitWorker*)arg;
+    bool stop = false;
+    
+    while (!stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(worker->lock, portMAX_DELAY);
+        bool work = worker->requested;
+        stop = worker->stopping;
+        xSemaphoreGive(worker->lock);
+        
+        if (work) {
+            worker->run();
+        }
+    }
+    
+    xSemaphoreGive(worker->exited);
+    vTaskDelete(nullptr);
+}
+#endif
+
+} // namespace IonConnect
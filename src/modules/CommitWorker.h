@@ -0,0 +1,67 @@
+#ifndef COMMIT_WORKER_H
+#define COMMIT_WORKER_H
+
+#include <Arduino.h>
+#include <functional>
+#include "../core/IonTypes.h"
+#include "../storage/StorageProvider.h"
+
+#if ION_PLATFORM_ESP32
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <freertos/semphr.h>
+#endif
+
+namespace IonConnect {
+
+/**
+ * @brief Runs storage commits outside the caller's context
+ * 
+ * Web and BLE handlers stage their writes in the storage provider's RAM
+ * queue and call request(); the flash erase/program cycle then happens here
+ * instead of on the network task. Threaded, it is a low-priority FreeRTOS
+ * task (ESP32 with NVS, which is safe to write from several tasks);
+ * otherwise step() runs the commit from loop(). Requests made while a commit
+ * is running are folded into one more commit.
+ */
+class CommitWorker {
+public:
+    typedef std::function<void(bool success)> CompleteCallback;
+    
+    CommitWorker(StorageProvider* storage, bool threaded);
+    ~CommitWorker();
+    
+    bool begin();
+    void end();                 // Stops the task, then commits what is left
+    void request();             // Commit soon; returns at once
+    void step();                // Call from loop() when not threaded
+    bool isBusy();              // Requested or running
+    
+    // Called after each commit, from the task when threaded
+    void onComplete(CompleteCallback callback);
+    
+private:
+    StorageProvider* storage;
+    bool threaded;
+    bool requested;             // Under `lock` on ESP32, with `running`
+    bool running;
+    CompleteCallback completeCallback;
+    
+    #if ION_PLATFORM_ESP32
+    static const uint32_t TASK_STACK = 4096;
+    static const UBaseType_t TASK_PRIORITY = 1;     // Above idle, below the network
+    
+    TaskHandle_t task;                  // Set and cleared by begin()/end() only
+    SemaphoreHandle_t exited;           // Given by the task as it ends
+    SemaphoreHandle_t lock;             // Guards the flags shared with the task
+    bool stopping;
+    
+    static void taskMain(void* arg);
+    #endif
+    
+    void run();
+};
+
+} // namespace IonConnect
+
+#endif // COMMIT_WORKER_H
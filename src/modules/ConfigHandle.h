@@ -0,0 +1,55 @@
+#ifndef CONFIG_HANDLE_H
+#define CONFIG_HANDLE_H
+
+#include <Arduino.h>
+#include "../core/IonTypes.h"
+
+namespace IonConnect {
+
+class ConfigManager;
+
+/**
+ * @brief Pre-resolved reference to a schema field
+ *
+ * Bind once (e.g. in setup()) and read in hot loops without key lookup,
+ * hashing or String temporaries:
+ *
+ *   ConfigHandle host = ion.getConfigHandle("mqtt_host");
+ *   ...
+ *   client.connect(host.c_str());
+ *
+ * A handle becomes invalid when a different schema is loaded.
+ */
+class ConfigHandle {
+public:
+    ConfigHandle() : manager(nullptr), index(-1), generation(0) {}
+
+    bool isValid() const;
+    const ConfigField* field() const;
+
+    const String& get() const;          // Cached value, O(1)
+    const char* c_str() const { return get().c_str(); }
+    bool set(const String& value);
+    
+    // Native values, cached at load/set time - no parsing on read
+    int32_t getInt() const;
+    bool getBool() const;
+    float getFloat() const;
+    bool setInt(int32_t value);
+    bool setBool(bool value);
+    bool setFloat(float value);
+
+private:
+    friend class ConfigManager;
+
+    ConfigHandle(ConfigManager* manager, int16_t index, uint16_t generation)
+        : manager(manager), index(index), generation(generation) {}
+
+    ConfigManager* manager;
+    int16_t index;
+    uint16_t generation;
+};
+
+} // namespace IonConnect
+
+#endif // CONFIG_HANDLE_H
@@ -1,6 +1,8 @@
 #include "ConfigManager.h"
+#include "CommitWorker.h"
 #include "../utils/Logger.h"
 #include "../utils/Crypto.h"
+#include "../utils/Hash.h"
 
 #if ION_USE_LITTLEFS
     #include <LittleFS.h>
@@ -12,31 +14,149 @@
 namespace IonConnect {
 
 const char* ConfigManager::KEY_CONFIG_DATA = "config_data";
+const char* ConfigManager::KEY_CONFIG_SNAPSHOT = "config_bin";
 const char* ConfigManager::KEY_SCHEMA_VERSION = "schema_ver";
+const char* ConfigManager::KEY_CONFIG_VALID = "cfg_valid";
+const char* ConfigManager::KEY_CONFIG_SLOT = "cfg_slot";
+
+static_assert(ION_MAX_CONFIG_FIELDS <= 32, "Dirty tracking uses a 32-bit mask");
+
+// strcmp for two strings that may both live in flash
+static int strcmpPP(const char* a, const char* b) {
+    uint8_t ca, cb;
+    do {
+        ca = pgm_read_byte(a++);
+        cb = pgm_read_byte(b++);
+    } while (ca && ca == cb);
+    return (int)ca - (int)cb;
+}
+
+// Strict base-10 int32 parse: the whole string must be a number
+static bool parseInt32(const String& text, int32_t& out) {
+    const char* p = text.c_str();
+    bool negative = (*p == '-');
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+    if (!*p) {
+        return false;
+    }
+    
+    int64_t value = 0;
+    for (; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+        if (value > (int64_t)INT32_MAX + 1) {
+            return false;
+        }
+    }
+    
+    value = negative ? -value : value;
+    if (value > INT32_MAX) {
+        return false;
+    }
+    out = (int32_t)value;
+    return true;
+}
+
+static bool parseBool(const String& text, bool& out) {
+    if (text == "true" || text == "1" || text == "on") {
+        out = true;
+    } else if (text == "false" || text == "0" || text == "off") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Shortest fixed-point form, e.g. 23.5 rather than 23.500000
+static String formatFloat(float value) {
+    String text(value, 6);
+    if (text.indexOf('.') >= 0) {
+        while (text.endsWith("0")) {
+            text.remove(text.length() - 1);
+        }
+        if (text.endsWith(".")) {
+            text.remove(text.length() - 1);
+        }
+    }
+    return text;
+}
 
 ConfigManager::ConfigManager(StorageProvider* storage) 
-    : storage(storage), schemaDoc(ION_JSON_SCHEMA_SIZE), configDoc(ION_JSON_CONFIG_SIZE), schemaLoaded(false), configLoaded(false) {
+    : storage(storage), commitWorker(nullptr), schemaDoc(nullptr), configDoc(ION_JSON_CONFIG_SIZE), schemaJson(nullptr),
+      fieldArena(nullptr), schemaGeneration(0), dirtyMask(0), extrasDirty(false), recordsDirty(false),
+      savePending(false), saveRequestedAt(0), commitDelay(0), changedMask(0),
+      schemaFingerprint(0), storedFingerprint(0), validity(VALIDITY_UNKNOWN), validStored(false),
+      schemaLoaded(false), configLoaded(false), extrasLoaded(false), staleBlob(false),
+      extrasGeneration(0) {
 }
 
 ConfigManager::~ConfigManager() {
+    if (isDirty()) {
+        flush();
+    }
     clearFields();
+    delete schemaDoc;
+}
+
+void ConfigManager::setStorage(StorageProvider* provider) {
+    storage = provider;
+}
+
+void ConfigManager::setCommitWorker(CommitWorker* worker) {
+    commitWorker = worker;
 }
 
 bool ConfigManager::loadSchema(const char* jsonSchema) {
-    DeserializationError error = deserializeJson(schemaDoc, jsonSchema);
+    // Parse into a fresh document: the current fields point into the old one
+    DynamicJsonDocument* doc = new DynamicJsonDocument(ION_JSON_SCHEMA_SIZE);
+    DeserializationError error = deserializeJson(*doc, jsonSchema);
     
     if (error) {
         ION_LOG_E("Failed to parse schema: %s", error.c_str());
+        delete doc;
         return false;
     }
     
-    parseSchema();
-    schemaLoaded = true;
+    applySchemaDoc(doc);
     
     ION_LOG("Schema loaded: %d fields", fields.size());
     return true;
 }
 
+bool ConfigManager::loadSchema(const ConfigField* table, size_t count, const char* jsonSchema) {
+    clearFields();
+    delete schemaDoc;
+    schemaDoc = nullptr;
+    schemaJson = jsonSchema;
+    
+    if (count > ION_MAX_CONFIG_FIELDS) {
+        ION_LOG_W("Schema has %d fields, using the first %d", count, ION_MAX_CONFIG_FIELDS);
+        count = ION_MAX_CONFIG_FIELDS;
+    }
+    
+#if ION_PLATFORM_ESP8266
+    // ESP8266 flash only allows aligned 32-bit loads, so copy the descriptors
+    // into RAM once. The strings they point to stay in flash.
+    fieldArena = new uint8_t[sizeof(ConfigField) * count];
+    memcpy_P(fieldArena, table, sizeof(ConfigField) * count);
+    fields.table = reinterpret_cast<const ConfigField*>(fieldArena);
+#else
+    fields.table = table;
+#endif
+    fields.count = count;
+    
+    buildIndex();
+    schemaLoaded = true;
+    
+    ION_LOG("Compiled schema loaded: %d fields", fields.size());
+    return true;
+}
+
 bool ConfigManager::loadSchemaFromFile(const char* filepath) {
 #if ION_USE_LITTLEFS
     if (!LittleFS.begin()) {
@@ -50,16 +170,17 @@ bool ConfigManager::loadSchemaFromFile(const char* filepath) {
         return false;
     }
     
-    DeserializationError error = deserializeJson(schemaDoc, file);
+    DynamicJsonDocument* doc = new DynamicJsonDocument(ION_JSON_SCHEMA_SIZE);
+    DeserializationError error = deserializeJson(*doc, file);
     file.close();
     
     if (error) {
         ION_LOG_E("Failed to parse schema file: %s", error.c_str());
+        delete doc;
         return false;
     }
     
-    parseSchema();
-    schemaLoaded = true;
+    applySchemaDoc(doc);
     
     ION_LOG("Schema loaded from file: %d fields", fields.size());
     return true;
@@ -71,21 +192,42 @@ bool ConfigManager::loadSchemaFromFile(const char* filepath) {
 
 String ConfigManager::getSchemaJSON() {
     String output;
-    serializeJson(schemaDoc, output);
+    if (schemaDoc) {
+        serializeJson(*schemaDoc, output);
+    } else if (schemaJson) {
+        output = FPSTR(schemaJson);
+    }
     return output;
 }
 
-std::vector<ConfigField*> ConfigManager::getFields() {
-    return fields;
+std::vector<const ConfigField*> ConfigManager::getFields() {
+    std::vector<const ConfigField*> list;
+    list.reserve(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        list.push_back(fields[i]);
+    }
+    return list;
 }
 
-ConfigField* ConfigManager::getField(const String& key) {
-    for (auto field : fields) {
-        if (field->id == key) {
-            return field;
-        }
-    }
-    return nullptr;
+size_t ConfigManager::getFieldCount() {
+    return fields.size();
+}
+
+const ConfigField* ConfigManager::getFieldAt(size_t index) {
+    return index < fields.size() ? fields[index] : nullptr;
+}
+
+const ConfigField* ConfigManager::getField(const String& key) {
+    int index = findField(key.c_str());
+    return index >= 0 ? fields[index] : nullptr;
+}
+
+uint32_t ConfigManager::getSchemaFingerprint() {
+    return schemaFingerprint;
+}
+
+void ConfigManager::onSchemaMigration(MigrationCallback callback) {
+    migrationCallback = callback;
 }
 
 bool ConfigManager::load() {
@@ -94,38 +236,291 @@ bool ConfigManager::load() {
         return false;
     }
     
-    String configJson = storage->getString(KEY_CONFIG_DATA, "{}");
+    invalidateCache();
+    configLoaded = true;
+    extrasLoaded = false;
+    
+    // Field records are read on first access. config_data is only parsed
+    // here when the schema changed, since it may then hold fields to adopt.
+    storedFingerprint = storage->getUInt(KEY_SCHEMA_VERSION, 0);
+    validStored = storage->getBool(KEY_CONFIG_VALID, false);
+    bool success = true;
+    if (schemaLoaded && storedFingerprint == schemaFingerprint) {
+        validity = validStored ? VALIDITY_VALID : VALIDITY_UNKNOWN;
+    } else {
+        validity = VALIDITY_UNKNOWN;
+        success = loadExtras();
+        if (schemaLoaded) {
+            checkFingerprint();
+        }
+    }
+    
+    ION_LOG("Config loaded from storage");
+    return success;
+}
+
+bool ConfigManager::loadExtras() {
+    if (!configLoaded) {
+        load();
+    }
+    if (extrasLoaded) {
+        return true;
+    }
+    extrasLoaded = true;
+    
+#if ION_CONFIG_AB
+    extrasGeneration = storage->getUInt(KEY_CONFIG_SLOT, 0);
+#endif
+    
+    // Keys outside the schema (and, from older versions, schema fields that
+    // have not been moved to their own records yet)
+    uint8_t slot = extrasGeneration & 1;
+    bool binary = false;
+    bool success = readExtras(slot, binary);
+    bool repair = false;
+#if ION_CONFIG_AB
+    if (!success) {
+        // The previous copy is only replaced once a new one is stored
+        ION_LOG_W("Stored config damaged, using the previous copy");
+        slot ^= 1;
+        success = readExtras(slot, binary);
+        repair = success;
+    }
+#endif
+    if (!success) {
+        configDoc.clear();
+        configDoc.to<JsonObject>();
+        return false;
+    }
+    
+    // Stored in the other format: rewrite in the configured one
+    char key[BLOB_KEY_SIZE];
+    blobKey(KEY_CONFIG_DATA, slot, key);
+    if (binary != (ION_BINARY_CONFIG != 0) && (binary || storage->exists(key))) {
+        ION_LOG("Converting stored config to %s", ION_BINARY_CONFIG ? "binary" : "JSON");
+        staleBlob = true;
+        repair = true;
+    }
+    if (repair) {
+        extrasDirty = true;
+        save();
+    }
+    return true;
+}
+
+bool ConfigManager::readExtras(uint8_t slot, bool& binary) {
+    char key[BLOB_KEY_SIZE];
+    blobKey(KEY_CONFIG_SNAPSHOT, slot, key);
+    binary = storage->exists(key);
+    if (binary) {
+        return readSnapshot(key);
+    }
+    
+    blobKey(KEY_CONFIG_DATA, slot, key);
+    return readJsonBlob(key);
+}
+
+void ConfigManager::blobKey(const char* base, uint8_t slot, char* key) {
+    // Slot 0 keeps the original key, so single-copy data is read as is
+    snprintf(key, BLOB_KEY_SIZE, slot ? "%s_b" : "%s", base);
+}
+
+bool ConfigManager::readSnapshot(const char* key) {
+    size_t size = storage->getBytesLength(key);
+    uint8_t* data = new uint8_t[size];
+    
+    bool success = storage->getBytes(key, data, size) == size &&
+                   ConfigSnapshot::decode(data, size, configDoc);
+    delete[] data;
     
+    if (!success) {
+        ION_LOG_E("Failed to read stored config snapshot");
+    }
+    return success;
+}
+
+bool ConfigManager::readJsonBlob(const char* key) {
+    String configJson = storage->getString(key, "{}");
     DeserializationError error = deserializeJson(configDoc, configJson);
+    
     if (error) {
         ION_LOG_E("Failed to parse stored config: %s", error.c_str());
-        configDoc.clear();
-        configDoc.to<JsonObject>();
         return false;
     }
+    return true;
+}
+
+bool ConfigManager::writeExtras() {
+#if ION_CONFIG_AB
+    // Write the copy not in use, then point at it: a power cut in between
+    // leaves the pointer on the previous, intact copy
+    uint32_t generation = extrasGeneration + 1;
+#else
+    uint32_t generation = extrasGeneration;
+#endif
+    char key[BLOB_KEY_SIZE];
     
-    configLoaded = true;
-    ION_LOG("Config loaded from storage");
+#if ION_BINARY_CONFIG
+    std::vector<uint8_t> snapshot;
+    ConfigSnapshot::encode(configDoc.as<JsonObjectConst>(), snapshot);
+    blobKey(KEY_CONFIG_SNAPSHOT, generation & 1, key);
+    bool success = storage->putBytes(key, snapshot.data(), snapshot.size());
+    const char* staleKey = KEY_CONFIG_DATA;
+#else
+    String configJson;
+    serializeJson(configDoc, configJson);
+    blobKey(KEY_CONFIG_DATA, generation & 1, key);
+    bool success = storage->putString(key, configJson);
+    const char* staleKey = KEY_CONFIG_SNAPSHOT;
+#endif
+    
+#if ION_CONFIG_AB
+    if (success) {
+        success = storage->putUInt(KEY_CONFIG_SLOT, generation);
+    }
+#endif
+    if (!success) {
+        return false;
+    }
+    extrasGeneration = generation;
+    
+    if (staleBlob) {
+        for (uint8_t slot = 0; slot < 2; slot++) {
+            blobKey(staleKey, slot, key);
+            storage->remove(key);
+        }
+        staleBlob = false;
+    }
     return true;
 }
 
+void ConfigManager::checkFingerprint() {
+    if (storedFingerprint == schemaFingerprint) {
+        return;
+    }
+    
+    // Stored values predate this schema: move any blob fields into records,
+    // bring records to their field's current type, let the application
+    // migrate, then record the new fingerprint
+    loadExtras();
+    adoptBlobFields();
+    convertRecords();
+    
+    ION_LOG("Schema changed (%08lx -> %08lx)", (unsigned long)storedFingerprint,
+            (unsigned long)schemaFingerprint);
+    if (migrationCallback) {
+        migrationCallback(storedFingerprint, schemaFingerprint);
+    }
+    
+    validity = VALIDITY_UNKNOWN;
+    save();
+}
+
 bool ConfigManager::save() {
     if (!storage) {
         ION_LOG_E("Storage not initialized");
         return false;
     }
     
-    String configJson;
-    serializeJson(configDoc, configJson);
+    if (!isDirty()) {
+        return true;
+    }
+    
+    if (commitDelay == 0) {
+        return flushAsync();
+    }
+    
+    // Coalesce: the first save() opens the window, later ones ride along
+    if (!savePending) {
+        savePending = true;
+        saveRequestedAt = millis();
+    }
+    
+    return true;
+}
+
+bool ConfigManager::flush() {
+    return persist(false);
+}
+
+bool ConfigManager::flushAsync() {
+    return persist(true);
+}
+
+bool ConfigManager::persist(bool async) {
+    savePending = false;
+    
+    if (!storage) {
+        ION_LOG_E("Storage not initialized");
+        return false;
+    }
+    
+    if (!isDirty()) {
+        return true;
+    }
     
-    bool success = storage->putString(KEY_CONFIG_DATA, configJson);
+    bool success = true;
+    uint8_t written = 0;
+    
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (!(dirtyMask & (1UL << i))) {
+            continue;
+        }
+        
+        const FieldSlot& slot = slots[i];
+        char key[RECORD_KEY_SIZE];
+        recordKey(i, key);
+        
+        if (!slot.present) {
+            storage->remove(key);
+        } else if (slot.kind == VALUE_INT) {
+            success = storage->putInt(key, slot.intValue) && success;
+        } else if (slot.kind == VALUE_BOOL) {
+            success = storage->putBool(key, slot.boolValue) && success;
+        } else if (fields[i]->encrypted && !slot.value.isEmpty()) {
+            // Raw ciphertext, half the size of the hex text form
+            std::vector<uint8_t> cipher(slot.value.length());
+            Crypto::encryptBytes(slot.value, cipher.data());
+            success = storage->putBytes(key, cipher.data(), cipher.size()) && success;
+        } else {
+            success = storage->putString(key, slot.value) && success;
+        }
+        written++;
+    }
+    
+    if (extrasDirty) {
+        success = writeExtras() && success;
+        written++;
+    }
+    if (recordsDirty) {
+        written++;
+    }
+    
+    // Record what the data was written under, so the next boot can trust it
+    bool valid = validStored;
+    if (schemaLoaded) {
+        valid = validity == VALIDITY_UNKNOWN ? checkRequired() : validity == VALIDITY_VALID;
+        if (storedFingerprint != schemaFingerprint) {
+            success = storage->putUInt(KEY_SCHEMA_VERSION, schemaFingerprint) && success;
+        }
+        if (valid != validStored) {
+            success = storage->putBool(KEY_CONFIG_VALID, valid) && success;
+        }
+    }
     
     if (success) {
-        success = storage->commit();
+        success = commitStorage(async);
     }
     
     if (success) {
-        ION_LOG("Config saved to storage");
+        dirtyMask = 0;
+        extrasDirty = false;
+        recordsDirty = false;
+        if (schemaLoaded) {
+            storedFingerprint = schemaFingerprint;
+        }
+        validStored = valid;
+        ION_LOG("Config saved to storage (%d keys)", written);
     } else {
         ION_LOG_E("Failed to save config");
     }
@@ -133,23 +528,186 @@ bool ConfigManager::save() {
     return success;
 }
 
+void ConfigManager::handle() {
+    if (changedMask || !changedExtras.empty()) {
+        dispatchChanges();
+    }
+    
+    if (savePending && millis() - saveRequestedAt >= commitDelay) {
+        flushAsync();
+    }
+}
+
+void ConfigManager::onChange(const char* keys, ChangeCallback callback) {
+    Subscriber subscriber;
+    subscriber.keys = keys ? keys : "";
+    subscriber.mask = 0;
+    subscriber.generation = schemaGeneration - 1; // Resolve on first dispatch
+    subscriber.callback = callback;
+    subscribers.push_back(subscriber);
+}
+
+void ConfigManager::dispatchChanges() {
+    // Take the batch first: callbacks may set() and queue the next one
+    uint32_t changed = changedMask;
+    std::vector<String> extras;
+    extras.swap(changedExtras);
+    changedMask = 0;
+    
+    // Subscribers added by a callback start with the next batch
+    size_t count = subscribers.size();
+    for (size_t s = 0; s < count; s++) {
+        if (subscribers[s].generation != schemaGeneration) {
+            subscribers[s].mask = resolveMask(subscribers[s].keys);
+            subscribers[s].generation = schemaGeneration;
+        }
+        
+        uint32_t wanted = changed & subscribers[s].mask;
+        if (!wanted && extras.empty()) {
+            continue;
+        }
+        
+        // Called through a copy: onChange() from a callback may reallocate
+        // `subscribers`, and with it the function being run
+        ChangeCallback callback = subscribers[s].callback;
+        for (size_t i = 0; wanted; i++, wanted >>= 1) {
+            if (wanted & 1) {
+                callback(String(FPSTR(fields[i]->id)), valueAt(i));
+            }
+        }
+        
+        for (const auto& key : extras) {
+            if (subscribers[s].keys.isEmpty() || hasKey(subscribers[s].keys, key)) {
+                callback(key, get(key));
+            }
+        }
+    }
+}
+
+void ConfigManager::markChanged(size_t index) {
+    dirtyMask |= (1UL << index);
+    changedMask |= (1UL << index);
+    if (fields[index]->required) {
+        validity = VALIDITY_UNKNOWN;
+    }
+}
+
+void ConfigManager::markExtraChanged(const String& key) {
+    if (subscribers.empty()) {
+        return;
+    }
+    for (const auto& pending : changedExtras) {
+        if (pending == key) {
+            return; // Coalesced with an undelivered change
+        }
+    }
+    changedExtras.push_back(key);
+}
+
+uint32_t ConfigManager::resolveMask(const String& keys) {
+    if (keys.isEmpty()) {
+        return 0xFFFFFFFFUL;
+    }
+    
+    uint32_t mask = 0;
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (hasKey(keys, String(FPSTR(fields[i]->id)))) {
+            mask |= (1UL << i);
+        }
+    }
+    return mask;
+}
+
+bool ConfigManager::hasKey(const String& keys, const String& key) {
+    // keys is a comma-separated list
+    int start = 0;
+    while (start <= (int)keys.length()) {
+        int end = keys.indexOf(',', start);
+        if (end < 0) {
+            end = keys.length();
+        }
+        String item = keys.substring(start, end);
+        item.trim();
+        if (item == key) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+bool ConfigManager::isDirty() {
+    return dirtyMask != 0 || extrasDirty || recordsDirty || metaDirty();
+}
+
+bool ConfigManager::metaDirty() {
+    // Fingerprint or pre-validated flag out of date in storage
+    if (!schemaLoaded || !configLoaded) {
+        return false;
+    }
+    return storedFingerprint != schemaFingerprint ||
+           (validity != VALIDITY_UNKNOWN && (validity == VALIDITY_VALID) != validStored);
+}
+
+void ConfigManager::setCommitDelay(uint32_t delayMs) {
+    commitDelay = delayMs;
+}
+
 bool ConfigManager::clear() {
+    return reset(false);
+}
+
+bool ConfigManager::clearAsync() {
+    return reset(true);
+}
+
+bool ConfigManager::reset(bool async) {
     if (!storage) {
         return false;
     }
     
     configDoc.clear();
     configDoc.to<JsonObject>();
+    invalidateCache();
+    changedMask = fields.size() >= 32 ? 0xFFFFFFFFUL : (1UL << fields.size()) - 1;
+    configLoaded = true;
+    extrasLoaded = true;
+    storedFingerprint = 0;
+    validity = VALIDITY_UNKNOWN;
+    validStored = false;
+    recordsDirty = false;
+    staleBlob = false;
+    extrasGeneration = 0;
     
-    storage->remove(KEY_CONFIG_DATA);
-    storage->commit();
+    // Field records are keyed by hash, so drop the whole namespace
+    storage->clear();
+    commitStorage(async);
     
     ION_LOG("Config cleared");
     return true;
 }
 
+bool ConfigManager::commitStorage(bool async) {
+    // Staged writes stay queued in the provider until the worker commits;
+    // reads see them meanwhile
+    if (async && commitWorker) {
+        commitWorker->request();
+        return true;
+    }
+    return storage->commit();
+}
+
 String ConfigManager::get(const String& key, const String& defaultValue) {
-    if (!configLoaded && !load()) {
+    int index = findField(key.c_str());
+    if (index >= 0) {
+        const String& value = valueAt(index);
+        if (slots[index].present || !value.isEmpty()) {
+            return value;
+        }
+        return defaultValue;
+    }
+    
+    if (!loadExtras()) {
         return defaultValue;
     }
     
@@ -165,55 +723,159 @@ String ConfigManager::get(const String& key, const String& defaultValue) {
         return value;
     }
     
-    // Try default from schema
-    ConfigField* field = getField(key);
-    if (field && !field->defaultValue.isEmpty()) {
-        return field->defaultValue;
-    }
-    
     return defaultValue;
 }
 
 bool ConfigManager::set(const String& key, const String& value) {
-    // Validate first
-    if (!validateField(key, value)) {
-        ION_LOG_W("Validation failed for field: %s", key.c_str());
-        return false;
+    int index = findField(key.c_str());
+    if (index >= 0) {
+        return setAt(index, value);
     }
     
+    loadExtras();
+    
+    // Not in schema: store as-is, encrypting well-known secret names
     JsonObject root = configDoc.as<JsonObject>();
+    String stored = shouldEncrypt(key, nullptr) ? "enc:" + encryptValue(value) : value;
     
-    // Encrypt if needed
-    if (shouldEncrypt(key)) {
-        String encrypted = "enc:" + encryptValue(value);
-        root[key] = encrypted;
-    } else {
-        root[key] = value;
+    if (!root.containsKey(key) || root[key].as<String>() != stored) {
+        root[key] = stored;
+        extrasDirty = true;
+        markExtraChanged(key);
     }
     
-    configLoaded = true;
     return true;
 }
 
+bool ConfigManager::remove(const String& key) {
+    if (findField(key.c_str()) >= 0 || !loadExtras()) {
+        return false;
+    }
+    
+    JsonObject root = configDoc.as<JsonObject>();
+    if (!root.containsKey(key)) {
+        return false;
+    }
+    
+    root.remove(key);
+    extrasDirty = true;
+    markExtraChanged(key);
+    return true;
+}
+
+size_t ConfigManager::getBytesLength(const char* key) {
+    return storage ? storage->getBytesLength(key) : 0;
+}
+
+size_t ConfigManager::getBytes(const char* key, void* buffer, size_t maxLen) {
+    return storage ? storage->getBytes(key, buffer, maxLen) : 0;
+}
+
+bool ConfigManager::setBytes(const char* key, const void* data, size_t len) {
+    if (!storage || !storage->putBytes(key, data, len)) {
+        return false;
+    }
+    recordsDirty = true;
+    return true;
+}
+
+int32_t ConfigManager::getInt(const String& key, int32_t defaultValue) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        String value = get(key);
+        return value.isEmpty() ? defaultValue : value.toInt();
+    }
+    
+    const FieldSlot& slot = slotAt(index);
+    return (slot.present || !slot.value.isEmpty()) ? slot.intValue : defaultValue;
+}
+
+bool ConfigManager::getBool(const String& key, bool defaultValue) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        bool value;
+        return parseBool(get(key), value) ? value : defaultValue;
+    }
+    
+    const FieldSlot& slot = slotAt(index);
+    return (slot.present || !slot.value.isEmpty()) ? slot.boolValue : defaultValue;
+}
+
+float ConfigManager::getFloat(const String& key, float defaultValue) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        String value = get(key);
+        return value.isEmpty() ? defaultValue : value.toFloat();
+    }
+    
+    const FieldSlot& slot = slotAt(index);
+    return (slot.present || !slot.value.isEmpty()) ? slot.floatValue : defaultValue;
+}
+
+bool ConfigManager::setInt(const String& key, int32_t value) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        return set(key, String(value));
+    }
+    return setIntAt(index, value);
+}
+
+bool ConfigManager::setBool(const String& key, bool value) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        return set(key, value ? "true" : "false");
+    }
+    return setBoolAt(index, value);
+}
+
+bool ConfigManager::setFloat(const String& key, float value) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        if (!isfinite(value)) {
+            ION_LOG_W("Key %s: not a finite number", key.c_str());
+            return false;
+        }
+        return set(key, formatFloat(value));
+    }
+    return setFloatAt(index, value);
+}
+
 bool ConfigManager::validate() {
     if (!schemaLoaded) {
         ION_LOG_W("Schema not loaded, skipping validation");
         return true;
     }
     
-    JsonObject root = configDoc.as<JsonObject>();
+    // Pre-validated under this schema and unchanged since: no field reads
+    if (!configLoaded) {
+        load();
+    }
+    if (validity == VALIDITY_VALID) {
+        return true;
+    }
     
-    // Check all required fields
-    for (auto field : fields) {
-        if (field->required) {
-            if (!root.containsKey(field->id) || root[field->id].as<String>().isEmpty()) {
-                ION_LOG_E("Required field missing: %s", field->id.c_str());
-                return false;
+    bool valid = checkRequired();
+    if (valid != validStored) {
+        save(); // Persist the result with the next commit
+    }
+    return valid;
+}
+
+bool ConfigManager::checkRequired() {
+    validity = VALIDITY_VALID;
+    
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i]->required) {
+            const String& value = valueAt(i);
+            if (!slots[i].present || value.isEmpty()) {
+                ION_LOG_E("Required field missing: %s", String(FPSTR(fields[i]->id)).c_str());
+                validity = VALIDITY_INVALID;
+                break;
             }
         }
     }
     
-    return true;
+    return validity == VALIDITY_VALID;
 }
 
 bool ConfigManager::isValid() {
@@ -221,36 +883,69 @@ bool ConfigManager::isValid() {
 }
 
 String ConfigManager::exportJSON() {
-    DynamicJsonDocument exportDoc(ION_JSON_BUFFER_SIZE);
-    JsonObject root = exportDoc.to<JsonObject>();
+    String output;
+    ConfigExporter exporter(this);
     
-    root["version"] = "1.0";
-    root["timestamp"] = millis() / 1000;
-    root["config"] = configDoc.as<JsonObject>();
+    String entry;
+    while (exporter.next(entry)) {
+        output += entry;
+    }
     
-    String output;
-    serializeJson(exportDoc, output);
     return output;
 }
 
+size_t ConfigManager::exportTo(Print& out) {
+    ConfigExporter exporter(this);
+    return exporter.writeTo(out);
+}
+
 bool ConfigManager::importJSON(const String& json) {
-    DynamicJsonDocument importDoc(ION_JSON_BUFFER_SIZE);
-    
-    DeserializationError error = deserializeJson(importDoc, json);
-    if (error) {
-        ION_LOG_E("Failed to parse import JSON: %s", error.c_str());
-        return false;
-    }
-    
-    if (!importDoc.containsKey("config")) {
-        ION_LOG_E("Invalid import format: missing 'config' field");
-        return false;
+    ConfigImporter importer(this);
+    importer.write((const uint8_t*)json.c_str(), json.length());
+    return importer.finish();
+}
+
+bool ConfigManager::applyImport(const JsonDocument& extras, std::vector<String>& values, uint32_t staged) {
+    // Validate the imported config before touching anything, like a
+    // transaction commit. Values are decrypted in place (the importer's
+    // buffer) so the checks see what would be stored.
+    for (size_t i = 0; i < slots.size(); i++) {
+        const ConfigField* field = fields[i];
+        bool ok;
+        
+        if (staged & (1UL << i)) {
+            if (values[i].startsWith("enc:")) {
+                values[i] = decryptValue(values[i].substring(4));
+            }
+            ok = validateField(i, values[i]);
+        } else {
+            ok = !field->required || (field->defaultValue && strlen_P(field->defaultValue) > 0);
+        }
+        
+        if (!ok) {
+            ION_LOG_W("Import rejected, validation failed for field: %s", String(FPSTR(field->id)).c_str());
+            return false;
+        }
     }
     
-    configDoc = importDoc["config"];
+    configDoc = extras;
     configLoaded = true;
+    extrasLoaded = true;
     
-    return save();
+    // Import replaces the whole config: fields missing from the backup are
+    // reset to their defaults and their records removed on flush
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (staged & (1UL << i)) {
+            fillSlot(i, values[i], true);
+        } else {
+            fillSlot(i, FPSTR(fields[i]->defaultValue), false);
+        }
+        markChanged(i);
+    }
+    extrasDirty = true;
+    
+    // Restores are usually followed by a reboot, so don't wait
+    return flushAsync();
 }
 
 String ConfigManager::encryptValue(const String& value) {
@@ -261,64 +956,521 @@ String ConfigManager::decryptValue(const String& encrypted) {
     return Crypto::decrypt(encrypted);
 }
 
-void ConfigManager::parseSchema() {
+bool ConfigManager::applySchemaDoc(DynamicJsonDocument* doc) {
     clearFields();
+    delete schemaDoc;
+    schemaDoc = doc;
+    schemaJson = nullptr;
     
-    if (!schemaDoc.containsKey("fields")) {
+    parseSchema();
+    buildIndex();
+    schemaLoaded = true;
+    return true;
+}
+
+void ConfigManager::parseSchema() {
+    if (!schemaDoc->containsKey("fields")) {
         ION_LOG_E("Schema missing 'fields' array");
         return;
     }
     
-    JsonArray fieldsArray = schemaDoc["fields"].as<JsonArray>();
+    JsonArray fieldsArray = (*schemaDoc)["fields"].as<JsonArray>();
+    
+    size_t count = fieldsArray.size();
+    if (count > ION_MAX_CONFIG_FIELDS) {
+        ION_LOG_W("Schema has %d fields, using the first %d", count, ION_MAX_CONFIG_FIELDS);
+        count = ION_MAX_CONFIG_FIELDS;
+    }
+    
+    // Size the arena up front: descriptors first, then every option list
+    size_t optionsTotal = 0;
+    size_t i = 0;
+    for (JsonVariant v : fieldsArray) {
+        if (i++ == count) {
+            break;
+        }
+        optionsTotal += v["options"].as<JsonArray>().size();
+    }
+    
+    fieldArena = new uint8_t[sizeof(ConfigField) * count + sizeof(const char*) * optionsTotal];
+    ConfigField* table = reinterpret_cast<ConfigField*>(fieldArena);
+    const char** options = reinterpret_cast<const char**>(fieldArena + sizeof(ConfigField) * count);
     
+    // String members point into schemaDoc, which outlives the fields
+    ConfigField* field = table;
     for (JsonVariant v : fieldsArray) {
+        if (field == table + count) {
+            break;
+        }
         JsonObject fieldObj = v.as<JsonObject>();
         
-        ConfigField* field = new ConfigField();
-        field->id = fieldObj["id"].as<String>();
+        field->id = fieldObj["id"] | "";
         field->label = fieldObj["label"] | "";
         field->type = fieldObj["type"] | "text";
         field->defaultValue = fieldObj["default"] | "";
         field->placeholder = fieldObj["placeholder"] | "";
-        field->required = fieldObj["required"] | false;
-        field->encrypted = fieldObj["encrypted"] | false;
+        field->pattern = fieldObj["pattern"] | "";
+        field->visibleIf = fieldObj["visible_if"] | "";
         field->minLength = fieldObj["minLength"] | 0;
         field->maxLength = fieldObj["maxLength"] | 0;
         field->min = fieldObj["min"] | 0;
         field->max = fieldObj["max"] | 0;
-        field->pattern = fieldObj["pattern"] | "";
-        field->visibleIf = fieldObj["visible_if"] | "";
+        field->required = fieldObj["required"] | false;
+        field->encrypted = fieldObj["encrypted"] | false;
+        field->inputType = parseFieldType(field->type);
         
-        // Parse options for select type
-        if (fieldObj.containsKey("options")) {
-            JsonArray opts = fieldObj["options"].as<JsonArray>();
-            field->optionsCount = opts.size();
-            if (field->optionsCount > 0) {
-                field->options = new String[field->optionsCount];
-                size_t i = 0;
-                for (JsonVariant opt : opts) {
-                    field->options[i++] = opt.as<String>();
-                }
-            }
+        // Options for select type
+        JsonArray opts = fieldObj["options"].as<JsonArray>();
+        field->options = opts.size() > 0 ? options : nullptr;
+        field->optionsCount = opts.size();
+        for (JsonVariant opt : opts) {
+            *options++ = opt | "";
         }
-        
-        fields.push_back(field);
+        field++;
     }
+    
+    fields.table = table;
+    fields.count = count;
 }
 
 void ConfigManager::clearFields() {
-    for (auto field : fields) {
-        delete field;
+    // Pending field writes are indexed by the schema about to go away
+    if (dirtyMask) {
+        flush();
     }
-    fields.clear();
+    
+    delete[] fieldArena;
+    fieldArena = nullptr;
+    fields = FieldList();
+    fieldIndex.clear();
+    slots.clear();
+    patterns.clear();
 }
 
-bool ConfigManager::validateField(const String& key, const String& value) {
-    ConfigField* field = getField(key);
-    if (!field) {
-        return true; // No schema, allow any field
+FieldType ConfigManager::parseFieldType(const char* type) {
+    if (strcmp_P("text", type) == 0) return FIELD_TEXT;
+    if (strcmp_P("password", type) == 0) return FIELD_PASSWORD;
+    if (strcmp_P("number", type) == 0) return FIELD_NUMBER;
+    if (strcmp_P("checkbox", type) == 0) return FIELD_CHECKBOX;
+    if (strcmp_P("select", type) == 0) return FIELD_SELECT;
+    return FIELD_OTHER;
+}
+
+void ConfigManager::buildIndex() {
+    // Insertion sort: runs once per schema load on at most ION_MAX_CONFIG_FIELDS
+    fieldIndex.resize(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        uint8_t current = i;
+        size_t j = i;
+        while (j > 0 && strcmpPP(fields[fieldIndex[j - 1]]->id, fields[current]->id) > 0) {
+            fieldIndex[j] = fieldIndex[j - 1];
+            j--;
+        }
+        fieldIndex[j] = current;
+    }
+    
+    slots.assign(fields.size(), FieldSlot());
+    patterns.assign(fields.size(), Pattern());
+    for (size_t i = 0; i < fields.size(); i++) {
+        slots[i].kind = kindOf(fields[i]);
+        if (pgm_read_byte(fields[i]->pattern)) {
+            patterns[i].compile(fields[i]->pattern); // Unsupported syntax is logged and not enforced
+        }
+    }
+    dirtyMask = 0;
+    changedMask = 0;
+    schemaGeneration++;
+    schemaFingerprint = computeFingerprint();
+    validity = VALIDITY_UNKNOWN;
+    
+    // Values stored under a previous schema may now belong to a field
+    if (configLoaded) {
+        checkFingerprint();
+    }
+}
+
+uint32_t ConfigManager::computeFingerprint() {
+    // Everything that decides how values are stored and validated; labels,
+    // placeholders and defaults can change without invalidating stored data
+    uint32_t hash = Hash::FNV_OFFSET;
+    for (size_t i = 0; i < fields.size(); i++) {
+        const ConfigField* field = fields[i];
+        int32_t limits[4] = { field->minLength, field->maxLength, field->min, field->max };
+        uint8_t flags[3] = { (uint8_t)field->inputType, field->required, field->encrypted };
+        
+        hash = Hash::fnv1a(field->id, hash);
+        hash = Hash::fnv1a(flags, sizeof(flags), hash);
+        hash = Hash::fnv1a(field->pattern, hash);
+        hash = Hash::fnv1a(reinterpret_cast<const uint8_t*>(limits), sizeof(limits), hash);
+    }
+    return hash ? hash : 1; // 0 means "no fingerprint stored"
+}
+
+int ConfigManager::findField(const char* key) {
+    int lo = 0;
+    int hi = (int)fieldIndex.size() - 1;
+    
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp_P(key, fields[fieldIndex[mid]]->id);
+        if (cmp == 0) {
+            return fieldIndex[mid];
+        }
+        if (cmp < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    
+    return -1;
+}
+
+const String& ConfigManager::valueAt(size_t index) {
+    return slotAt(index).value;
+}
+
+const ConfigManager::FieldSlot& ConfigManager::slotAt(size_t index) {
+    FieldSlot& slot = slots[index];
+    if (slot.cached) {
+        return slot;
+    }
+    
+    if (!configLoaded) {
+        load();
+        if (slot.cached) {
+            return slot; // Adopted from the config blob
+        }
+    }
+    
+    char key[RECORD_KEY_SIZE];
+    recordKey(index, key);
+    
+    if (!storage || !storage->exists(key)) {
+        fillSlot(index, FPSTR(fields[index]->defaultValue), false);
+    } else if (slot.kind == VALUE_INT) {
+        fillSlot(index, String(storage->getInt(key)), true);
+    } else if (slot.kind == VALUE_BOOL) {
+        fillSlot(index, storage->getBool(key) ? "true" : "false", true);
+    } else {
+        fillSlot(index, readStringRecord(key), true);
+    }
+    
+    return slot;
+}
+
+String ConfigManager::readStringRecord(const char* key) {
+    // Secrets are raw ciphertext; older firmware stored "enc:<hex>" text
+    size_t len = storage->getBytesLength(key);
+    if (len > 0) {
+        std::vector<uint8_t> cipher(len);
+        if (storage->getBytes(key, cipher.data(), len) != len) {
+            return String();
+        }
+        return Crypto::decryptBytes(cipher.data(), len);
+    }
+    
+    String value = storage->getString(key);
+    if (value.startsWith("enc:")) {
+        value = decryptValue(value.substring(4));
+    }
+    return value;
+}
+
+void ConfigManager::fillSlot(size_t index, const String& value, bool present) {
+    FieldSlot& slot = slots[index];
+    slot.present = present;
+    slot.cached = true;
+    
+    if (slot.kind == VALUE_INT && parseInt32(value, slot.intValue)) {
+        slot.value = String(slot.intValue);
+        slot.floatValue = slot.intValue;
+        slot.boolValue = slot.intValue != 0;
+    } else if (slot.kind == VALUE_BOOL && parseBool(value, slot.boolValue)) {
+        slot.value = slot.boolValue ? "true" : "false";
+        slot.intValue = slot.boolValue;
+        slot.floatValue = slot.intValue;
+    } else {
+        // Text fields keep their native forms too, so typed reads never parse
+        slot.value = value;
+        slot.intValue = value.toInt();
+        slot.floatValue = value.toFloat();
+        slot.boolValue = false;
+        parseBool(value, slot.boolValue);
+    }
+}
+
+bool ConfigManager::setAt(size_t index, const String& value) {
+    const ConfigField* field = fields[index];
+    
+    // Validate first
+    if (!validateField(index, value)) {
+        ION_LOG_W("Validation failed for field: %s", String(FPSTR(field->id)).c_str());
+        return false;
+    }
+    
+    storeAt(index, value);
+    return true;
+}
+
+void ConfigManager::storeAt(size_t index, const String& value) {
+    const ConfigField* field = fields[index];
+    
+    // Load first so a lazy load() cannot drop this write
+    const FieldSlot& slot = slotAt(index);
+    
+    if (value.isEmpty() && slot.kind != VALUE_STRING) {
+        // No native form for "empty": fall back to the schema default
+        if (slot.present) {
+            fillSlot(index, FPSTR(field->defaultValue), false);
+            markChanged(index);
+        }
+        return;
+    }
+    
+    if (slot.present && slot.value == value) {
+        return; // Unchanged, nothing to persist
+    }
+    
+    fillSlot(index, value, true);
+    markChanged(index);
+}
+
+bool ConfigManager::setIntAt(size_t index, int32_t value) {
+    const FieldSlot& slot = slotAt(index);
+    if (slot.kind != VALUE_INT) {
+        return setAt(index, String(value));
     }
     
+    if (!validateInt(fields[index], value)) {
+        ION_LOG_W("Validation failed for field: %s", String(FPSTR(fields[index]->id)).c_str());
+        return false;
+    }
+    
+    if (slot.present && slot.intValue == value) {
+        return true;
+    }
+    
+    fillSlot(index, String(value), true);
+    markChanged(index);
+    return true;
+}
+
+bool ConfigManager::setBoolAt(size_t index, bool value) {
+    const FieldSlot& slot = slotAt(index);
+    if (slot.kind != VALUE_BOOL) {
+        return setAt(index, value ? "true" : "false");
+    }
+    
+    if (slot.present && slot.boolValue == value) {
+        return true;
+    }
+    
+    fillSlot(index, value ? "true" : "false", true);
+    markChanged(index);
+    return true;
+}
+
+bool ConfigManager::setFloatAt(size_t index, float value) {
+    if (!isfinite(value)) {
+        ION_LOG_W("Field %s: not a finite number", String(FPSTR(fields[index]->id)).c_str());
+        return false;
+    }
+    if (slots[index].kind == VALUE_INT) {
+        // Out of int32_t range the cast is undefined; 2^31 is exact in float
+        if (value < -2147483648.0f || value >= 2147483648.0f) {
+            ION_LOG_W("Field %s: %s is out of range", String(FPSTR(fields[index]->id)).c_str(),
+                      formatFloat(value).c_str());
+            return false;
+        }
+        int32_t whole = (int32_t)value;
+        if ((float)whole != value) {
+            ION_LOG_W("Field %s only accepts whole numbers", String(FPSTR(fields[index]->id)).c_str());
+            return false;
+        }
+        return setIntAt(index, whole);
+    }
+    return setAt(index, formatFloat(value));
+}
+
+void ConfigManager::invalidateCache() {
+    for (auto& slot : slots) {
+        slot.cached = false;
+        slot.present = false;
+        slot.value = String();
+    }
+    dirtyMask = 0;
+    extrasDirty = false;
+    savePending = false;
+}
+
+void ConfigManager::adoptBlobFields() {
+    JsonObject root = configDoc.as<JsonObject>();
+    uint8_t adopted = 0;
+    
+    for (size_t i = 0; i < fields.size(); i++) {
+        const ConfigField* field = fields[i];
+        if (!root.containsKey(FPSTR(field->id))) {
+            continue;
+        }
+        
+        String value = root[FPSTR(field->id)].as<String>();
+        if (value.startsWith("enc:")) {
+            value = decryptValue(value.substring(4));
+        }
+        fillSlot(i, value, true);
+        dirtyMask |= (1UL << i);
+        
+        root.remove(FPSTR(field->id));
+        adopted++;
+    }
+    
+    if (adopted > 0) {
+        extrasDirty = true;
+        ION_LOG("Moving %d fields from config_data to per-key records", adopted);
+        save();
+    }
+}
+
+void ConfigManager::convertRecords() {
+    // A record stored as another type would read as the zero value of the
+    // field's type: convert it, or drop it if it is not valid for the field
+    uint8_t converted = 0;
+    uint8_t dropped = 0;
+    
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (slots[i].cached) {
+            continue; // Adopted from the config blob
+        }
+        
+        char key[RECORD_KEY_SIZE];
+        recordKey(i, key);
+        if (!storage->exists(key)) {
+            continue;
+        }
+        
+        String value;
+        if (readAnyRecord(key, value) == slots[i].kind) {
+            continue;
+        }
+        
+        if (!value.isEmpty() && validateField(i, value)) {
+            fillSlot(i, value, true);
+            converted++;
+        } else {
+            ION_LOG_W("Dropping stored %s: not valid for its new type", String(FPSTR(fields[i]->id)).c_str());
+            fillSlot(i, FPSTR(fields[i]->defaultValue), false);
+            dropped++;
+        }
+        dirtyMask |= (1UL << i);
+    }
+    
+    if (converted > 0 || dropped > 0) {
+        ION_LOG("Field types changed: %d records converted, %d dropped", converted, dropped);
+        save();
+    }
+}
+
+ConfigManager::ValueKind ConfigManager::readAnyRecord(const char* key, String& value) {
+    // Typed reads return the default for another type, so a record is of a
+    // type when two different defaults give the same answer
+    int32_t number = storage->getInt(key, INT32_MIN);
+    if (number != INT32_MIN || storage->getInt(key, INT32_MAX) != INT32_MAX) {
+        value = String(number);
+        return VALUE_INT;
+    }
+    
+    bool flag = storage->getBool(key, false);
+    if (flag || !storage->getBool(key, true)) {
+        value = flag ? "true" : "false";
+        return VALUE_BOOL;
+    }
+    
+    value = readStringRecord(key);
+    return VALUE_STRING;
+}
+
+ConfigManager::ValueKind ConfigManager::kindOf(const ConfigField* field) {
+    if (field->encrypted) {
+        return VALUE_STRING; // Secrets are strings, stored encrypted
+    }
+    if (field->inputType == FIELD_NUMBER) {
+        return VALUE_INT;
+    }
+    if (field->inputType == FIELD_CHECKBOX) {
+        return VALUE_BOOL;
+    }
+    return VALUE_STRING;
+}
+
+void ConfigManager::recordKey(size_t index, char* key) {
+    // NVS keys are limited to 15 characters, so use a hash of the field id
+    snprintf(key, RECORD_KEY_SIZE, "f%08lx", (unsigned long)Hash::fnv1a(fields[index]->id));
+}
+
+ConfigTransaction ConfigManager::beginTransaction() {
+    return ConfigTransaction(this);
+}
+
+ConfigHandle ConfigManager::getHandle(const String& key) {
+    int index = findField(key.c_str());
+    if (index < 0) {
+        ION_LOG_W("No schema field for handle: %s", key.c_str());
+        return ConfigHandle();
+    }
+    return ConfigHandle(this, index, schemaGeneration);
+}
+
+bool ConfigHandle::isValid() const {
+    return manager && index >= 0 && generation == manager->schemaGeneration;
+}
+
+const ConfigField* ConfigHandle::field() const {
+    return isValid() ? manager->fields[index] : nullptr;
+}
+
+const String& ConfigHandle::get() const {
+    static const String empty;
+    if (!isValid()) {
+        return empty;
+    }
+    return manager->valueAt(index);
+}
+
+bool ConfigHandle::set(const String& value) {
+    if (!isValid()) {
+        return false;
+    }
+    return manager->setAt(index, value);
+}
+
+int32_t ConfigHandle::getInt() const {
+    return isValid() ? manager->slotAt(index).intValue : 0;
+}
+
+bool ConfigHandle::getBool() const {
+    return isValid() ? manager->slotAt(index).boolValue : false;
+}
+
+float ConfigHandle::getFloat() const {
+    return isValid() ? manager->slotAt(index).floatValue : 0.0f;
+}
+
+bool ConfigHandle::setInt(int32_t value) {
+    return isValid() && manager->setIntAt(index, value);
+}
+
+bool ConfigHandle::setBool(bool value) {
+    return isValid() && manager->setBoolAt(index, value);
+}
+
+bool ConfigHandle::setFloat(float value) {
+    return isValid() && manager->setFloatAt(index, value);
+}
+
+bool ConfigManager::validateField(size_t index, const String& value) {
+    const ConfigField* field = fields[index];
+    
     // Required check
     if (field->required && value.isEmpty()) {
         return false;
@@ -329,11 +1481,16 @@ bool ConfigManager::validateField(const String& key, const String& value) {
         return true;
     }
     
-    // Type-specific validation
-    if (field->type == "number") {
-        int val = value.toInt();
-        if (field->min != 0 && val < field->min) return false;
-        if (field->max != 0 && val > field->max) return false;
+    // Type-specific validation, on the native value
+    ValueKind kind = kindOf(field);
+    if (kind == VALUE_INT) {
+        int32_t number;
+        if (!parseInt32(value, number) || !validateInt(field, number)) {
+            return false;
+        }
+    } else if (kind == VALUE_BOOL) {
+        bool flag;
+        return parseBool(value, flag);
     }
     
     // Length validation
@@ -344,20 +1501,21 @@ bool ConfigManager::validateField(const String& key, const String& value) {
         return false;
     }
     
-    // Pattern validation (basic, can be enhanced)
-    if (!field->pattern.isEmpty()) {
-        // Simple pattern check - for now just check if pattern is substring
-        // Full regex would require regex library
-        if (value.indexOf(field->pattern) == -1) {
-            ION_LOG_W("Pattern validation not fully implemented");
-        }
+    // Pattern validation (whole value, compiled at schema load)
+    if (!patterns[index].matches(value.c_str())) {
+        return false;
     }
     
     return true;
 }
 
-bool ConfigManager::shouldEncrypt(const String& key) {
-    ConfigField* field = getField(key);
+bool ConfigManager::validateInt(const ConfigField* field, int32_t value) {
+    if (field->min != 0 && value < field->min) return false;
+    if (field->max != 0 && value > field->max) return false;
+    return true;
+}
+
+bool ConfigManager::shouldEncrypt(const String& key, const ConfigField* field) {
     if (!field) {
         // Default encryption for known sensitive keys
         return (key == "wifi_pass" || key == "password" || 
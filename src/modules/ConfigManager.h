@@ -4,44 +4,110 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <vector>
+#include <functional>
 #include "../core/IonTypes.h"
 #include "../storage/StorageProvider.h"
+#include "../utils/Pattern.h"
+#include "ConfigHandle.h"
+#include "ConfigSnapshot.h"
+#include "ConfigStream.h"
+#include "ConfigTransaction.h"
 
 namespace IonConnect {
 
+class CommitWorker;
+
 /**
  * @brief Manages configuration schema, validation, and persistence
  * 
  * Handles:
  * - JSON schema loading and parsing
- * - Dynamic field validation
- * - Configuration storage via StorageProvider
+ * - Compiled (PROGMEM) schema tables without runtime parsing
+ * - Indexed field lookup and bound ConfigHandle access
+ * - Typed values (number/checkbox) stored and cached in native form
+ * - Dynamic field validation (compiled `pattern` matching) and
+ *   all-or-nothing transactions
+ * - Per-key storage records with dirty tracking and coalesced writes
+ * - Flash commits handed to a CommitWorker off the calling task
+ * - Binary snapshot of non-schema keys (ION_BINARY_CONFIG)
+ * - Coalesced change events delivered from handle()
+ * - Schema fingerprinting: warm boots skip validation and defer parsing
+ *   of non-schema keys; a migration hook runs when the schema changes
  * - Config export/import for backup/restore
  * - Field encryption (passwords, tokens)
  */
 class ConfigManager {
 public:
+    typedef std::function<void(const String& key, const String& value)> ChangeCallback;
+    typedef std::function<void(uint32_t oldFingerprint, uint32_t newFingerprint)> MigrationCallback;
+    
     ConfigManager(StorageProvider* storage);
     ~ConfigManager();
     
+    void setStorage(StorageProvider* provider);    // Before load(); not owned
+    void setCommitWorker(CommitWorker* worker);     // Commits for the *Async calls; not owned
+    
     // Schema Management
     bool loadSchema(const char* jsonSchema);
+    bool loadSchema(const ConfigField* table, size_t count, const char* jsonSchema); // PROGMEM table
     bool loadSchemaFromFile(const char* filepath);
     String getSchemaJSON();
-    std::vector<ConfigField*> getFields();
-    ConfigField* getField(const String& key);
+    std::vector<const ConfigField*> getFields();
+    size_t getFieldCount();
+    const ConfigField* getFieldAt(size_t index);
+    const ConfigField* getField(const String& key);
+    static FieldType parseFieldType(const char* type);
+    uint32_t getSchemaFingerprint();
+    
+    // Runs once when stored config was written under a different schema
+    // (oldFingerprint is 0 on first boot). Register before load().
+    void onSchemaMigration(MigrationCallback callback);
     
     // Config Operations
     bool load();
-    bool save();
+    bool save();                // Persist dirty keys (after the commit delay)
+    bool flush();               // Persist dirty keys now (e.g. before reboot)
+    bool flushAsync();          // Stage dirty keys, commit on the worker
+    void handle();              // Call from loop(): runs delayed flushes
+    bool isDirty();
+    void setCommitDelay(uint32_t delayMs);
+    
+    // Change events: `keys` is a comma-separated list (nullptr = all keys).
+    // Changes are batched and delivered from handle(); repeated writes to a
+    // key before delivery produce one event with the latest value.
+    void onChange(const char* keys, ChangeCallback callback);
+    void dispatchChanges();
     bool clear();
+    bool clearAsync();          // Like clear(), committed on the worker
     String get(const String& key, const String& defaultValue = "");
     bool set(const String& key, const String& value);
+    bool remove(const String& key);     // Non-schema keys only
+    
+    // Binary records kept beside the config and not exported (e.g. the
+    // saved-network table). Written to storage now, committed by the next flush.
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLen);
+    bool setBytes(const char* key, const void* data, size_t len);
+    
+    // Typed access: number/checkbox fields are read without parsing
+    int32_t getInt(const String& key, int32_t defaultValue = 0);
+    bool getBool(const String& key, bool defaultValue = false);
+    float getFloat(const String& key, float defaultValue = 0.0f);
+    bool setInt(const String& key, int32_t value);
+    bool setBool(const String& key, bool value);
+    bool setFloat(const String& key, float value);
     bool validate();
     bool isValid();
     
-    // Backup/Restore
+    // Batch updates: validated together, persisted with one commit
+    ConfigTransaction beginTransaction();
+    
+    // Bound access for hot paths (see ConfigHandle)
+    ConfigHandle getHandle(const String& key);
+    
+    // Backup/Restore (see ConfigExporter/ConfigImporter for chunked use)
     String exportJSON();
+    size_t exportTo(Print& out);
     bool importJSON(const String& json);
     
     // Encryption
@@ -49,21 +115,134 @@ public:
     String decryptValue(const String& encrypted);
     
 private:
+    friend class ConfigHandle;
+    friend class ConfigExporter;
+    friend class ConfigImporter;
+    friend class ConfigTransaction;
+    
+    // Storage form of a field, derived from its schema type
+    enum ValueKind : uint8_t {
+        VALUE_STRING,
+        VALUE_INT,          // "number"
+        VALUE_BOOL          // "checkbox"
+    };
+    
+    // Per-field value cache, indexed like `fields`
+    struct FieldSlot {
+        String value;       // Decrypted value, or the schema default if !present
+        int32_t intValue = 0;       // Native forms of `value`, kept in sync
+        float floatValue = 0.0f;
+        bool boolValue = false;
+        ValueKind kind = VALUE_STRING;
+        bool cached = false;
+        bool present = false;
+    };
+    
+    // Contiguous descriptor table: flash (compiled, ESP32) or fieldArena
+    struct FieldList {
+        const ConfigField* table = nullptr;
+        size_t count = 0;
+        
+        size_t size() const { return count; }
+        const ConfigField* operator[](size_t index) const { return &table[index]; }
+    };
+    
     StorageProvider* storage;
-    DynamicJsonDocument schemaDoc;
+    CommitWorker* commitWorker;         // Null: every commit is synchronous
+    DynamicJsonDocument* schemaDoc;     // Runtime schemas only
     DynamicJsonDocument configDoc;
-    std::vector<ConfigField*> fields;
+    const char* schemaJson;             // PROGMEM JSON of a compiled schema
+    uint8_t* fieldArena;                // Descriptors + option lists, one block
+    FieldList fields;
+    std::vector<uint8_t> fieldIndex;    // Indices into `fields`, sorted by id
+    std::vector<FieldSlot> slots;
+    std::vector<Pattern> patterns;      // Compiled `pattern`, indexed like `fields`
+    uint16_t schemaGeneration;          // Bumped on every schema load
+    uint32_t dirtyMask;                 // Slots changed since the last flush
+    bool extrasDirty;                   // configDoc changed since the last flush
+    bool recordsDirty;                  // setBytes() since the last flush
+    bool savePending;
+    uint32_t saveRequestedAt;
+    uint32_t commitDelay;
+    
+    struct Subscriber {
+        String keys;
+        uint32_t mask;                  // `keys` resolved against the schema
+        uint16_t generation;            // Schema the mask was resolved for
+        ChangeCallback callback;
+    };
+    std::vector<Subscriber> subscribers;
+    uint32_t changedMask;               // Fields changed since the last dispatch
+    std::vector<String> changedExtras;  // Non-schema keys changed (deduplicated)
+    
+    // Result of the required-field check, persisted with the fingerprint
+    enum Validity : uint8_t {
+        VALIDITY_UNKNOWN,
+        VALIDITY_VALID,
+        VALIDITY_INVALID
+    };
+    
+    uint32_t schemaFingerprint;         // Hash of the active field descriptors
+    uint32_t storedFingerprint;         // Fingerprint the stored config was written under
+    Validity validity;
+    bool validStored;                   // Persisted pre-validated flag
+    MigrationCallback migrationCallback;
     bool schemaLoaded;
     bool configLoaded;
+    bool extrasLoaded;                  // configDoc read from storage
+    bool staleBlob;                     // Extras also stored in the other format
+    uint32_t extrasGeneration;          // Bumped per extras write; low bit is the slot
     
+    bool persist(bool async);
+    bool reset(bool async);
+    bool commitStorage(bool async);
+    bool applySchemaDoc(DynamicJsonDocument* doc);
     void parseSchema();
     void clearFields();
-    bool validateField(const String& key, const String& value);
-    bool shouldEncrypt(const String& key);
+    void buildIndex();
+    int findField(const char* key);
+    const String& valueAt(size_t index);
+    const FieldSlot& slotAt(size_t index);
+    void fillSlot(size_t index, const String& value, bool present);
+    bool setAt(size_t index, const String& value);
+    void storeAt(size_t index, const String& value);  // Already validated
+    bool setIntAt(size_t index, int32_t value);
+    bool setBoolAt(size_t index, bool value);
+    bool setFloatAt(size_t index, float value);
+    void invalidateCache();
+    void adoptBlobFields();
+    void convertRecords();
+    ValueKind readAnyRecord(const char* key, String& value);
+    bool loadExtras();
+    bool readExtras(uint8_t slot, bool& binary);
+    static void blobKey(const char* base, uint8_t slot, char* key);
+    bool readSnapshot(const char* key);
+    bool readJsonBlob(const char* key);
+    bool writeExtras();
+    void checkFingerprint();
+    uint32_t computeFingerprint();
+    bool checkRequired();
+    bool metaDirty();
+    void markChanged(size_t index);
+    void markExtraChanged(const String& key);
+    uint32_t resolveMask(const String& keys);
+    static bool hasKey(const String& keys, const String& key);
+    bool applyImport(const JsonDocument& extras, std::vector<String>& values, uint32_t staged);
+    void recordKey(size_t index, char* key);
+    String readStringRecord(const char* key);
+    bool validateField(size_t index, const String& value);
+    bool validateInt(const ConfigField* field, int32_t value);
+    static ValueKind kindOf(const ConfigField* field);
+    bool shouldEncrypt(const String& key, const ConfigField* field);
     
     // Storage keys
+    static const size_t RECORD_KEY_SIZE = 10;   // "f" + 8 hex digits
     static const char* KEY_CONFIG_DATA;
+    static const char* KEY_CONFIG_SNAPSHOT;
     static const char* KEY_SCHEMA_VERSION;
+    static const char* KEY_CONFIG_VALID;
+    static const char* KEY_CONFIG_SLOT;
+    static const size_t BLOB_KEY_SIZE = 16;     // NVS keys are at most 15 chars
 };
 
 } // namespace IonConnect
@@ -0,0 +1,174 @@
+#include "ConfigSnapshot.h"
+#include "../utils/JsonPool.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+const uint8_t ConfigSnapshot::VERSION; // Bound to a reference by push_back()
+
+static const char SECRET_PREFIX[] = "enc:";
+static const size_t SECRET_PREFIX_LEN = sizeof(SECRET_PREFIX) - 1;
+
+static int hexValue(char c) {
+    if (c <= '9') return c - '0';
+    return c - 'a' + 10; // isSecret() only accepts lowercase hex
+}
+
+static void appendCString(std::vector<uint8_t>& out, const char* text) {
+    out.insert(out.end(), text, text + strlen(text) + 1);
+}
+
+void ConfigSnapshot::encode(JsonObjectConst config, std::vector<uint8_t>& out) {
+    // Never larger than the JSON form, so this is the only allocation
+    out.clear();
+    out.reserve(HEADER_SIZE + measureJson(config));
+    out.push_back('I');
+    out.push_back('C');
+    out.push_back(VERSION);
+
+    for (JsonPairConst kv : config) {
+        JsonVariantConst value = kv.value();
+
+        if (!value.is<const char*>()) {
+            out.push_back(TAG_JSON);
+            appendCString(out, kv.key().c_str());
+
+            size_t start = out.size();
+            size_t len = measureJson(value);
+            out.resize(start + len + 1);
+            serializeJson(value, (char*)&out[start], len + 1);
+            continue;
+        }
+
+        const char* text = value.as<const char*>();
+        size_t len = strlen(text);
+
+        if (isSecret(text, len)) {
+            const char* hex = text + SECRET_PREFIX_LEN;
+            size_t raw = (len - SECRET_PREFIX_LEN) / 2;
+
+            out.push_back(TAG_SECRET);
+            appendCString(out, kv.key().c_str());
+            out.push_back(raw & 0xFF);
+            out.push_back((raw >> 8) & 0xFF);
+            for (size_t i = 0; i < raw; i++) {
+                out.push_back((hexValue(hex[i * 2]) << 4) | hexValue(hex[i * 2 + 1]));
+            }
+        } else {
+            out.push_back(TAG_STRING);
+            appendCString(out, kv.key().c_str());
+            appendCString(out, text);
+        }
+    }
+}
+
+bool ConfigSnapshot::decode(uint8_t* data, size_t len, JsonDocument& config) {
+    config.clear();
+    JsonObject root = config.to<JsonObject>();
+
+    if (len < HEADER_SIZE || data[0] != 'I' || data[1] != 'C') {
+        ION_LOG_E("Config snapshot: bad header");
+        return false;
+    }
+    if (data[2] != VERSION) {
+        ION_LOG_E("Config snapshot: unsupported version %d", data[2]);
+        return false;
+    }
+
+    uint8_t* end = data + len;
+    uint8_t* p = data + HEADER_SIZE;
+
+    while (p < end) {
+        uint8_t tag = *p++;
+
+        // Keys and text values are stored with their terminator; pass them
+        // as char* so ArduinoJson copies them into the document
+        char* key = (char*)p;
+        p = (uint8_t*)memchr(p, 0, end - p);
+        if (!p) {
+            ION_LOG_E("Config snapshot: truncated key");
+            return false;
+        }
+        p++;
+
+        if (tag == TAG_SECRET) {
+            if (end - p < 2) {
+                ION_LOG_E("Config snapshot: truncated entry");
+                return false;
+            }
+            size_t raw = p[0] | (p[1] << 8);
+            p += 2;
+            if ((size_t)(end - p) < raw) {
+                ION_LOG_E("Config snapshot: truncated entry");
+                return false;
+            }
+
+            // Back to the in-memory "enc:<hex>" form that get() understands
+            static const char digits[] = "0123456789abcdef";
+            char* text = (char*)malloc(SECRET_PREFIX_LEN + raw * 2 + 1);
+            if (!text) {
+                return false;
+            }
+            memcpy(text, SECRET_PREFIX, SECRET_PREFIX_LEN);
+            char* hex = text + SECRET_PREFIX_LEN;
+            for (size_t i = 0; i < raw; i++) {
+                *hex++ = digits[p[i] >> 4];
+                *hex++ = digits[p[i] & 0x0F];
+            }
+            *hex = '\0';
+            p += raw;
+
+            root[key] = text;
+            free(text);
+        } else if (tag == TAG_STRING || tag == TAG_JSON) {
+            char* text = (char*)p;
+            p = (uint8_t*)memchr(p, 0, end - p);
+            if (!p) {
+                ION_LOG_E("Config snapshot: truncated entry");
+                return false;
+            }
+            p++;
+
+            if (tag == TAG_STRING) {
+                root[key] = text;
+            } else {
+                PooledJsonDocument value(ION_JSON_BUFFER_SIZE);
+                if (deserializeJson(value, (const char*)text)) {
+                    ION_LOG_E("Config snapshot: bad value for %s", key);
+                    return false;
+                }
+                root[key] = value.as<JsonVariantConst>();
+            }
+        } else {
+            ION_LOG_E("Config snapshot: unknown tag %d", tag);
+            return false;
+        }
+    }
+
+    if (config.overflowed()) {
+        ION_LOG_E("Config snapshot: config too large");
+        return false;
+    }
+    return true;
+}
+
+bool ConfigSnapshot::isSecret(const char* value, size_t len) {
+    if (len < SECRET_PREFIX_LEN || strncmp(value, SECRET_PREFIX, SECRET_PREFIX_LEN) != 0) {
+        return false;
+    }
+
+    // Only canonical hex round-trips; anything else is kept as text
+    size_t hexLen = len - SECRET_PREFIX_LEN;
+    if (hexLen % 2 != 0 || hexLen / 2 > 0xFFFF) {
+        return false;
+    }
+    for (size_t i = SECRET_PREFIX_LEN; i < len; i++) {
+        char c = value[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace IonConnect
@@ -0,0 +1,45 @@
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+
+namespace IonConnect {
+
+/**
+ * @brief Compact binary encoding for the non-schema config keys
+ *
+ * Layout: "IC", a version byte, then one entry per key:
+ *
+ *   TAG_STRING  [tag][key\0][value\0]
+ *   TAG_SECRET  [tag][key\0][len:u16 LE][raw ciphertext]
+ *   TAG_JSON    [tag][key\0][JSON text\0]     (non-string values)
+ *
+ * Encrypted values ("enc:<hex>") are stored as raw bytes, halving their
+ * size, and keys/strings lose the JSON quoting. Strings are terminated in
+ * the image itself, so decoding copies them straight into the document
+ * without building intermediate Strings.
+ */
+class ConfigSnapshot {
+public:
+    static const uint8_t VERSION = 1;
+
+    static void encode(JsonObjectConst config, std::vector<uint8_t>& out);
+    static bool decode(uint8_t* data, size_t len, JsonDocument& config);
+
+private:
+    enum Tag : uint8_t {
+        TAG_STRING = 1,
+        TAG_SECRET = 2,
+        TAG_JSON = 3
+    };
+
+    static const size_t HEADER_SIZE = 3;
+
+    static bool isSecret(const char* value, size_t len);
+};
+
+} // namespace IonConnect
+
+#endif // CONFIG_SNAPSHOT_H
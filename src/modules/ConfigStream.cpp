@@ -0,0 +1,357 @@
+#include "ConfigStream.h"
+#include "ConfigManager.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+// Append `text` as a quoted JSON string; `text` may live in flash
+static void appendJsonString(String& out, const char* text) {
+    out += '"';
+    uint8_t c;
+    while ((c = pgm_read_byte(text++)) != 0) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[7];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// ============================================================================
+// ConfigExporter
+// ============================================================================
+
+ConfigExporter::ConfigExporter(ConfigManager* manager)
+    : manager(manager), stage(STAGE_HEADER), position(0), first(true), offset(0) {
+}
+
+bool ConfigExporter::next(String& entry) {
+    entry = "";
+
+    while (stage != STAGE_DONE) {
+        switch (stage) {
+            case STAGE_HEADER:
+                manager->loadExtras();
+                entry = "{\"version\":\"1.0\",\"timestamp\":";
+                entry += millis() / 1000;
+                entry += ",\"config\":{";
+                stage = STAGE_EXTRAS;
+                position = 0;
+                return true;
+
+            case STAGE_EXTRAS: {
+                // Re-seek by position: the document may not be stable across chunks
+                size_t i = 0;
+                for (JsonPair kv : manager->configDoc.as<JsonObject>()) {
+                    if (i++ < position) {
+                        continue;
+                    }
+                    if (!first) {
+                        entry += ',';
+                    }
+                    first = false;
+                    appendJsonString(entry, kv.key().c_str());
+                    entry += ':';
+                    serializeJson(kv.value(), entry);
+                    position++;
+                    return true;
+                }
+                stage = STAGE_FIELDS;
+                position = 0;
+                break;
+            }
+
+            case STAGE_FIELDS: {
+                if (position >= manager->fields.size()) {
+                    stage = STAGE_FOOTER;
+                    break;
+                }
+
+                size_t index = position++;
+                const ConfigField* field = manager->fields[index];
+                const ConfigManager::FieldSlot& slot = manager->slotAt(index);
+                if (!slot.present) {
+                    break;
+                }
+
+                if (!first) {
+                    entry += ',';
+                }
+                first = false;
+                appendJsonString(entry, field->id);
+                entry += ':';
+                if (field->encrypted) {
+                    String encrypted = "enc:" + manager->encryptValue(slot.value);
+                    appendJsonString(entry, encrypted.c_str());
+                } else {
+                    appendJsonString(entry, slot.value.c_str());
+                }
+                return true;
+            }
+
+            case STAGE_FOOTER:
+                entry = "}}";
+                stage = STAGE_DONE;
+                return true;
+
+            case STAGE_DONE:
+                break;
+        }
+    }
+
+    return false;
+}
+
+size_t ConfigExporter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen) {
+        if (offset >= pending.length()) {
+            offset = 0;
+            if (!next(pending)) {
+                break;
+            }
+        }
+
+        size_t count = pending.length() - offset;
+        if (count > maxLen - written) {
+            count = maxLen - written;
+        }
+        memcpy(buffer + written, pending.c_str() + offset, count);
+        offset += count;
+        written += count;
+    }
+
+    return written;
+}
+
+size_t ConfigExporter::writeTo(Print& out) {
+    size_t total = 0;
+    String entry;
+    while (next(entry)) {
+        total += out.print(entry);
+    }
+    return total;
+}
+
+// ============================================================================
+// ConfigImporter
+// ============================================================================
+
+ConfigImporter::ConfigImporter(ConfigManager* manager)
+    : manager(manager), extras(ION_JSON_BUFFER_SIZE), values(manager->fields.size()),
+      staged(0), objectBits(0), depth(0), inString(false), escape(false),
+      expectKey(false), readingKey(false), capturing(false), inConfig(false),
+      sawConfig(false), failed(false) {
+    extras.to<JsonObject>();
+}
+
+bool ConfigImporter::write(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && !failed; i++) {
+        process((char)data[i]);
+    }
+    return !failed;
+}
+
+bool ConfigImporter::finish() {
+    if (failed) {
+        return false;
+    }
+    if (inString || depth != 0) {
+        return fail("Truncated JSON");
+    }
+    if (!sawConfig) {
+        return fail("Invalid import format: missing 'config' field");
+    }
+    if (values.size() != manager->fields.size()) {
+        return fail("Schema changed during import");
+    }
+
+    return manager->applyImport(extras, values, staged);
+}
+
+bool ConfigImporter::process(char c) {
+    if (inString) {
+        if (capturing || readingKey) {
+            token += c;
+        }
+
+        if (escape) {
+            escape = false;
+        } else if (c == '\\') {
+            escape = true;
+        } else if (c == '"') {
+            inString = false;
+            if (readingKey) {
+                readingKey = false;
+                token.remove(token.length() - 1); // Closing quote
+
+                if (token.indexOf('\\') >= 0) {
+                    PooledJsonDocument key(token.length() + 16);
+                    deserializeJson(key, "\"" + token + "\"");
+                    token = key.as<String>();
+                }
+
+                if (depth == 1) {
+                    rootKey = token;
+                } else if (depth == 2 && inConfig) {
+                    configKey = token;
+                }
+                token = "";
+            }
+        }
+        return true;
+    }
+
+    switch (c) {
+        case '"':
+            inString = true;
+            if (capturing) {
+                token += c;
+            } else if (expectKey) {
+                readingKey = true;
+                expectKey = false;
+                token = "";
+            }
+            return true;
+
+        case ':':
+            if (capturing) {
+                token += c;
+            } else if (inConfig && depth == 2) {
+                capturing = true;
+                token = "";
+            }
+            return true;
+
+        case '{':
+        case '[':
+            if (depth == 0 && c != '{') {
+                return fail("Expected a JSON object");
+            }
+            if (depth >= MAX_DEPTH) {
+                return fail("Nesting too deep");
+            }
+            if (capturing) {
+                token += c;
+            }
+
+            if (c == '{') {
+                objectBits |= (1UL << depth);
+            } else {
+                objectBits &= ~(1UL << depth);
+            }
+            depth++;
+            expectKey = (c == '{') && !capturing;
+
+            if (depth == 2 && c == '{' && rootKey == "config") {
+                inConfig = true;
+                sawConfig = true;
+            }
+            return true;
+
+        case '}':
+        case ']':
+            if (depth == 0) {
+                return fail("Unbalanced JSON");
+            }
+            if (capturing && depth == 2) {
+                if (!commitValue()) {
+                    return false;
+                }
+            } else if (capturing) {
+                token += c;
+            }
+
+            depth--;
+            if (inConfig && depth == 1) {
+                inConfig = false;
+            }
+            expectKey = false;
+            return true;
+
+        case ',':
+            if (capturing && depth == 2) {
+                if (!commitValue()) {
+                    return false;
+                }
+                expectKey = true;
+            } else if (capturing) {
+                token += c;
+            } else {
+                expectKey = depth > 0 && (objectBits & (1UL << (depth - 1)));
+            }
+            return true;
+
+        default:
+            if (capturing) {
+                token += c;
+            } else if (depth == 0 && !isspace((unsigned char)c)) {
+                return fail("Expected a JSON object");
+            }
+            return true;
+    }
+}
+
+bool ConfigImporter::commitValue() {
+    capturing = false;
+    token.trim();
+
+    if (token.isEmpty()) {
+        return fail("Missing value");
+    }
+
+    int index = manager->findField(configKey.c_str());
+    if (index >= 0) {
+        // Schema fields are staged as text, exactly as get() would return them
+        if (token == "null") {
+            // Leave unset
+        } else if (token[0] == '"') {
+            PooledJsonDocument value(token.length() + 16);
+            if (deserializeJson(value, token)) {
+                return fail("Invalid string value");
+            }
+            values[index] = value.as<String>();
+            staged |= (1UL << index);
+        } else {
+            values[index] = token;
+            staged |= (1UL << index);
+        }
+    } else {
+        // Sized to the token (at most one 16-byte node per two characters),
+        // so it leases a small buffer while `extras` holds the large one
+        PooledJsonDocument value(token.length() * 8 + 16);
+        if (deserializeJson(value, token)) {
+            return fail("Invalid value");
+        }
+        extras[configKey] = value.as<JsonVariant>();
+        if (extras.overflowed()) {
+            return fail("Config too large");
+        }
+    }
+
+    token = "";
+    return true;
+}
+
+bool ConfigImporter::fail(const char* message) {
+    if (!failed) {
+        ION_LOG_E("Import failed: %s", message);
+    }
+    failed = true;
+    token = "";
+    return false;
+}
+
+} // namespace IonConnect
@@ -0,0 +1,92 @@
+#ifndef CONFIG_STREAM_H
+#define CONFIG_STREAM_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "../core/IonTypes.h"
+#include "../utils/JsonPool.h"
+
+namespace IonConnect {
+
+class ConfigManager;
+
+/**
+ * @brief Serializes the config backup one entry at a time
+ *
+ * Produces the same document as ConfigManager::exportJSON() without
+ * building it in memory: peak usage is the largest single entry. Feed
+ * read() from a chunked HTTP response, or use writeTo() for any Print.
+ */
+class ConfigExporter {
+public:
+    explicit ConfigExporter(ConfigManager* manager);
+
+    bool next(String& entry);                       // False when done
+    size_t read(uint8_t* buffer, size_t maxLen);    // 0 when done
+    size_t writeTo(Print& out);
+
+private:
+    enum Stage : uint8_t {
+        STAGE_HEADER,
+        STAGE_EXTRAS,
+        STAGE_FIELDS,
+        STAGE_FOOTER,
+        STAGE_DONE
+    };
+
+    ConfigManager* manager;
+    Stage stage;
+    size_t position;
+    bool first;
+    String pending;
+    size_t offset;
+};
+
+/**
+ * @brief Incremental parser for config backups
+ *
+ * Accepts the body in arbitrary chunks (e.g. AsyncWebServer body callbacks)
+ * and only buffers one value at a time. finish() validates every staged
+ * value against its field (type, range, length, pattern, required) before
+ * applying any of them, so a truncated, malformed or invalid upload leaves
+ * the config untouched.
+ */
+class ConfigImporter {
+public:
+    explicit ConfigImporter(ConfigManager* manager);
+
+    bool write(const uint8_t* data, size_t len);    // False once an error is hit
+    bool finish();                                  // Validate and apply
+    bool hasError() const { return failed; }
+
+private:
+    static const uint8_t MAX_DEPTH = 32;            // Depth tracked in a bitmask
+
+    ConfigManager* manager;
+    PooledJsonDocument extras;      // Staged keys outside the schema
+    std::vector<String> values;     // Staged schema values, indexed like fields
+    uint32_t staged;                // Fields present in the upload
+
+    String token;                   // Current key, or raw text of a config value
+    String rootKey;                 // Last key seen in the top-level object
+    String configKey;               // Last key seen in "config"
+    uint32_t objectBits;            // Bit n set: container at depth n+1 is an object
+    uint8_t depth;
+    bool inString;
+    bool escape;
+    bool expectKey;
+    bool readingKey;
+    bool capturing;                 // Collecting a value inside "config"
+    bool inConfig;
+    bool sawConfig;
+    bool failed;
+
+    bool process(char c);
+    bool commitValue();
+    bool fail(const char* message);
+};
+
+} // namespace IonConnect
+
+#endif // CONFIG_STREAM_H
@@ -0,0 +1,109 @@
+#include "ConfigTransaction.h"
+#include "ConfigManager.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+ConfigTransaction::ConfigTransaction(ConfigManager* manager)
+    : manager(manager), generation(manager->schemaGeneration), staged(0),
+      values(manager->fields.size()), aborted(false) {
+}
+
+bool ConfigTransaction::set(const String& key, const String& value) {
+    if (aborted) {
+        return false;
+    }
+
+    // Staged indices are only meaningful under the schema they came from
+    int index = manager->findField(key.c_str());
+    if (generation != manager->schemaGeneration || index >= (int)values.size()) {
+        ION_LOG_E("Schema changed during transaction");
+        abort();
+        return false;
+    }
+
+    if (index >= 0) {
+        values[index] = value;
+        staged |= (1UL << index);
+        return true;
+    }
+
+    // Last write wins, as with repeated ConfigManager::set()
+    for (auto& extra : extras) {
+        if (extra.first == key) {
+            extra.second = value;
+            return true;
+        }
+    }
+    extras.push_back(std::make_pair(key, value));
+    return true;
+}
+
+bool ConfigTransaction::commit() {
+    failed = "";
+
+    if (aborted) {
+        return false;
+    }
+    if (generation != manager->schemaGeneration) {
+        ION_LOG_E("Schema changed during transaction");
+        abort();
+        return false;
+    }
+
+    // Validate the resulting config before touching anything
+    for (size_t i = 0; i < manager->fields.size(); i++) {
+        const ConfigField* field = manager->fields[i];
+        bool ok;
+
+        if (staged & (1UL << i)) {
+            ok = manager->validateField(i, values[i]);
+        } else {
+            const ConfigManager::FieldSlot& slot = manager->slotAt(i);
+            ok = !field->required || (slot.present && !slot.value.isEmpty());
+        }
+
+        if (!ok) {
+            failed = FPSTR(field->id);
+            ION_LOG_W("Validation failed for field: %s", failed.c_str());
+            rollback();
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < values.size(); i++) {
+        if (staged & (1UL << i)) {
+            manager->storeAt(i, values[i]);
+        }
+    }
+    for (const auto& extra : extras) {
+        manager->set(extra.first, extra.second);
+    }
+
+    rollback(); // Clear the side buffer
+    return manager->flushAsync();
+}
+
+void ConfigTransaction::abort() {
+    // Drops what was staged; set() and commit() fail from here on
+    rollback();
+    aborted = true;
+}
+
+void ConfigTransaction::rollback() {
+    staged = 0;
+    for (auto& value : values) {
+        value = String();
+    }
+    extras.clear();
+}
+
+size_t ConfigTransaction::size() const {
+    size_t count = extras.size();
+    for (uint32_t bits = staged; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+} // namespace IonConnect
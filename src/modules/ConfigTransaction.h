@@ -0,0 +1,52 @@
+#ifndef CONFIG_TRANSACTION_H
+#define CONFIG_TRANSACTION_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../core/IonTypes.h"
+
+namespace IonConnect {
+
+class ConfigManager;
+
+/**
+ * @brief Stages several config changes and applies them all-or-nothing
+ *
+ *   ConfigTransaction tx = config->beginTransaction();
+ *   tx.set("wifi_ssid", ssid);
+ *   tx.set("wifi_pass", pass);
+ *   if (!tx.commit()) { ... nothing was changed ... }
+ *
+ * Values are kept in a side buffer until commit(), which validates the
+ * whole set in one pass and persists it with a single storage commit
+ * (on the commit worker, when the manager has one).
+ * A transaction that is never committed has no effect. If another schema
+ * is loaded while it is open, the transaction fails: set() and commit()
+ * return false and nothing is applied.
+ */
+class ConfigTransaction {
+public:
+    explicit ConfigTransaction(ConfigManager* manager);
+
+    bool set(const String& key, const String& value);
+    bool commit();
+    void rollback();
+
+    size_t size() const;                    // Number of staged keys
+    const String& failedKey() const { return failed; }
+
+private:
+    ConfigManager* manager;
+    uint16_t generation;                    // Schema the staged indices refer to
+    uint32_t staged;                        // Schema fields with a staged value
+    std::vector<String> values;             // Indexed like the schema fields
+    std::vector<std::pair<String, String>> extras;  // Keys outside the schema
+    String failed;
+    bool aborted;                           // Schema changed under the transaction
+
+    void abort();
+};
+
+} // namespace IonConnect
+
+#endif // CONFIG_TRANSACTION_H
@@ -1,5 +1,7 @@
 #include "DiagnosticsCollector.h"
 #include "../utils/Logger.h"
+#include "../utils/JsonPool.h"
+#include "../storage/StorageNVS.h"
 
 #if ION_ENABLE_DIAGNOSTICS
 
@@ -41,12 +43,17 @@ String DiagnosticsCollector::getJSON() {
     json += "\"heapFree\":" + String(data.heapFree) + ",";
     json += "\"heapSize\":" + String(data.heapSize) + ",";
     json += "\"heapMinFree\":" + String(data.heapMinFree) + ",";
+    json += "\"jsonPoolPeak\":" + String(data.jsonPoolPeak) + ",";
+    json += "\"jsonPoolFallbacks\":" + String(data.jsonPoolFallbacks) + ",";
     json += "\"rssi\":" + String(data.rssi) + ",";
     json += "\"wifiReconnects\":" + String(data.wifiReconnects) + ",";
     json += "\"wifiConnectedTime\":" + String(data.wifiConnectedTime) + ",";
     json += "\"uptime\":" + String(data.uptime) + ",";
     json += "\"cpuFreq\":" + String(data.cpuFreq) + ",";
     json += "\"cpuLoad\":" + String(data.cpuLoad, 2) + ",";
+    json += "\"storageWrites\":" + String(data.storageWrites) + ",";
+    json += "\"storageWriteBytes\":" + String(data.storageWriteBytes) + ",";
+    json += "\"storageCommits\":" + String(data.storageCommits) + ",";
     json += "\"apiRequests\":" + String(data.apiRequests) + ",";
     json += "\"apiErrors\":" + String(data.apiErrors) + ",";
     json += "\"portalSessions\":" + String(data.portalSessions) + ",";
@@ -85,6 +92,10 @@ void DiagnosticsCollector::collectMemoryStats() {
         data.heapSize = 81920; // ESP8266 typical heap size
         data.heapMinFree = 0; // Not available on ESP8266
     #endif
+    
+    JsonPool::Stats pool = JsonPool::getStats();
+    data.jsonPoolPeak = pool.peakLeased;
+    data.jsonPoolFallbacks = pool.fallbacks + pool.failures;
 }
 
 void DiagnosticsCollector::collectWiFiStats() {
@@ -106,6 +117,13 @@ void DiagnosticsCollector::collectSystemStats() {
     
     // Simple CPU load calculation (not very accurate)
     data.cpuLoad = 0.0f; // Would need more complex implementation
+    
+    #if ION_PLATFORM_ESP32
+        StorageNVS::Stats nvs = StorageNVS::getStats();
+        data.storageWrites = nvs.writes;
+        data.storageWriteBytes = nvs.bytes;
+        data.storageCommits = nvs.commits;
+    #endif
 }
 
 } // namespace IonConnect
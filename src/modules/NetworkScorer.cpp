@@ -0,0 +1,24 @@
+#include "NetworkScorer.h"
+
+namespace IonConnect {
+
+int32_t WeightedScoringPolicy::score(const WiFiCredential& net, const NetworkInfo& seen) {
+    int32_t score = seen.rssi + net.priority * PRIORITY_WEIGHT;
+    
+    // No history yet counts as reliable
+    if (net.attempts) {
+        score -= (int32_t)(net.attempts - net.successes) * FAILURE_RATE_PENALTY / net.attempts;
+    }
+    
+    int32_t slow = net.connectTime / 1000 * SLOW_CONNECT_PENALTY;
+    score -= slow < SLOW_CONNECT_MAX ? slow : SLOW_CONNECT_MAX;
+    
+    if (failedRecently(net)) {
+        int32_t streak = net.failStreak * STREAK_PENALTY;
+        score -= streak < STREAK_MAX ? streak : STREAK_MAX;
+    }
+    
+    return score;
+}
+
+} // namespace IonConnect
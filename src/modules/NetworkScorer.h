@@ -0,0 +1,67 @@
+#ifndef NETWORK_SCORER_H
+#define NETWORK_SCORER_H
+
+#include <Arduino.h>
+#include "../core/IonTypes.h"
+
+namespace IonConnect {
+
+/**
+ * @brief Ranks saved networks found by a scan
+ *
+ * WiFiConnectionCore scores each saved network by its strongest AP in the
+ * last scan and joins the highest score. It stays on the network it used
+ * last unless another one scores at least the hysteresis higher (see
+ * IonConfig::scoringHysteresis). Scores are in points comparable to dB of
+ * RSSI. Derive from this class for a custom policy.
+ */
+class ScoringPolicy {
+public:
+    static const uint32_t FAILURE_WINDOW = 300000;  // Failures older than this are forgiven
+    
+    virtual ~ScoringPolicy() {}
+    
+    // Higher is better. `seen` is the network's AP in the scan cache, with
+    // RSSI averaged over recent scans.
+    virtual int32_t score(const WiFiCredential& net, const NetworkInfo& seen) = 0;
+    
+    static bool failedRecently(const WiFiCredential& net) {
+        return net.failStreak && millis() - net.lastFailure < FAILURE_WINDOW;
+    }
+};
+
+/**
+ * @brief Strongest signal wins (SCORING_RSSI)
+ */
+class RSSIScoringPolicy : public ScoringPolicy {
+public:
+    int32_t score(const WiFiCredential& net, const NetworkInfo& seen) override {
+        return seen.rssi;
+    }
+};
+
+/**
+ * @brief Default policy (SCORING_WEIGHTED)
+ *
+ * Starts from the RSSI and adds the network's priority, then subtracts
+ * for a low success rate over recent attempts, for a slow average
+ * connect, and for each failure in a row within FAILURE_WINDOW. A network
+ * that drops soon after joining counts as a failure, so an AP that looks
+ * strong but does not hold a link loses to a slightly weaker stable one.
+ */
+class WeightedScoringPolicy : public ScoringPolicy {
+public:
+    int32_t score(const WiFiCredential& net, const NetworkInfo& seen) override;
+    
+private:
+    static const int32_t PRIORITY_WEIGHT = 2;       // Per priority level
+    static const int32_t FAILURE_RATE_PENALTY = 30; // At 0% success
+    static const int32_t SLOW_CONNECT_PENALTY = 2;  // Per second to connect
+    static const int32_t SLOW_CONNECT_MAX = 10;
+    static const int32_t STREAK_PENALTY = 10;       // Per recent failure in a row
+    static const int32_t STREAK_MAX = 40;
+};
+
+} // namespace IonConnect
+
+#endif // NETWORK_SCORER_H
@@ -81,6 +81,15 @@ void PluginRegistry::initAll(IonConnectBase* ion) {
     initialized = true;
 }
 
+void PluginRegistry::subscribeAll(ConfigManager* config) {
+    for (auto& pair : plugins) {
+        IonPlugin* plugin = pair.second;
+        config->onChange(plugin->getConfigInterest(), [plugin](const String& key, const String& value) {
+            plugin->onConfigChanged(key, value);
+        });
+    }
+}
+
 void PluginRegistry::handleAll() {
     for (auto& pair : plugins) {
         pair.second->handle();
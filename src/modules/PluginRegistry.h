@@ -8,6 +8,7 @@
 #include <vector>
 #include <map>
 #include "../plugins/IonPlugin.h"
+#include "ConfigManager.h"
 
 #if ION_PLATFORM_ESP32
     #include <ESPAsyncWebServer.h>
@@ -34,6 +35,7 @@ public:
     std::vector<IonPlugin*> getAllPlugins();
     
     void initAll(IonConnectBase* ion);
+    void subscribeAll(ConfigManager* config);   // Config events by plugin interest
     void handleAll();
     void registerAllRoutes(AsyncWebServer* server);
     String getAllUIPanels();
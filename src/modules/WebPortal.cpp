@@ -1,6 +1,8 @@
 #include "WebPortal.h"
 #include "../utils/Logger.h"
+#include "../utils/JsonPool.h"
 #include <ArduinoJson.h>
+#include <memory>
 
 namespace IonConnect {
 
@@ -68,6 +70,10 @@ bool WebPortal::stop() {
     return true;
 }
 
+void WebPortal::setKeepFilesystemMounted(bool keep) {
+    assetManager->setKeepMounted(keep);
+}
+
 bool WebPortal::isRunning() {
     return running;
 }
@@ -90,6 +96,12 @@ void WebPortal::broadcastStatus(const String& state, const String& ssid,
     ION_LOG("Broadcast status: %s", state.c_str());
 }
 
+void WebPortal::broadcastCommit(bool success) {
+    if (!running || !events) return;
+    
+    events->send(success ? "{\"success\":true}" : "{\"success\":false}", "saved", millis());
+}
+
 #if ION_ENABLE_DIAGNOSTICS
 void WebPortal::setDiagnosticsCollector(DiagnosticsCollector* diag) {
     diagnostics = diag;
@@ -167,9 +179,7 @@ void WebPortal::setupAPIRoutes() {
     
     server->on("/api/import", HTTP_POST, [](AsyncWebServerRequest* request) {},
         NULL, [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
-            if (index + len == total) {
-                handleImport(request, data, total);
-            }
+            handleImport(request, data, len, index, total);
         });
     
     server->on("/api/reboot", HTTP_POST, [this](AsyncWebServerRequest* request) {
@@ -223,15 +233,16 @@ void WebPortal::handleConfig(AsyncWebServerRequest* request) {
     #endif
     
     // Don't send passwords
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE);
     JsonObject root = doc.to<JsonObject>();
     
-    auto fields = config->getFields();
-    for (auto field : fields) {
-        if (field->type != "password" && !field->encrypted) {
-            String value = config->get(field->id);
+    for (size_t i = 0; i < config->getFieldCount(); i++) {
+        const ConfigField* field = config->getFieldAt(i);
+        if (field->inputType != FIELD_PASSWORD && !field->encrypted) {
+            String id(FPSTR(field->id));
+            String value = config->get(id);
             if (!value.isEmpty()) {
-                root[field->id] = value;
+                root[id] = value;
             }
         }
     }
@@ -256,7 +267,7 @@ void WebPortal::handleConfigPost(AsyncWebServerRequest* request, uint8_t* data,
         body += (char)data[i];
     }
     
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE);
     DeserializationError error = deserializeJson(doc, body);
     
     if (error) {
@@ -266,20 +277,18 @@ void WebPortal::handleConfigPost(AsyncWebServerRequest* request, uint8_t* data,
     
     JsonObject root = doc.as<JsonObject>();
     
-    // Save each field
+    // Stage every field, then validate and save them together
+    ConfigTransaction tx = config->beginTransaction();
     for (JsonPair kv : root) {
-        config->set(kv.key().c_str(), kv.value().as<String>());
-    }
-    
-    // Validate
-    if (!config->validate()) {
-        sendError(request, "Validation failed");
-        return;
+        tx.set(kv.key().c_str(), kv.value().as<String>());
     }
     
-    // Save to storage
-    if (!config->save()) {
-        sendError(request, "Failed to save");
+    if (!tx.commit()) {
+        if (!tx.failedKey().isEmpty()) {
+            sendError(request, "Validation failed: " + tx.failedKey());
+        } else {
+            sendError(request, "Failed to save");
+        }
         return;
     }
     
@@ -309,9 +318,11 @@ void WebPortal::handleNetworks(AsyncWebServerRequest* request) {
     if (diagnostics) diagnostics->incrementCounter("api_requests");
     #endif
     
-    auto networks = wifi->getScanResults();
+    // Cached; a stale list starts a background scan
+    std::vector<NetworkInfo> networks = wifi->getScanResults();
+    uint32_t age = wifi->getScanAge();
     
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE);
     JsonArray arr = doc["networks"].to<JsonArray>();
     
     for (const auto& net : networks) {
@@ -323,6 +334,7 @@ void WebPortal::handleNetworks(AsyncWebServerRequest* request) {
     }
     
     doc["timestamp"] = millis() / 1000;
+    doc["age"] = age == UINT32_MAX ? -1 : (int32_t)(age / 1000);
     
     String json;
     serializeJson(doc, json);
@@ -330,7 +342,7 @@ void WebPortal::handleNetworks(AsyncWebServerRequest* request) {
 }
 
 void WebPortal::handleStatus(AsyncWebServerRequest* request) {
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
     
     doc["connected"] = wifi->isConnected();
     doc["ssid"] = wifi->getSSID();
@@ -354,7 +366,7 @@ void WebPortal::handleClear(AsyncWebServerRequest* request) {
         return;
     }
     
-    config->clear();
+    config->clearAsync();
     sendJSON(request, "{\"success\":true}");
 }
 
@@ -364,25 +376,51 @@ void WebPortal::handleExport(AsyncWebServerRequest* request) {
         return;
     }
     
-    String json = config->exportJSON();
-    
-    AsyncWebServerResponse* response = request->beginResponse(200, "application/json", json);
+    // Chunked: the backup is generated as the client reads it
+    std::shared_ptr<ConfigExporter> exporter(new ConfigExporter(config));
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+        [exporter](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return exporter->read(buffer, maxLen);
+        });
     response->addHeader("Content-Disposition", "attachment; filename=ionconnect-config.json");
     request->send(response);
 }
 
-void WebPortal::handleImport(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
-    if (!checkAuth(request)) {
-        sendError(request, "Unauthorized", 401);
+void WebPortal::handleImport(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                             size_t index, size_t total) {
+    // The parser lives in the request, so concurrent uploads each get their
+    // own. The server frees _tempObject with free(), so it is deleted here
+    // on completion, or by the disconnect handler if the client goes away
+    // part way (which runs before the request is destroyed).
+    ConfigImporter* importer = static_cast<ConfigImporter*>(request->_tempObject);
+    if (index == 0 && !importer && checkAuth(request)) {
+        // New upload: parse chunks as they arrive instead of buffering the body
+        importer = new ConfigImporter(config);
+        request->_tempObject = importer;
+        request->onDisconnect([request]() {
+            delete static_cast<ConfigImporter*>(request->_tempObject);
+            request->_tempObject = nullptr;
+        });
+    }
+    
+    if (importer) {
+        importer->write(data, len);
+    }
+    
+    if (index + len < total) {
         return;
     }
     
-    String body = "";
-    for (size_t i = 0; i < len; i++) {
-        body += (char)data[i];
+    if (!importer) {
+        sendError(request, "Unauthorized", 401);
+        return;
     }
     
-    if (config->importJSON(body)) {
+    bool success = importer->finish();
+    delete importer;
+    request->_tempObject = nullptr;
+    
+    if (success) {
         sendJSON(request, "{\"success\":true}");
     } else {
         sendError(request, "Import failed");
@@ -396,12 +434,13 @@ void WebPortal::handleReboot(AsyncWebServerRequest* request) {
     }
     
     sendJSON(request, "{\"rebooting\":true}");
+    config->flush();
     delay(1000);
     ESP.restart();
 }
 
 void WebPortal::handleInfo(AsyncWebServerRequest* request) {
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE / 2);
     
     #if ION_PLATFORM_ESP32
         doc["platform"] = "ESP32";
@@ -39,10 +39,13 @@ public:
     
     bool isRunning();
     uint16_t getPort();
+    AsyncWebServer* getServer() { return server; }   // For plugin routes
+    void setKeepFilesystemMounted(bool keep);       // Don't unmount LittleFS on stop()
     
     // Event Broadcasting
     void broadcastStatus(const String& state, const String& ssid = "", 
                         const String& ip = "", const String& message = "");
+    void broadcastCommit(bool success);     // "saved" event once a save reaches flash
     
     #if ION_ENABLE_DIAGNOSTICS
     void setDiagnosticsCollector(DiagnosticsCollector* diag);
@@ -81,7 +84,8 @@ private:
     void handleStatus(AsyncWebServerRequest* request);
     void handleClear(AsyncWebServerRequest* request);
     void handleExport(AsyncWebServerRequest* request);
-    void handleImport(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+    void handleImport(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                      size_t index, size_t total);
     void handleReboot(AsyncWebServerRequest* request);
     void handleInfo(AsyncWebServerRequest* request);
     
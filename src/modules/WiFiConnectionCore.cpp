@@ -1,99 +1,345 @@
 #include "WiFiConnectionCore.h"
 #include "../utils/Logger.h"
+#include "../utils/JsonPool.h"
+#include "../utils/Crypto.h"
 #include <ArduinoJson.h>
 
 namespace IonConnect {
-
+    
 #if ION_PLATFORM_ESP32
 WiFiConnectionCore* WiFiConnectionCore::instance = nullptr;
 #endif
-
+    
+// The scan cache is read by the web server and BLE tasks while handle()
+// merges into it
+#if ION_PLATFORM_ESP32
+    #define SCAN_LOCK()   xSemaphoreTake(scanLock, portMAX_DELAY)
+    #define SCAN_UNLOCK() xSemaphoreGive(scanLock)
+#else
+    #define SCAN_LOCK()
+    #define SCAN_UNLOCK()
+#endif
+    
+const char* WiFiConnectionCore::KEY_NETWORKS = "wifi_nets";
+const uint8_t WiFiConnectionCore::NETWORKS_VERSION; // Bound to a reference by push_back()
+    
 WiFiConnectionCore::WiFiConnectionCore(ConfigManager* config)
     : config(config), state(WIFI_IDLE), previousState(WIFI_IDLE),
       reconnectAttempts(0), maxReconnectAttempts(5), lastReconnectTime(0),
       reconnectDelay(1000), connectionTimeout(10000), connectionStartTime(0),
-      connectedTime(0), scanInProgress(false), scanComplete(false) {
-    
+      connectedTime(0), scanInProgress(false), scanComplete(false), scanMerged(true),
+      scanForConnect(false), scanStartTime(0), fastConnect(false), fastFailed(false),
+      linkDropped(false), defaultIPMode(IP_DHCP), staticApplied(false), leaseApplied(false),
+      renewingLease(false), renewStartTime(0), gotIP(false), scanCacheTime(0), scanRequested(false),
+      scoringPolicy(nullptr), scoringHysteresis(0), settling(false) {
+        
     #if ION_PLATFORM_ESP32
     instance = this;
+    scanLock = xSemaphoreCreateMutex();
     #endif
 }
-
+    
 WiFiConnectionCore::~WiFiConnectionCore() {
     end();
+    #if ION_PLATFORM_ESP32
+    vSemaphoreDelete(scanLock);
+    #endif
 }
-
+    
 bool WiFiConnectionCore::begin() {
     WiFi.mode(WIFI_STA);
     WiFi.setAutoReconnect(false); // We handle reconnection
-    
+        
+    // Driver events only raise flags; handle() acts on them
     #if ION_PLATFORM_ESP32
     WiFi.onEvent(wifiEventHandler);
     #elif ION_PLATFORM_ESP8266
     connectHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& event) {
         ION_LOG("WiFi connected - IP: %s", WiFi.localIP().toString().c_str());
-        setState(WIFI_CONNECTED);
-        if (connectCallback) connectCallback();
+        gotIP = true;
     });
-    
+        
     disconnectHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& event) {
         ION_LOG("WiFi disconnected");
-        if (state == WIFI_CONNECTED) {
-            setState(WIFI_RECONNECTING);
-            if (disconnectCallback) disconnectCallback();
-        }
+        linkDropped = true;
     });
     #endif
-    
+        
     loadNetworks();
-    
+        
     ION_LOG("WiFiConnectionCore initialized");
     return true;
 }
-
+    
 void WiFiConnectionCore::handle() {
+    // Scans asked for from any task start here; one now would delay the
+    // join in progress
+    SCAN_LOCK();
+    bool requested = scanRequested && state != WIFI_CONNECTING;
+    if (requested) scanRequested = false;
+    SCAN_UNLOCK();
+    if (requested && !scanInProgress) {
+        launchScan();
+    }
+        
+    pollScan();
     handleStateTransition();
 }
-
+    
 void WiFiConnectionCore::end() {
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
 }
-
+    
 bool WiFiConnectionCore::connect(const String& ssid, const String& password) {
-    ION_LOG("Connecting to: %s", ssid.c_str());
+    // Add/update in saved networks; the cached BSSID is kept only if the
+    // credentials are unchanged
+    WiFiCredential* existing = findNetwork(ssid);
+    bool useCache = existing && existing->password == password;
+    addNetwork(ssid, password, 10);
+        
+    fastFailed = false;
+    beginConnect(*findNetwork(ssid), useCache);
+    return true;
+}
+    
+bool WiFiConnectionCore::connectToBest() {
+    if (savedNetworks.empty()) {
+        ION_LOG("No known networks found");
+        return false;
+    }
+        
+    // Rejoin the last network directly; scan only if that failed already
+    WiFiCredential* cached = fastFailed ? nullptr : findCachedNetwork();
+    if (cached) {
+        return beginConnect(*cached, true);
+    }
+        
+    return startConnectScan();
+}
     
+bool WiFiConnectionCore::beginConnect(const WiFiCredential& net, bool useCache) {
+    scanForConnect = false;
+    fastConnect = useCache && net.channel != 0;
+    attemptSSID = net.ssid;
     setState(WIFI_CONNECTING);
     connectionStartTime = millis();
+    applyIPSettings(net);
+        
+    if (fastConnect) {
+        ION_LOG("Connecting to: %s (channel %d, cached BSSID)", net.ssid.c_str(), net.channel);
+        WiFi.begin(net.ssid.c_str(), net.password.c_str(), net.channel, net.bssid);
+    } else {
+        ION_LOG("Connecting to: %s", net.ssid.c_str());
+        WiFi.begin(net.ssid.c_str(), net.password.c_str());
+    }
+    return true;
+}
     
-    WiFi.begin(ssid.c_str(), password.c_str());
-    
-    // Add/update in saved networks
-    addNetwork(ssid, password, 10);
-    
+bool WiFiConnectionCore::startConnectScan() {
+    // A scan already running (e.g. from the portal) is as good as a new one
+    if (!scanInProgress && !launchScan()) {
+        return false;
+    }
+        
+    scanForConnect = true;
+    scanStartTime = millis();
+    setState(WIFI_SCANNING);
     return true;
 }
-
-bool WiFiConnectionCore::connectToBest() {
-    WiFiCredential* best = findBestNetwork();
     
+void WiFiConnectionCore::finishConnectScan() {
+    scanForConnect = false;
+        
+    WiFiCredential* best = findBestNetwork();
     if (!best) {
         ION_LOG("No known networks found");
-        return false;
+        setState(WIFI_RECONNECTING); // Next attempt after the backoff
+        return;
     }
-    
+        
     ION_LOG("Connecting to best network: %s (RSSI: %d)", 
             best->ssid.c_str(), best->lastRSSI);
+        
+    // Known network: reconnecting must not rewrite its priority. This is
+    // the attempt's fallback join, so the driver finds the AP itself: a
+    // cached join failing here would only start another scan.
+    beginConnect(*best, false);
+}
+    
+void WiFiConnectionCore::recordAssociation() {
+    resetBackoff();
+    connectedTime = millis();
+    fastFailed = false;
+        
+    // Update network info, including where to find it next time
+    WiFiCredential* net = findNetwork(WiFi.SSID());
+    if (net) {
+        lastSSID = net->ssid;
+        settling = true;
+        recordAttempt(*net, true);
+        uint32_t joinTime = millis() - connectionStartTime;
+        if (joinTime > 0xFFFF) joinTime = 0xFFFF;
+        net->connectTime = net->connectTime ? (net->connectTime + joinTime) / 2 : joinTime;
+        net->lastRSSI = WiFi.RSSI();
+        net->channel = WiFi.channel();
+        const uint8_t* bssid = WiFi.BSSID();
+        if (bssid) {
+            memcpy(net->bssid, bssid, sizeof(net->bssid));
+        } else {
+            net->channel = 0;
+        }
+            
+        // Numbered rather than timed: millis() starts over on every boot,
+        // and findIncumbent() compares joins from earlier boots
+        uint32_t sequence = 0;
+        for (const auto& other : savedNetworks) {
+            if (other.lastConnected > sequence) sequence = other.lastConnected;
+        }
+        net->lastConnected = sequence + 1;
+            
+        // A lease from DHCP is cached for the next connect
+        if (ipModeOf(*net) == IP_CACHED_LEASE && !leaseApplied) {
+            storeLease(*net);
+        }
+        saveNetworks();
+    }
+}
     
-    return connect(best->ssid, best->password);
+void WiFiConnectionCore::recordAttempt(WiFiCredential& net, bool success) {
+    // Recent attempts weigh most: the history is halved when the window fills
+    if (net.attempts >= HISTORY_WINDOW) {
+        net.attempts /= 2;
+        net.successes /= 2;
+    }
+    net.attempts++;
+        
+    if (success) {
+        net.successes++; // The streak ends once the link holds (see settling)
+    } else {
+        if (net.failStreak < 0xFF) net.failStreak++;
+        net.lastFailure = millis();
+    }
 }
-
+    
+IPMode WiFiConnectionCore::ipModeOf(const WiFiCredential& net) {
+    return net.ipMode == IP_DEFAULT ? defaultIPMode : net.ipMode;
+}
+    
+void WiFiConnectionCore::applyIPSettings(const WiFiCredential& net) {
+    IPMode mode = ipModeOf(net);
+    const IPSettings* settings = nullptr;
+        
+    if (mode == IP_STATIC) {
+        settings = net.ipMode == IP_STATIC ? &net.ipSettings : &defaultStaticIP;
+        if (!settings->isSet()) {
+            ION_LOG_W("No static IP for %s, using DHCP", net.ssid.c_str());
+            settings = nullptr;
+        }
+    } else if (mode == IP_CACHED_LEASE && net.ipSettings.isSet()) {
+        settings = &net.ipSettings;
+    }
+        
+    leaseApplied = mode == IP_CACHED_LEASE && settings;
+    renewingLease = false;
+        
+    if (settings) {
+        ION_LOG("Using %s IP %s", leaseApplied ? "cached" : "static",
+                settings->ip.toString().c_str());
+        WiFi.config(settings->ip, settings->gateway, settings->subnet, settings->dns);
+        staticApplied = true;
+    } else if (staticApplied) {
+        // Back to DHCP after a network with fixed addresses
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        staticApplied = false;
+    }
+}
+    
+bool WiFiConnectionCore::storeLease(WiFiCredential& net) {
+    // Returns whether the lease differs from the cached one
+    IPSettings lease;
+    lease.ip = WiFi.localIP();
+    lease.gateway = WiFi.gatewayIP();
+    lease.subnet = WiFi.subnetMask();
+    lease.dns = WiFi.dnsIP(0);
+        
+    bool changed = (uint32_t)lease.ip != (uint32_t)net.ipSettings.ip ||
+                   (uint32_t)lease.gateway != (uint32_t)net.ipSettings.gateway ||
+                   (uint32_t)lease.subnet != (uint32_t)net.ipSettings.subnet ||
+                   (uint32_t)lease.dns != (uint32_t)net.ipSettings.dns;
+    net.ipSettings = lease;
+    return changed;
+}
+    
+bool WiFiConnectionCore::handleLease() {
+    // Returns false when renewing failed and the connection is unusable
+    if (leaseApplied && !renewingLease && millis() - connectedTime >= LEASE_CONFIRM_DELAY) {
+        // Confirm the cached lease in the background: the link stays up
+        // while DHCP runs. Only the got-IP event says it is done; until then
+        // the ESP8266 keeps the cached address and the ESP32 reports none.
+        ION_LOG("Renewing cached DHCP lease");
+        renewingLease = true;
+        renewStartTime = millis();
+        gotIP = false;
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        staticApplied = false;
+        return true;
+    }
+        
+    if (!renewingLease) {
+        return true;
+    }
+        
+    WiFiCredential* net = findNetwork(lastSSID);
+    if (gotIP && WiFi.status() == WL_CONNECTED) {
+        leaseApplied = false;
+        renewingLease = false;
+        if (net && storeLease(*net)) {
+            ION_LOG("DHCP lease changed: %s", net->ipSettings.ip.toString().c_str());
+            saveNetworks();
+        }
+        return true;
+    }
+        
+    if (millis() - renewStartTime > connectionTimeout) {
+        // No lease: the cached one is no good either
+        ION_LOG_W("DHCP renewal timeout");
+        leaseApplied = false;
+        renewingLease = false;
+        if (net) {
+            net->ipSettings = IPSettings();
+            saveNetworks();
+        }
+        return false;
+    }
+    return true;
+}
+    
+WiFiCredential* WiFiConnectionCore::findCachedNetwork() {
+    // The network of the last connection, else the preferred one with a
+    // cached association (e.g. after a reboot). Networks failing again and
+    // again are left to a scan, where the policy can pick another.
+    WiFiCredential* last = lastSSID.isEmpty() ? nullptr : findNetwork(lastSSID);
+    if (last && last->channel != 0) {
+        return isFlapping(*last) ? nullptr : last;
+    }
+        
+    WiFiCredential* best = nullptr;
+    for (auto& net : savedNetworks) {
+        if (net.channel != 0 && !isFlapping(net) &&
+            (!best || net.priority > best->priority)) {
+            best = &net;
+        }
+    }
+    return best;
+}
+    
 bool WiFiConnectionCore::disconnect() {
     WiFi.disconnect();
     setState(WIFI_DISCONNECTED);
     return true;
 }
-
+    
 bool WiFiConnectionCore::addNetwork(const String& ssid, const String& password, int8_t priority) {
     // Check if already exists
     WiFiCredential* existing = findNetwork(ssid);
@@ -104,10 +350,10 @@ bool WiFiConnectionCore::addNetwork(const String& ssid, const String& password,
         WiFiCredential cred(ssid, password, priority);
         savedNetworks.push_back(cred);
     }
-    
+        
     return saveNetworks();
 }
-
+    
 bool WiFiConnectionCore::removeNetwork(const String& ssid) {
     for (auto it = savedNetworks.begin(); it != savedNetworks.end(); ++it) {
         if (it->ssid == ssid) {
@@ -117,48 +363,176 @@ bool WiFiConnectionCore::removeNetwork(const String& ssid) {
     }
     return false;
 }
-
+    
 std::vector<WiFiCredential> WiFiConnectionCore::getSavedNetworks() {
     return savedNetworks;
 }
-
-bool WiFiConnectionCore::saveNetworks() {
-    if (!config) return false;
     
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
-    JsonArray arr = doc.to<JsonArray>();
+bool WiFiConnectionCore::saveNetworks() {
+    return writeNetworks(NETWORKS_VERSION) && config->save();
+}
     
+bool WiFiConnectionCore::writeNetworks(uint8_t header) {
+    if (!config) return false;
+        
+    std::vector<uint8_t> data;
+    data.reserve(2 + savedNetworks.size() * 76);
+    data.push_back(header);
+    data.push_back(savedNetworks.size());
+        
     for (const auto& net : savedNetworks) {
-        JsonObject obj = arr.createNestedObject();
-        obj["ssid"] = net.ssid;
-        obj["pass"] = net.password;
-        obj["priority"] = net.priority;
-        obj["lastConnected"] = net.lastConnected;
-        obj["lastRSSI"] = net.lastRSSI;
+        uint8_t ssidLen = net.ssid.length() < 255 ? net.ssid.length() : 255;
+        uint8_t passLen = net.password.length() < 255 ? net.password.length() : 255;
+            
+        data.push_back(ssidLen);
+        data.insert(data.end(), net.ssid.c_str(), net.ssid.c_str() + ssidLen);
+        data.push_back(passLen);
+        size_t pass = data.size();
+        data.resize(pass + net.password.length());
+        Crypto::encryptBytes(net.password, &data[pass]);
+        data.resize(pass + passLen);
+        data.push_back((uint8_t)net.priority);
+        for (int i = 0; i < 4; i++) {
+            data.push_back((net.lastConnected >> (i * 8)) & 0xFF);
+        }
+        data.push_back((uint8_t)net.lastRSSI);
+        data.push_back(net.channel);
+        data.insert(data.end(), net.bssid, net.bssid + sizeof(net.bssid));
+        data.push_back(net.ipMode);
+        const IPAddress* addresses[] = {
+            &net.ipSettings.ip, &net.ipSettings.gateway, &net.ipSettings.subnet, &net.ipSettings.dns
+        };
+        for (const IPAddress* address : addresses) {
+            for (int i = 0; i < 4; i++) {
+                data.push_back((*address)[i]);
+            }
+        }
+        data.push_back(net.attempts);
+        data.push_back(net.successes);
+        data.push_back(net.connectTime & 0xFF);
+        data.push_back(net.connectTime >> 8);
     }
+        
+    return config->setBytes(KEY_NETWORKS, data.data(), data.size());
+}
     
-    String json;
-    serializeJson(doc, json);
-    
-    config->set("saved_networks", json);
-    return config->save();
+bool WiFiConnectionCore::setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings) {
+    WiFiCredential* net = findNetwork(ssid);
+    if (!net) {
+        return false;
+    }
+        
+    // For IP_CACHED_LEASE, `settings` seeds the cache (empty: wait for DHCP)
+    net->ipMode = mode;
+    net->ipSettings = settings;
+    return saveNetworks();
 }
-
+    
 bool WiFiConnectionCore::loadNetworks() {
     if (!config) return false;
+        
+    size_t len = config->getBytesLength(KEY_NETWORKS);
+    if (len == 0) {
+        return loadLegacyNetworks();
+    }
+        
+    std::vector<uint8_t> data(len);
+    if (config->getBytes(KEY_NETWORKS, data.data(), len) != len || !decodeNetworks(data.data(), len)) {
+        ION_LOG_W("Failed to load saved networks");
+        savedNetworks.clear();
+        return false;
+    }
+        
+    ION_LOG("Loaded %d saved networks", savedNetworks.size());
+    if (data[0] & NETWORKS_CONVERTING) {
+        return finishConversion();
+    }
+    return true;
+}
     
-    String json = config->get("saved_networks", "[]");
-    DynamicJsonDocument doc(ION_JSON_BUFFER_SIZE);
+bool WiFiConnectionCore::decodeNetworks(const uint8_t* data, size_t len) {
+    // Older versions are read as is; the next save writes the current one
+    if (len < 2) {
+        return false;
+    }
+    uint8_t version = data[0] & ~NETWORKS_CONVERTING;
+    if (version == 0 || version > NETWORKS_VERSION) {
+        return false;
+    }
+        
+    savedNetworks.clear();
+    uint8_t count = data[1];
+    size_t pos = 2;
+        
+    for (uint8_t n = 0; n < count; n++) {
+        WiFiCredential cred;
+            
+        if (pos >= len || pos + 1 + data[pos] > len) return false;
+        cred.ssid.concat((const char*)&data[pos + 1], data[pos]);
+        pos += 1 + data[pos];
+            
+        if (pos >= len || pos + 1 + data[pos] > len) return false;
+        cred.password = Crypto::decryptBytes(&data[pos + 1], data[pos]);
+        pos += 1 + data[pos];
+            
+        if (pos + 6 > len) return false;
+        cred.priority = (int8_t)data[pos];
+        cred.lastConnected = data[pos + 1] | ((uint32_t)data[pos + 2] << 8) |
+                             ((uint32_t)data[pos + 3] << 16) | ((uint32_t)data[pos + 4] << 24);
+        cred.lastRSSI = (int8_t)data[pos + 5];
+        pos += 6;
+            
+        if (version >= 2) {
+            if (pos + 7 > len) return false;
+            cred.channel = data[pos];
+            memcpy(cred.bssid, &data[pos + 1], sizeof(cred.bssid));
+            pos += 7;
+        }
+            
+        if (version >= 3) {
+            if (pos + 17 > len || data[pos] > IP_CACHED_LEASE) return false;
+            cred.ipMode = (IPMode)data[pos];
+            IPAddress* addresses[] = {
+                &cred.ipSettings.ip, &cred.ipSettings.gateway, &cred.ipSettings.subnet, &cred.ipSettings.dns
+            };
+            for (int i = 0; i < 4; i++) {
+                const uint8_t* b = &data[pos + 1 + i * 4];
+                *addresses[i] = IPAddress(b[0], b[1], b[2], b[3]);
+            }
+            pos += 17;
+        }
+            
+        if (version >= 4) {
+            if (pos + 4 > len) return false;
+            cred.attempts = data[pos];
+            cred.successes = data[pos + 1];
+            cred.connectTime = data[pos + 2] | (data[pos + 3] << 8);
+            pos += 4;
+        }
+            
+        savedNetworks.push_back(cred);
+    }
+    return true;
+}
     
+bool WiFiConnectionCore::loadLegacyNetworks() {
+    // Before the binary record, networks were JSON in the config blob
+    String json = config->get("saved_networks", "");
+    if (json.isEmpty()) {
+        savedNetworks.clear();
+        return true;
+    }
+        
+    PooledJsonDocument doc(ION_JSON_BUFFER_SIZE);
     DeserializationError error = deserializeJson(doc, json);
     if (error) {
         ION_LOG_W("Failed to load saved networks");
         return false;
     }
-    
+        
     savedNetworks.clear();
     JsonArray arr = doc.as<JsonArray>();
-    
+        
     for (JsonVariant v : arr) {
         JsonObject obj = v.as<JsonObject>();
         WiFiCredential cred;
@@ -169,133 +543,223 @@ bool WiFiConnectionCore::loadNetworks() {
         cred.lastRSSI = obj["lastRSSI"] | 0;
         savedNetworks.push_back(cred);
     }
+        
+    // The JSON goes only once the record is stored, and the record is marked
+    // until then: a power cut at any point leaves one readable copy, and the
+    // next boot finishes the conversion
+    ION_LOG("Converting %d saved networks to a binary record", savedNetworks.size());
+    if (!writeNetworks(NETWORKS_VERSION | NETWORKS_CONVERTING) || !config->flush()) {
+        return false;
+    }
+    return finishConversion();
+}
     
-    ION_LOG("Loaded %d saved networks", savedNetworks.size());
-    return true;
+bool WiFiConnectionCore::finishConversion() {
+    config->remove("saved_networks");
+    return config->flush() && saveNetworks();
 }
-
+    
 bool WiFiConnectionCore::startScan() {
-    if (scanInProgress) return false;
+    SCAN_LOCK();
+    scanRequested = true;
+    SCAN_UNLOCK();
+    return true;
+}
     
+bool WiFiConnectionCore::launchScan() {
+    if (scanInProgress) return false;
+        
     scanInProgress = true;
     scanComplete = false;
-    
+        
     #if ION_PLATFORM_ESP32
     WiFi.scanNetworks(true); // Async scan
     #elif ION_PLATFORM_ESP8266
     WiFi.scanNetworksAsync([this](int n) {
+        // Merged by the next handle()
         scanComplete = true;
+        scanMerged = false;
         scanInProgress = false;
     });
     #endif
-    
+        
     return true;
 }
-
+    
 bool WiFiConnectionCore::isScanComplete() {
+    pollScan();
+    return scanComplete;
+}
+    
+void WiFiConnectionCore::pollScan() {
     #if ION_PLATFORM_ESP32
-    int n = WiFi.scanComplete();
-    if (n >= 0) {
-        scanComplete = true;
-        scanInProgress = false;
-        return true;
+    if (scanInProgress) {
+        int n = WiFi.scanComplete();
+        if (n >= 0) {
+            scanComplete = true;
+            scanMerged = false;
+            scanInProgress = false;
+        } else if (n == WIFI_SCAN_FAILED) {
+            ION_LOG_W("Scan failed");
+            scanInProgress = false;
+        }
     }
-    return false;
-    #else
-    return scanComplete;
     #endif
+        
+    if (!scanMerged) {
+        mergeScanResults();
+        scanMerged = true;
+    }
 }
-
-std::vector<NetworkInfo> WiFiConnectionCore::getScanResults() {
-    std::vector<NetworkInfo> results;
     
+void WiFiConnectionCore::mergeScanResults() {
     int n = WiFi.scanComplete();
-    if (n < 0) return results;
-    
+    uint32_t now = millis();
+    if (now == 0) now = 1; // scanCacheTime 0 means never
+        
+    SCAN_LOCK();
     for (int i = 0; i < n; i++) {
-        NetworkInfo info;
-        info.ssid = WiFi.SSID(i);
-        info.rssi = WiFi.RSSI(i);
-        info.encryption = WiFi.encryptionType(i);
-        info.channel = WiFi.channel(i);
-        results.push_back(info);
+        const uint8_t* bssid = WiFi.BSSID(i);
+        if (!bssid) continue;
+        int8_t rssi = WiFi.RSSI(i);
+            
+        NetworkInfo* info = nullptr;
+        for (auto& cached : scanCache) {
+            if (memcmp(cached.bssid, bssid, sizeof(cached.bssid)) == 0) {
+                info = &cached;
+                break;
+            }
+        }
+            
+        if (!info) {
+            scanCache.emplace_back();
+            info = &scanCache.back();
+            info->rssi = rssi;
+            memcpy(info->bssid, bssid, sizeof(info->bssid));
+        } else if (now - info->lastSeen > SCAN_ENTRY_TTL) {
+            info->rssi = rssi;
+        } else {
+            // Average with the previous scans; single readings swing by
+            // several dB
+            info->rssi = (info->rssi + rssi) / 2;
+        }
+            
+        info->ssid = WiFi.SSID(i);
+        info->encryption = WiFi.encryptionType(i);
+        info->channel = WiFi.channel(i);
+        info->lastSeen = now;
     }
-    
-    // Sort by RSSI (strongest first)
-    std::sort(results.begin(), results.end(), [](const NetworkInfo& a, const NetworkInfo& b) {
+        
+    // APs missing from one scan are kept for a while; scans often miss
+    // weak ones
+    scanCache.erase(std::remove_if(scanCache.begin(), scanCache.end(), [now](const NetworkInfo& info) {
+        return now - info.lastSeen > SCAN_ENTRY_TTL;
+    }), scanCache.end());
+        
+    std::sort(scanCache.begin(), scanCache.end(), [](const NetworkInfo& a, const NetworkInfo& b) {
         return a.rssi > b.rssi;
     });
+        
+    scanCacheTime = now;
+    SCAN_UNLOCK();
+    WiFi.scanDelete(); // The cache has everything we read from it
+}
     
+std::vector<NetworkInfo> WiFiConnectionCore::getScanResults() {
+    // Stale or empty: serve what we have and refresh in the background
+    SCAN_LOCK();
+    if (!scanCacheTime || millis() - scanCacheTime > SCAN_CACHE_TTL) {
+        scanRequested = true;
+    }
+    std::vector<NetworkInfo> results = scanCache;
+    SCAN_UNLOCK();
     return results;
 }
-
+    
+uint32_t WiFiConnectionCore::getScanAge() {
+    SCAN_LOCK();
+    uint32_t cacheTime = scanCacheTime;
+    SCAN_UNLOCK();
+    return cacheTime ? millis() - cacheTime : UINT32_MAX;
+}
+    
 WiFiState WiFiConnectionCore::getState() {
     return state;
 }
-
+    
 String WiFiConnectionCore::getSSID() {
     return WiFi.SSID();
 }
-
+    
 int8_t WiFiConnectionCore::getRSSI() {
     return WiFi.RSSI();
 }
-
+    
 IPAddress WiFiConnectionCore::getIP() {
     return WiFi.localIP();
 }
-
+    
 IPAddress WiFiConnectionCore::getGateway() {
     return WiFi.gatewayIP();
 }
-
+    
 IPAddress WiFiConnectionCore::getSubnet() {
     return WiFi.subnetMask();
 }
-
+    
 String WiFiConnectionCore::getMACAddress() {
     return WiFi.macAddress();
 }
-
+    
 bool WiFiConnectionCore::isConnected() {
     return state == WIFI_CONNECTED && WiFi.status() == WL_CONNECTED;
 }
-
+    
 uint32_t WiFiConnectionCore::getUptime() {
     if (state == WIFI_CONNECTED && connectedTime > 0) {
         return (millis() - connectedTime) / 1000;
     }
     return 0;
 }
-
+    
 void WiFiConnectionCore::onConnect(std::function<void()> cb) {
     connectCallback = cb;
 }
-
+    
 void WiFiConnectionCore::onDisconnect(std::function<void()> cb) {
     disconnectCallback = cb;
 }
-
+    
 void WiFiConnectionCore::onReconnecting(std::function<void(uint8_t)> cb) {
     reconnectingCallback = cb;
 }
-
+    
 void WiFiConnectionCore::onPortalFallback(std::function<void()> cb) {
     portalFallbackCallback = cb;
 }
-
+    
 void WiFiConnectionCore::setMaxReconnectAttempts(uint8_t attempts) {
     maxReconnectAttempts = attempts;
 }
-
+    
 void WiFiConnectionCore::setReconnectDelay(uint32_t delayMs) {
     reconnectDelay = delayMs;
 }
-
+    
 void WiFiConnectionCore::setConnectionTimeout(uint32_t timeoutMs) {
     connectionTimeout = timeoutMs;
 }
-
+    
+void WiFiConnectionCore::setIPDefaults(IPMode mode, const IPSettings& staticSettings) {
+    defaultIPMode = mode == IP_DEFAULT ? IP_DHCP : mode;
+    defaultStaticIP = staticSettings;
+}
+    
+void WiFiConnectionCore::setScoringPolicy(ScoringPolicy* policy, uint8_t hysteresis) {
+    scoringPolicy = policy;
+    scoringHysteresis = hysteresis;
+}
+    
 void WiFiConnectionCore::handleStateTransition() {
     switch (state) {
         case WIFI_IDLE:
@@ -304,34 +768,62 @@ void WiFiConnectionCore::handleStateTransition() {
             
         case WIFI_SCANNING:
             if (isScanComplete()) {
-                setState(WIFI_IDLE);
+                if (scanForConnect) {
+                    finishConnectScan();
+                } else {
+                    setState(WIFI_IDLE);
+                }
+            } else if (scanForConnect && millis() - scanStartTime > SCAN_TIMEOUT) {
+                ION_LOG_W("Scan timeout");
+                scanForConnect = false;
+                scanInProgress = false;
+                setState(WIFI_RECONNECTING);
             }
             break;
             
-        case WIFI_CONNECTING:
-            if (WiFi.status() == WL_CONNECTED) {
+        case WIFI_CONNECTING: {
+            wl_status_t status = WiFi.status();
+            if (status == WL_CONNECTED) {
+                linkDropped = false; // Reported while the driver was joining
                 setState(WIFI_CONNECTED);
-                resetBackoff();
-                connectedTime = millis();
-                
-                // Update network info
-                WiFiCredential* net = findNetwork(WiFi.SSID());
-                if (net) {
-                    net->lastConnected = millis() / 1000;
-                    net->lastRSSI = WiFi.RSSI();
-                    saveNetworks();
-                }
-                
+                recordAssociation();
                 if (connectCallback) connectCallback();
-            } else if (millis() - connectionStartTime > connectionTimeout) {
-                ION_LOG_W("Connection timeout");
+            } else if (fastConnect && (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED ||
+                                       millis() - connectionStartTime > FAST_CONNECT_TIMEOUT)) {
+                // The AP moved, is gone or refused us: find it again. The
+                // failed join counts in the network's history.
+                ION_LOG_W("Cached BSSID failed, scanning");
+                WiFiCredential* net = findNetwork(attemptSSID);
+                if (net) recordAttempt(*net, false);
+                fastConnect = false;
+                fastFailed = true;
+                if (!startConnectScan()) {
+                    setState(WIFI_RECONNECTING);
+                }
+            } else if (status == WL_CONNECT_FAILED || millis() - connectionStartTime > connectionTimeout) {
+                // Refused (e.g. wrong password) or no answer after the scan
+                ION_LOG_W("Connection %s", status == WL_CONNECT_FAILED ? "failed" : "timeout");
+                WiFiCredential* net = findNetwork(attemptSSID);
+                if (net) recordAttempt(*net, false);
                 setState(WIFI_RECONNECTING);
             }
             break;
+        }
             
         case WIFI_CONNECTED:
-            // Monitor connection
-            if (WiFi.status() != WL_CONNECTED) {
+            if (settling && millis() - connectedTime >= STABLE_CONNECTION) {
+                // The link held: earlier failures no longer count in a row
+                settling = false;
+                WiFiCredential* net = findNetwork(lastSSID);
+                if (net) net->failStreak = 0;
+            }
+            
+            if (!handleLease()) {
+                setState(WIFI_RECONNECTING);
+                if (disconnectCallback) disconnectCallback();
+            } else if (linkDropped || (!renewingLease && WiFi.status() != WL_CONNECTED)) {
+                // The status may report down while DHCP runs; the driver's
+                // disconnect event does not
                 ION_LOG_W("Connection lost");
                 setState(WIFI_RECONNECTING);
                 if (disconnectCallback) disconnectCallback();
@@ -353,6 +845,7 @@ void WiFiConnectionCore::handleStateTransition() {
                 ION_LOG("Reconnect attempt %d/%d", reconnectAttempts, maxReconnectAttempts);
                 if (reconnectingCallback) reconnectingCallback(reconnectAttempts);
                 
+                // Returns at once; WIFI_SCANNING connects when results arrive
                 connectToBest();
                 incrementBackoff();
             }
@@ -367,31 +860,42 @@ void WiFiConnectionCore::handleStateTransition() {
             break;
     }
 }
-
+    
 void WiFiConnectionCore::startReconnect() {
     reconnectAttempts = 0;
     lastReconnectTime = millis();
     setState(WIFI_RECONNECTING);
 }
-
+    
 void WiFiConnectionCore::incrementBackoff() {
     lastReconnectTime = millis();
     reconnectDelay = min(reconnectDelay * 2, (uint32_t)32000); // Max 32s
 }
-
+    
 void WiFiConnectionCore::resetBackoff() {
     reconnectAttempts = 0;
     reconnectDelay = 1000;
 }
-
+    
 void WiFiConnectionCore::setState(WiFiState newState) {
+    // A link that did not stay up was not a success after all
+    if (state == WIFI_CONNECTED && newState == WIFI_RECONNECTING && settling) {
+        settling = false;
+        WiFiCredential* net = findNetwork(lastSSID);
+        if (net) {
+            if (net->successes) net->successes--;
+            if (net->failStreak < 0xFF) net->failStreak++;
+            net->lastFailure = millis();
+        }
+    }
+        
     if (state != newState) {
         previousState = state;
         state = newState;
         ION_LOG("WiFi state: %d -> %d", previousState, state);
     }
 }
-
+    
 WiFiCredential* WiFiConnectionCore::findNetwork(const String& ssid) {
     for (auto& net : savedNetworks) {
         if (net.ssid == ssid) {
@@ -400,52 +904,87 @@ WiFiCredential* WiFiConnectionCore::findNetwork(const String& ssid) {
     }
     return nullptr;
 }
-
-WiFiCredential* WiFiConnectionCore::findBestNetwork() {
-    // Start scan if not done
-    if (!scanComplete) {
-        startScan();
-        // Wait a bit for scan
-        uint32_t start = millis();
-        while (!isScanComplete() && millis() - start < 5000) {
-            delay(100);
+    
+bool WiFiConnectionCore::isFlapping(const WiFiCredential& net) {
+    return net.failStreak >= FLAPPING_FAILURES && ScoringPolicy::failedRecently(net);
+}
+    
+WiFiCredential* WiFiConnectionCore::findIncumbent() {
+    // The network in use last, this boot or (by join sequence) before it
+    if (!lastSSID.isEmpty()) {
+        return findNetwork(lastSSID);
+    }
+        
+    WiFiCredential* latest = nullptr;
+    for (auto& net : savedNetworks) {
+        if (net.lastConnected && (!latest || net.lastConnected > latest->lastConnected)) {
+            latest = &net;
         }
     }
+    return latest;
+}
     
-    auto scanResults = getScanResults();
+WiFiCredential* WiFiConnectionCore::findBestNetwork() {
+    // Score every saved network the last scan saw, by its strongest AP
+    // (the cache is sorted strongest first)
+    WiFiCredential* incumbent = findIncumbent();
     WiFiCredential* best = nullptr;
-    int8_t bestRSSI = -100;
-    
-    // Find the strongest network we have credentials for
-    for (const auto& result : scanResults) {
-        WiFiCredential* net = findNetwork(result.ssid);
-        if (net && result.rssi > bestRSSI) {
+    const NetworkInfo* bestAP = nullptr;
+    int32_t bestScore = 0;
+    const NetworkInfo* incumbentAP = nullptr;
+    int32_t incumbentScore = 0;
+        
+    for (const auto& info : scanCache) {
+        if (info.lastSeen != scanCacheTime) {
+            continue;
+        }
+            
+        WiFiCredential* net = findNetwork(info.ssid);
+        if (!net || (net == incumbent && incumbentAP)) {
+            continue;
+        }
+            
+        int32_t score = scoringPolicy ? scoringPolicy->score(*net, info) : info.rssi;
+        if (net == incumbent) {
+            incumbentAP = &info;
+            incumbentScore = score;
+        }
+        if (!best || score > bestScore) {
             best = net;
-            bestRSSI = result.rssi;
-            best->lastRSSI = result.rssi;
+            bestAP = &info;
+            bestScore = score;
         }
     }
-    
+        
+    // Hysteresis: leave the last network only for a clear improvement, so
+    // two similar APs do not take turns
+    if (incumbentAP && best != incumbent && bestScore - incumbentScore < scoringHysteresis) {
+        best = incumbent;
+        bestAP = incumbentAP;
+    }
+        
+    if (best) {
+        // Join the AP the scan saw rather than letting the driver scan again
+        best->lastRSSI = bestAP->rssi;
+        best->channel = bestAP->channel;
+        memcpy(best->bssid, bestAP->bssid, sizeof(best->bssid));
+    }
     return best;
 }
-
+    
 #if ION_PLATFORM_ESP32
 void WiFiConnectionCore::wifiEventHandler(WiFiEvent_t event) {
     if (!instance) return;
-    
+        
     switch (event) {
         case SYSTEM_EVENT_STA_GOT_IP:
             ION_LOG("WiFi connected - IP: %s", WiFi.localIP().toString().c_str());
-            instance->setState(WIFI_CONNECTED);
-            if (instance->connectCallback) instance->connectCallback();
+            instance->gotIP = true;
             break;
             
         case SYSTEM_EVENT_STA_DISCONNECTED:
             ION_LOG("WiFi disconnected");
-            if (instance->state == WIFI_CONNECTED) {
-                instance->setState(WIFI_RECONNECTING);
-                if (instance->disconnectCallback) instance->disconnectCallback();
-            }
+            instance->linkDropped = true;
             break;
             
         default:
@@ -453,6 +992,5 @@ void WiFiConnectionCore::wifiEventHandler(WiFiEvent_t event) {
     }
 }
 #endif
-
+    
 } // namespace IonConnect
-
@@ -6,9 +6,12 @@
 #include <functional>
 #include "../core/IonTypes.h"
 #include "ConfigManager.h"
+#include "NetworkScorer.h"
 
 #if ION_PLATFORM_ESP32
     #include <WiFi.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
 #elif ION_PLATFORM_ESP8266
     #include <ESP8266WiFi.h>
 #endif
@@ -24,6 +27,37 @@ namespace IonConnect {
  * - Automatic strongest network selection
  * - Portal fallback after max failures
  * - Connection state machine
+ * 
+ * handle() never waits on the radio: a reconnect starts an async scan and
+ * moves to WIFI_SCANNING, and the network is picked once results arrive.
+ * 
+ * The BSSID and channel of each network's last good association are
+ * saved with it. Connecting to a known network (including on boot and the
+ * first reconnect attempt) joins that BSSID directly, skipping the scan,
+ * and falls back to scanning if it fails.
+ * 
+ * Each network picks DHCP, static addresses or a cached lease (IPMode).
+ * A cached lease, the last one DHCP gave, is applied with WiFi.config()
+ * before joining, so the connection is usable without waiting for DHCP.
+ * Once connected for LEASE_CONFIRM_DELAY the interface goes back to DHCP,
+ * and the lease reported by the next got-IP event replaces the cached one.
+ * Meanwhile the ESP8266 keeps the old address and the ESP32 has none, so
+ * localIP() cannot tell when DHCP is done. Short wake-and-report cycles
+ * never wait for DHCP.
+ * 
+ * Scan results are merged into a cache when each scan completes, keyed by
+ * BSSID, with RSSI averaged over successive scans. getScanResults() returns
+ * a copy of the cache and asks for a background scan when it is older than
+ * SCAN_CACHE_TTL. The driver's copy is freed after the merge. The web server
+ * and BLE call startScan(), getScanResults() and getScanAge() from their own
+ * tasks: the cache is guarded by a lock, and scans are only started and
+ * merged from handle().
+ * 
+ * After a scan, the network to join is chosen by a ScoringPolicy (RSSI
+ * only without one), with hysteresis in favour of the last network. Each
+ * saved network keeps a short connection history for the policy: attempts,
+ * successes and average join time. A link lost within STABLE_CONNECTION
+ * counts as a failure.
  */
 class WiFiConnectionCore {
 public:
@@ -37,7 +71,7 @@ public:
     
     // Connection Management
     bool connect(const String& ssid, const String& password);
-    bool connectToBest(); // Scan and connect to strongest known network
+    bool connectToBest(); // Scan, then connect to the strongest known network from handle()
     bool disconnect();
     
     // Network Management
@@ -46,11 +80,14 @@ public:
     std::vector<WiFiCredential> getSavedNetworks();
     bool saveNetworks();
     bool loadNetworks();
+    bool setNetworkIP(const String& ssid, IPMode mode, const IPSettings& settings = IPSettings());
     
     // Scanning
-    bool startScan();
-    bool isScanComplete();
-    std::vector<NetworkInfo> getScanResults();
+    bool startScan();                                   // Any task; the scan starts from handle()
+    bool isScanComplete();                              // Loop only
+    std::vector<NetworkInfo> getScanResults();          // Any task; a copy, strongest first
+    uint32_t getScanAge();                              // ms since the last scan, UINT32_MAX if none
+    static const uint32_t SCAN_CACHE_TTL = 30000;       // Then getScanResults() rescans
     
     // Status
     WiFiState getState();
@@ -73,6 +110,8 @@ public:
     void setMaxReconnectAttempts(uint8_t attempts);
     void setReconnectDelay(uint32_t delayMs);
     void setConnectionTimeout(uint32_t timeoutMs);
+    void setIPDefaults(IPMode mode, const IPSettings& staticSettings);  // For IP_DEFAULT networks
+    void setScoringPolicy(ScoringPolicy* policy, uint8_t hysteresis);  // Not owned; nullptr = RSSI only
     
 private:
     ConfigManager* config;
@@ -90,6 +129,34 @@ private:
     
     bool scanInProgress;
     bool scanComplete;
+    bool scanMerged;            // Results of the last completed scan are in scanCache
+    bool scanForConnect;        // Connect to the best result when the scan ends
+    uint32_t scanStartTime;
+    bool fastConnect;           // Attempt in progress uses the cached BSSID/channel
+    bool fastFailed;            // Cached BSSID/channel failed since the last connection
+    volatile bool linkDropped;  // Disconnect event since the link came up (event context)
+    String lastSSID;            // Of the last connection
+    
+    IPMode defaultIPMode;
+    IPSettings defaultStaticIP;
+    bool staticApplied;         // WiFi.config() set addresses, DHCP is off
+    bool leaseApplied;          // Connection runs on a cached lease
+    bool renewingLease;         // Back on DHCP, waiting for the new lease
+    uint32_t renewStartTime;
+    volatile bool gotIP;        // Got-IP event since the renewal started (event context)
+    
+    // Written by handle() under scanLock; other tasks read them under it
+    std::vector<NetworkInfo> scanCache;
+    uint32_t scanCacheTime;     // millis() of the last merge, 0 = never
+    bool scanRequested;         // By startScan()/getScanResults(), for handle()
+    #if ION_PLATFORM_ESP32
+    SemaphoreHandle_t scanLock;
+    #endif
+    
+    ScoringPolicy* scoringPolicy;
+    uint8_t scoringHysteresis;
+    String attemptSSID;         // Of the join in progress
+    bool settling;              // Connected for less than STABLE_CONNECTION
     
     // Callbacks
     std::function<void()> connectCallback;
@@ -98,12 +165,49 @@ private:
     std::function<void()> portalFallbackCallback;
     
     void handleStateTransition();
+    bool beginConnect(const WiFiCredential& net, bool useCache);
+    bool startConnectScan();
+    void finishConnectScan();
+    void recordAssociation();
+    void recordAttempt(WiFiCredential& net, bool success);
+    WiFiCredential* findCachedNetwork();
+    WiFiCredential* findIncumbent();
+    static bool isFlapping(const WiFiCredential& net);
+    IPMode ipModeOf(const WiFiCredential& net);
+    void applyIPSettings(const WiFiCredential& net);
+    bool storeLease(WiFiCredential& net);
+    bool handleLease();
+    bool launchScan();
+    void pollScan();
+    void mergeScanResults();
     void startReconnect();
     void incrementBackoff();
     void resetBackoff();
     void setState(WiFiState newState);
     WiFiCredential* findNetwork(const String& ssid);
     WiFiCredential* findBestNetwork();
+    bool writeNetworks(uint8_t header);
+    bool decodeNetworks(const uint8_t* data, size_t len);
+    bool loadLegacyNetworks();
+    bool finishConversion();
+    
+    // Saved networks are one binary record: [version][count] then per
+    // network [ssid_len][ssid][pass_len][encrypted pass][priority]
+    // [last_connected u32][last_rssi][channel][bssid 6][ip_mode]
+    // [ip][gateway][subnet][dns][attempts][successes][connect_time u16].
+    // Version 1 ends after last_rssi, version 2 after the BSSID, version 3
+    // after the DNS address. The top bit of the version marks networks
+    // converted from the old JSON whose removal is not stored yet.
+    static const char* KEY_NETWORKS;
+    static const uint8_t NETWORKS_VERSION = 4;
+    static const uint8_t NETWORKS_CONVERTING = 0x80;
+    static const uint32_t SCAN_TIMEOUT = 10000;     // Give up on a scan that never reports
+    static const uint32_t FAST_CONNECT_TIMEOUT = 5000;  // Then scan instead
+    static const uint32_t LEASE_CONFIRM_DELAY = 30000;  // Connected this long on a cached lease
+    static const uint32_t SCAN_ENTRY_TTL = 60000;       // Not seen this long: dropped
+    static const uint32_t STABLE_CONNECTION = 60000;    // Lost sooner: counted as a failure
+    static const uint8_t HISTORY_WINDOW = 16;           // Attempts kept at full weight
+    static const uint8_t FLAPPING_FAILURES = 2;         // In a row: rescan instead of rejoining
     
     #if ION_PLATFORM_ESP32
     static void wifiEventHandler(WiFiEvent_t event);
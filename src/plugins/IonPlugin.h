@@ -62,7 +62,16 @@ public:
     virtual String getUIPanel() { return ""; }
     
     /**
-     * @brief Called when configuration changes
+     * @brief Config keys this plugin wants change events for
+     * @return Comma-separated keys, e.g. "mqtt_host,mqtt_port"; nullptr for all
+     */
+    virtual const char* getConfigInterest() { return nullptr; }
+    
+    /**
+     * @brief Called from handle() after configuration changes
+     * 
+     * Changes are batched: several writes to one key before delivery
+     * produce a single call with the latest value.
      * @param key Configuration key that changed
      * @param value New value
      */
@@ -1,42 +1,42 @@
 #ifndef DEFAULT_SCHEMA_H
 #define DEFAULT_SCHEMA_H
 
+// Generated by tools/web_builder/build_schema.py from src/schemas/schemas_src/default_schema.json
+// Do not edit by hand - edit the JSON source and re-run the schema compiler.
+
+#include "../core/IonTypes.h"
+
 namespace IonConnect {
 
-// Default configuration schema embedded in library
-const char DEFAULT_SCHEMA[] PROGMEM = R"json({
-  "version": "1.0",
-  "namespace": "ionconnect",
-  "fields": [
-    {
-      "id": "wifi_ssid",
-      "label": "WiFi Network",
-      "type": "text",
-      "required": true,
-      "placeholder": "Enter SSID",
-      "maxLength": 32
-    },
-    {
-      "id": "wifi_pass",
-      "label": "WiFi Password",
-      "type": "password",
-      "required": false,
-      "encrypted": true,
-      "minLength": 8,
-      "placeholder": "Enter password"
-    },
-    {
-      "id": "device_name",
-      "label": "Device Name",
-      "type": "text",
-      "required": false,
-      "default": "IonConnect Device",
-      "maxLength": 32
-    }
-  ]
-})json";
+// Schema JSON served to the portal UI and BLE clients
+const char DEFAULT_SCHEMA[] PROGMEM = R"json({"version":"1.0","namespace":"ionconnect","fields":[{"id":"wifi_ssid","label":"WiFi Network","type":"text","required":true,"placeholder":"Enter SSID","maxLength":32},{"id":"wifi_pass","label":"WiFi Password","type":"password","required":false,"encrypted":true,"minLength":8,"placeholder":"Enter password"},{"id":"device_name","label":"Device Name","type":"text","required":false,"default":"IonConnect Device","maxLength":32}]})json";
+
+// Field strings (deduplicated)
+const char DEFAULT_SCHEMA_STR_0[] PROGMEM = "";
+const char DEFAULT_SCHEMA_STR_1[] PROGMEM = "wifi_ssid";
+const char DEFAULT_SCHEMA_STR_2[] PROGMEM = "WiFi Network";
+const char DEFAULT_SCHEMA_STR_3[] PROGMEM = "text";
+const char DEFAULT_SCHEMA_STR_4[] PROGMEM = "Enter SSID";
+const char DEFAULT_SCHEMA_STR_5[] PROGMEM = "wifi_pass";
+const char DEFAULT_SCHEMA_STR_6[] PROGMEM = "WiFi Password";
+const char DEFAULT_SCHEMA_STR_7[] PROGMEM = "password";
+const char DEFAULT_SCHEMA_STR_8[] PROGMEM = "Enter password";
+const char DEFAULT_SCHEMA_STR_9[] PROGMEM = "device_name";
+const char DEFAULT_SCHEMA_STR_10[] PROGMEM = "Device Name";
+const char DEFAULT_SCHEMA_STR_11[] PROGMEM = "IonConnect Device";
+
+// Field descriptor table - use with ConfigManager::loadSchema(table, count, json)
+const ConfigField DEFAULT_SCHEMA_FIELDS[] PROGMEM = {
+    // wifi_ssid
+    { DEFAULT_SCHEMA_STR_1, DEFAULT_SCHEMA_STR_2, DEFAULT_SCHEMA_STR_3, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_4, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_0, nullptr, 0, 0, 32, 0, 0, true, false, FIELD_TEXT },
+    // wifi_pass
+    { DEFAULT_SCHEMA_STR_5, DEFAULT_SCHEMA_STR_6, DEFAULT_SCHEMA_STR_7, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_8, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_0, nullptr, 0, 8, 0, 0, 0, false, true, FIELD_PASSWORD },
+    // device_name
+    { DEFAULT_SCHEMA_STR_9, DEFAULT_SCHEMA_STR_10, DEFAULT_SCHEMA_STR_3, DEFAULT_SCHEMA_STR_11, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_0, DEFAULT_SCHEMA_STR_0, nullptr, 0, 0, 32, 0, 0, false, false, FIELD_TEXT },
+};
+
+const size_t DEFAULT_SCHEMA_FIELD_COUNT = 3;
 
 } // namespace IonConnect
 
 #endif // DEFAULT_SCHEMA_H
-
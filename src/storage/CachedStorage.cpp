@@ -0,0 +1,133 @@
+#include "CachedStorage.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+CachedStorage::CachedStorage() : initialized(false), dirty(false) {
+}
+
+bool CachedStorage::exists(const char* key) {
+    if (!initialized) return false;
+    
+    int index = cache.find(key);
+    return index >= 0 && cache.at(index).type != EntryTable::TYPE_DELETED;
+}
+
+String CachedStorage::getString(const char* key, const String& defaultValue) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_STRING);
+    if (!entry) {
+        return defaultValue;
+    }
+    
+    String value;
+    value.concat((const char*)cache.dataOf(*entry), entry->value.data.length);
+    return value;
+}
+
+bool CachedStorage::putString(const char* key, const String& value) {
+    if (!initialized) return false;
+    
+    return track(cache.setData(key, strlen(key), EntryTable::TYPE_STRING, value.c_str(), value.length()));
+}
+
+int CachedStorage::getInt(const char* key, int defaultValue) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_INT);
+    return entry ? entry->value.i : defaultValue;
+}
+
+bool CachedStorage::putInt(const char* key, int value) {
+    if (!initialized) return false;
+    
+    return track(cache.setNumber(key, strlen(key), EntryTable::TYPE_INT, (uint32_t)value));
+}
+
+uint32_t CachedStorage::getUInt(const char* key, uint32_t defaultValue) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_UINT);
+    return entry ? entry->value.u : defaultValue;
+}
+
+bool CachedStorage::putUInt(const char* key, uint32_t value) {
+    if (!initialized) return false;
+    
+    return track(cache.setNumber(key, strlen(key), EntryTable::TYPE_UINT, value));
+}
+
+bool CachedStorage::getBool(const char* key, bool defaultValue) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_BOOL);
+    return entry ? entry->value.u != 0 : defaultValue;
+}
+
+bool CachedStorage::putBool(const char* key, bool value) {
+    if (!initialized) return false;
+    
+    return track(cache.setNumber(key, strlen(key), EntryTable::TYPE_BOOL, value ? 1 : 0));
+}
+
+size_t CachedStorage::getBytesLength(const char* key) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_BYTES);
+    return entry ? entry->value.data.length : 0;
+}
+
+size_t CachedStorage::getBytes(const char* key, void* buffer, size_t maxLen) {
+    const EntryTable::Entry* entry = findEntry(key, EntryTable::TYPE_BYTES);
+    if (!entry || entry->value.data.length == 0 || entry->value.data.length > maxLen) {
+        return 0;
+    }
+    
+    memcpy(buffer, cache.dataOf(*entry), entry->value.data.length);
+    return entry->value.data.length;
+}
+
+bool CachedStorage::putBytes(const char* key, const void* value, size_t len) {
+    if (!initialized) return false;
+    
+    return track(cache.setData(key, strlen(key), EntryTable::TYPE_BYTES, value, len));
+}
+
+bool CachedStorage::remove(const char* key) {
+    if (!initialized) return false;
+    
+    int index = cache.find(key);
+    if (index < 0 || cache.at(index).type == EntryTable::TYPE_DELETED) {
+        return false;
+    }
+    
+    // Keep a tombstone until the removal has been persisted
+    return track(cache.setNumber(key, strlen(key), EntryTable::TYPE_DELETED, 0));
+}
+
+bool CachedStorage::track(int index) {
+    if (index < 0) {
+        ION_LOG_E("Storage: out of memory");
+        return false;
+    }
+    if (cache.at(index).dirty) {
+        dirty = true;
+    }
+    return true;
+}
+
+void CachedStorage::markClean() {
+    // Everything is persisted now, so tombstones have done their job
+    for (size_t i = cache.size(); i-- > 0;) {
+        EntryTable::Entry& entry = cache.at(i);
+        if (entry.type == EntryTable::TYPE_DELETED) {
+            cache.erase(i);
+        } else {
+            entry.dirty = false;
+        }
+    }
+    dirty = false;
+}
+
+const EntryTable::Entry* CachedStorage::findEntry(const char* key, EntryTable::DataType type) {
+    if (!initialized) return nullptr;
+    
+    int index = cache.find(key);
+    if (index < 0 || cache.at(index).type != type) {
+        return nullptr;
+    }
+    return &cache.at(index);
+}
+
+} // namespace IonConnect
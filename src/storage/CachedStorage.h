@@ -0,0 +1,52 @@
+#ifndef CACHED_STORAGE_H
+#define CACHED_STORAGE_H
+
+#include "StorageProvider.h"
+#include "EntryTable.h"
+
+namespace IonConnect {
+
+/**
+ * @brief Base for storage that keeps the whole namespace in RAM
+ * 
+ * Reads and writes go to an EntryTable; changed entries are flagged dirty
+ * and removals leave a tombstone, so that commit() in the subclass can
+ * persist exactly what changed and then call markClean().
+ */
+class CachedStorage : public StorageProvider {
+public:
+    CachedStorage();
+    
+    bool exists(const char* key) override;
+    
+    String getString(const char* key, const String& defaultValue = "") override;
+    bool putString(const char* key, const String& value) override;
+    
+    int getInt(const char* key, int defaultValue = 0) override;
+    bool putInt(const char* key, int value) override;
+    
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) override;
+    bool putUInt(const char* key, uint32_t value) override;
+    
+    bool getBool(const char* key, bool defaultValue = false) override;
+    bool putBool(const char* key, bool value) override;
+    
+    size_t getBytesLength(const char* key) override;
+    size_t getBytes(const char* key, void* buffer, size_t maxLen) override;
+    bool putBytes(const char* key, const void* value, size_t len) override;
+    
+    bool remove(const char* key) override;
+    
+protected:
+    bool initialized;
+    bool dirty;                 // Some entry is not persisted yet
+    EntryTable cache;
+    
+    bool track(int index);      // Result of a table write
+    void markClean();           // After a successful commit
+    const EntryTable::Entry* findEntry(const char* key, EntryTable::DataType type);
+};
+
+} // namespace IonConnect
+
+#endif // CACHED_STORAGE_H
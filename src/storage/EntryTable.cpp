@@ -0,0 +1,188 @@
+#include "EntryTable.h"
+
+namespace IonConnect {
+
+EntryTable::EntryTable() : arena(nullptr), arenaSize(0), count(0), dataUsed(0) {
+}
+
+EntryTable::~EntryTable() {
+    clear();
+}
+
+void EntryTable::clear() {
+    free(arena);
+    arena = nullptr;
+    arenaSize = 0;
+    count = 0;
+    dataUsed = 0;
+}
+
+int EntryTable::find(const char* key, size_t keyLen) const {
+    bool found;
+    int index = search(key, keyLen, found);
+    return found ? index : -1;
+}
+
+int EntryTable::setNumber(const char* key, size_t keyLen, DataType type, uint32_t value) {
+    bool found;
+    int index = search(key, keyLen, found);
+    if (!found && (index = insert(key, keyLen)) < 0) {
+        return -1;
+    }
+    
+    Entry& entry = entries()[index];
+    if (entry.type == type && entry.value.u == value) {
+        return index;
+    }
+    entry.type = type;
+    entry.value.u = value;
+    entry.dirty = true;
+    return index;
+}
+
+int EntryTable::setData(const char* key, size_t keyLen, DataType type, const void* data, size_t len) {
+    if (len > MAX_ARENA) {
+        return -1;
+    }
+    
+    bool found;
+    int index = search(key, keyLen, found);
+    if (!found && (index = insert(key, keyLen)) < 0) {
+        return -1;
+    }
+    
+    Entry* entry = &entries()[index];
+    if (entry->type == type && entry->value.data.length == len &&
+        memcmp(dataOf(*entry), data, len) == 0) {
+        return index;
+    }
+    
+    // Reuse the old bytes when the new value fits, append otherwise
+    if (!entry->hasData() || len > entry->value.data.length) {
+        if (freeSpace() < len && !rebuild(len)) {
+            return -1;
+        }
+        entry = &entries()[index];
+        entry->value.data.offset = allocate(len);
+    }
+    entry->value.data.length = len;
+    memcpy(arena + arenaSize - entry->value.data.offset, data, len);
+    entry->type = type;
+    entry->dirty = true;
+    return index;
+}
+
+void EntryTable::erase(size_t index) {
+    // Its bytes are reclaimed by the next rebuild
+    Entry* table = entries();
+    memmove(&table[index], &table[index + 1], (count - index - 1) * sizeof(Entry));
+    count--;
+}
+
+int EntryTable::search(const char* key, size_t keyLen, bool& found) const {
+    // Lower bound: index of the key, or where it would be inserted
+    int low = 0;
+    int high = count;
+    
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (compare(entries()[mid], key, keyLen) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    found = low < count && compare(entries()[low], key, keyLen) == 0;
+    return low;
+}
+
+int EntryTable::compare(const Entry& entry, const char* key, size_t keyLen) const {
+    size_t common = keyLen < entry.keyLen ? keyLen : entry.keyLen;
+    int cmp = memcmp(keyOf(entry), key, common);
+    return cmp != 0 ? cmp : (int)entry.keyLen - (int)keyLen;
+}
+
+int EntryTable::insert(const char* key, size_t keyLen) {
+    if (keyLen == 0 || keyLen > 0xFF) {
+        return -1;
+    }
+    
+    size_t needed = sizeof(Entry) + keyLen;
+    if (freeSpace() < needed && !rebuild(needed)) {
+        return -1;
+    }
+    
+    bool found;
+    int index = search(key, keyLen, found);
+    Entry* table = entries();
+    memmove(&table[index + 1], &table[index], (count - index) * sizeof(Entry));
+    count++;
+    
+    Entry& entry = table[index];
+    entry.key = allocate(keyLen);
+    entry.keyLen = keyLen;
+    entry.type = TYPE_DELETED;
+    entry.dirty = false;
+    entry.value.u = 0;
+    memcpy(arena + arenaSize - entry.key, key, keyLen);
+    return index;
+}
+
+uint16_t EntryTable::allocate(size_t len) {
+    // Caller made sure it fits
+    dataUsed += len;
+    return dataUsed;
+}
+
+bool EntryTable::rebuild(size_t extra) {
+    size_t live = count * sizeof(Entry);
+    for (size_t i = 0; i < count; i++) {
+        const Entry& entry = entries()[i];
+        live += entry.keyLen + (entry.hasData() ? entry.value.data.length : 0);
+    }
+    if (live + extra > MAX_ARENA) {
+        return false;
+    }
+    
+    // Headroom so that a run of small updates does not rebuild every time
+    size_t size = live + extra;
+    size = (size + size / 4 + 32 + 3) & ~(size_t)3;
+    if (size > MAX_ARENA) {
+        size = MAX_ARENA;
+    }
+    
+    uint8_t* fresh = (uint8_t*)malloc(size);
+    if (!fresh) {
+        return false;
+    }
+    
+    // Same entries, with their bytes packed against the new end
+    Entry* table = (Entry*)fresh;
+    uint16_t used = 0;
+    if (count) {
+        memcpy(table, arena, count * sizeof(Entry));
+    }
+    for (size_t i = 0; i < count; i++) {
+        const Entry& old = entries()[i];
+        Entry& entry = table[i];
+        
+        used += old.keyLen;
+        memcpy(fresh + size - used, keyOf(old), old.keyLen);
+        entry.key = used;
+        
+        if (old.hasData()) {
+            used += old.value.data.length;
+            memcpy(fresh + size - used, dataOf(old), old.value.data.length);
+            entry.value.data.offset = used;
+        }
+    }
+    
+    free(arena);
+    arena = fresh;
+    arenaSize = size;
+    dataUsed = used;
+    return true;
+}
+
+} // namespace IonConnect
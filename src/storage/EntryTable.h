@@ -0,0 +1,95 @@
+#ifndef ENTRY_TABLE_H
+#define ENTRY_TABLE_H
+
+#include <Arduino.h>
+
+namespace IonConnect {
+
+/**
+ * @brief Flat, sorted key/value table in a single allocation
+ *
+ * In-memory cache for storage backends that keep the whole namespace in
+ * RAM. Entries are fixed-size and sorted by key at the front of one arena;
+ * key and value bytes are packed against its end:
+ *
+ *   [entry][entry]...[entry]   free   [bytes][bytes]...[bytes]
+ *
+ * Lookups are a binary search. Numbers live in the entry itself, so
+ * reading them does not parse text. Strings and byte arrays are stored in
+ * place when the new value is no longer than the old one and appended
+ * otherwise; when the arena is full it is rebuilt at a size fitted to the
+ * live data, which also drops the bytes of overwritten values. Byte
+ * positions are offsets from the end of the arena, so nothing needs fixing
+ * up when it moves.
+ *
+ * Indexes and pointers returned by the table are only valid until the next
+ * call that inserts, erases or stores a value.
+ */
+class EntryTable {
+public:
+    enum DataType : uint8_t {
+        TYPE_DELETED = 0,       // Tombstone
+        TYPE_STRING = 1,
+        TYPE_INT = 2,
+        TYPE_UINT = 3,
+        TYPE_BOOL = 4,
+        TYPE_BYTES = 5
+    };
+    
+    struct Entry {
+        uint16_t key;           // Key bytes, as an offset from the end of the arena
+        uint8_t keyLen;
+        DataType type;
+        bool dirty;             // Changed since the owner last persisted it
+        union {
+            int32_t i;          // TYPE_INT
+            uint32_t u;         // TYPE_UINT, TYPE_BOOL (0/1)
+            struct {
+                uint16_t offset;    // Like `key`
+                uint16_t length;
+            } data;             // TYPE_STRING, TYPE_BYTES
+        } value;
+        
+        bool hasData() const { return type == TYPE_STRING || type == TYPE_BYTES; }
+    };
+    
+    EntryTable();
+    ~EntryTable();
+    
+    void clear();
+    size_t size() const { return count; }
+    size_t capacity() const { return arenaSize; }
+    
+    Entry& at(size_t index) { return entries()[index]; }
+    const char* keyOf(const Entry& entry) const { return (const char*)arena + arenaSize - entry.key; }
+    const uint8_t* dataOf(const Entry& entry) const { return arena + arenaSize - entry.value.data.offset; }
+    
+    int find(const char* key, size_t keyLen) const;
+    int find(const char* key) const { return find(key, strlen(key)); }
+    
+    // Insert or overwrite; the entry is flagged dirty only if it changed.
+    // Return the entry index, or -1 when out of memory.
+    int setNumber(const char* key, size_t keyLen, DataType type, uint32_t value);
+    int setData(const char* key, size_t keyLen, DataType type, const void* data, size_t len);
+    void erase(size_t index);
+
+private:
+    static const size_t MAX_ARENA = 0xFFFC;     // Offsets are 16-bit
+    
+    uint8_t* arena;
+    uint16_t arenaSize;
+    uint16_t count;
+    uint16_t dataUsed;          // Bytes at the end, including overwritten values
+    
+    Entry* entries() const { return (Entry*)arena; }
+    size_t freeSpace() const { return arenaSize - dataUsed - count * sizeof(Entry); }
+    int search(const char* key, size_t keyLen, bool& found) const;
+    int compare(const Entry& entry, const char* key, size_t keyLen) const;
+    int insert(const char* key, size_t keyLen);
+    uint16_t allocate(size_t len);
+    bool rebuild(size_t extra);
+};
+
+} // namespace IonConnect
+
+#endif // ENTRY_TABLE_H
@@ -1,11 +1,38 @@
 #include "../core/IonTypes.h"
 #include "StorageEEPROM.h"
+#include "../utils/Hash.h"
+#include "../utils/Logger.h"
 
 #if ION_PLATFORM_ESP8266
 
+// Linker symbols of the EEPROM sector and the end of the filesystem
+extern "C" uint32_t _EEPROM_start;
+extern "C" uint32_t _FS_end;
+
 namespace IonConnect {
 
-StorageEEPROM::StorageEEPROM() : initialized(false), dirty(false) {
+static const uint32_t FLASH_MAPPED_BASE = 0x40200000; // Flash mapped into the address space
+
+static uint32_t read32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+// flashWrite() takes whole words
+static uint32_t align4(uint32_t n) {
+    return (n + 3) & ~3;
+}
+
+StorageEEPROM::StorageEEPROM()
+    : image(nullptr), activeSlot(0), generation(0),
+      logStart(0), logEnd(0), sequence(0), appendable(false), cleared(false) {
+    sectors[0] = ((uint32_t)(uintptr_t)&_EEPROM_start - FLASH_MAPPED_BASE) / EEPROM_SIZE;
+    sectors[1] = backupSector(sectors[0]);
 }
 
 StorageEEPROM::~StorageEEPROM() {
@@ -18,7 +45,17 @@ bool StorageEEPROM::begin(const char* ns) {
     }
     
     currentNamespace = ns;
-    EEPROM.begin(EEPROM_SIZE);
+    if (!image) {
+        image = (uint8_t*)malloc(EEPROM_SIZE);
+        if (!image) {
+            ION_LOG_E("EEPROM: out of memory");
+            return false;
+        }
+    }
+    
+    if (!sectors[1]) {
+        ION_LOG_W("EEPROM: no spare flash sector, commits are not power-safe");
+    }
     
     initialized = loadFromEEPROM();
     if (!initialized) {
@@ -36,258 +73,509 @@ void StorageEEPROM::end() {
     if (initialized && dirty) {
         commit();
     }
-    EEPROM.end();
+    free(image);
+    image = nullptr;
+    cache.clear();
+    appendable = false;
+    cleared = false;
     initialized = false;
 }
 
 bool StorageEEPROM::clear() {
     if (!initialized) return false;
     
+    // Written by the next commit(), which rewrites the log from scratch
     cache.clear();
     dirty = true;
-    return saveToEEPROM();
-}
-
-bool StorageEEPROM::exists(const char* key) {
-    if (!initialized) return false;
-    return cache.find(key) != cache.end();
+    cleared = true;
+    return true;
 }
 
-String StorageEEPROM::getString(const char* key, const String& defaultValue) {
-    if (!initialized) return defaultValue;
+bool StorageEEPROM::commit() {
+    if (!initialized || !dirty) return true;
     
-    auto it = cache.find(key);
-    if (it == cache.end() || it->second.type != TYPE_STRING) {
-        return defaultValue;
+    // Appends go into the erased tail of the active slot; the image is only
+    // rewritten (to the other slot) when that is not possible
+    bool success = !cleared && appendDirty();
+    if (!success) {
+        success = compact() && writeSlot();
     }
     
-    return it->second.value;
-}
-
-bool StorageEEPROM::putString(const char* key, const String& value) {
-    if (!initialized) return false;
-    
-    Entry entry;
-    entry.type = TYPE_STRING;
-    entry.value = value;
-    cache[key] = entry;
-    dirty = true;
-    
-    return true;
-}
-
-int StorageEEPROM::getInt(const char* key, int defaultValue) {
-    if (!initialized) return defaultValue;
-    
-    auto it = cache.find(key);
-    if (it == cache.end() || it->second.type != TYPE_INT) {
-        return defaultValue;
+    if (success) {
+        markClean();
+        cleared = false;
+    } else {
+        ION_LOG_E("EEPROM commit failed");
     }
     
-    return it->second.value.toInt();
+    return success;
 }
 
-bool StorageEEPROM::putInt(const char* key, int value) {
-    if (!initialized) return false;
-    
-    Entry entry;
-    entry.type = TYPE_INT;
-    entry.value = String(value);
-    cache[key] = entry;
-    dirty = true;
+int StorageEEPROM::storeRecord(const char* key, uint8_t keyLen, DataType type, const char* data, uint16_t len) {
+    if (type == EntryTable::TYPE_STRING || type == EntryTable::TYPE_BYTES) {
+        return cache.setData(key, keyLen, type, data, len);
+    }
     
-    return true;
+    // Numbers are decimal text on flash; parsed once here
+    char text[NUMBER_TEXT];
+    size_t n = len < NUMBER_TEXT - 1 ? len : NUMBER_TEXT - 1;
+    memcpy(text, data, n);
+    text[n] = '\0';
+    
+    uint32_t value;
+    if (type == EntryTable::TYPE_INT) {
+        value = (uint32_t)strtol(text, nullptr, 10);
+    } else if (type == EntryTable::TYPE_UINT) {
+        value = strtoul(text, nullptr, 10);
+    } else {
+        value = strcmp(text, "1") == 0;
+    }
+    return cache.setNumber(key, keyLen, type, value);
 }
 
-uint32_t StorageEEPROM::getUInt(const char* key, uint32_t defaultValue) {
-    if (!initialized) return defaultValue;
-    
-    auto it = cache.find(key);
-    if (it == cache.end() || it->second.type != TYPE_UINT) {
-        return defaultValue;
+uint16_t StorageEEPROM::recordData(const Entry& entry, char* text, const uint8_t*& data) {
+    if (entry.hasData()) {
+        data = cache.dataOf(entry);
+        return entry.value.data.length;
     }
     
-    return (uint32_t)it->second.value.toInt();
+    int len = 0;
+    if (entry.type == EntryTable::TYPE_INT) {
+        len = snprintf(text, NUMBER_TEXT, "%ld", (long)entry.value.i);
+    } else if (entry.type == EntryTable::TYPE_UINT) {
+        len = snprintf(text, NUMBER_TEXT, "%lu", (unsigned long)entry.value.u);
+    } else if (entry.type == EntryTable::TYPE_BOOL) {
+        text[0] = entry.value.u ? '1' : '0';
+        len = 1;
+    }
+    data = (const uint8_t*)text;
+    return len;
 }
 
-bool StorageEEPROM::putUInt(const char* key, uint32_t value) {
-    if (!initialized) return false;
-    
-    Entry entry;
-    entry.type = TYPE_UINT;
-    entry.value = String(value);
-    cache[key] = entry;
-    dirty = true;
-    
-    return true;
+uint16_t StorageEEPROM::recordSize(const Entry& entry) {
+    char text[NUMBER_TEXT];
+    const uint8_t* data;
+    return RECORD_HEADER + entry.keyLen + recordData(entry, text, data) + RECORD_CRC;
 }
 
-bool StorageEEPROM::getBool(const char* key, bool defaultValue) {
-    if (!initialized) return defaultValue;
-    
-    auto it = cache.find(key);
-    if (it == cache.end() || it->second.type != TYPE_BOOL) {
-        return defaultValue;
+bool StorageEEPROM::loadFromEEPROM() {
+    // Headers alone say which slot is newest; only that one is read in full
+    SlotHeader headers[2];
+    bool valid[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        valid[i] = readHeader(i, headers[i]);
     }
     
-    return it->second.value == "1";
-}
-
-bool StorageEEPROM::putBool(const char* key, bool value) {
-    if (!initialized) return false;
+    uint8_t order[2] = {0, 1};
+    if (valid[1] && (!valid[0] || headers[1].generation > headers[0].generation)) {
+        order[0] = 1;
+        order[1] = 0;
+    }
     
-    Entry entry;
-    entry.type = TYPE_BOOL;
-    entry.value = value ? "1" : "0";
-    cache[key] = entry;
-    dirty = true;
+    for (uint8_t i = 0; i < 2; i++) {
+        uint8_t slot = order[i];
+        if (!valid[slot]) {
+            continue;
+        }
+        if (loadSlot(slot, headers[slot])) {
+            return true;
+        }
+        // Torn or corrupted: the other slot still holds the previous commit
+        ION_LOG_W("EEPROM slot %d is damaged, using the other one", slot);
+    }
     
-    return true;
+    return loadLegacy();
 }
 
-bool StorageEEPROM::remove(const char* key) {
-    if (!initialized) return false;
+bool StorageEEPROM::readHeader(uint8_t slot, SlotHeader& header) {
+    if (!sectors[slot]) {
+        return false;
+    }
     
-    auto it = cache.find(key);
-    if (it != cache.end()) {
-        cache.erase(it);
-        dirty = true;
-        return true;
+    uint32_t raw[4];
+    if (!ESP.flashRead(sectors[slot] * EEPROM_SIZE, raw, sizeof(raw))) {
+        return false;
     }
     
-    return false;
+    const uint8_t* p = (const uint8_t*)raw;
+    if (read32(p) != MAGIC || p[4] != VERSION) {
+        return false;
+    }
+    header.nsLen = p[5];
+    header.generation = read32(p + 6);
+    header.used = p[10] | ((uint16_t)p[11] << 8);
+    header.crc = p[12] | ((uint16_t)p[13] << 8);
+    return header.used >= HEADER_SIZE + header.nsLen && header.used <= EEPROM_SIZE;
 }
 
-bool StorageEEPROM::commit() {
-    if (!initialized || !dirty) return true;
+bool StorageEEPROM::loadSlot(uint8_t slot, const SlotHeader& header) {
+    // The whole sector: commits appended since compaction follow `used`
+    if (!ESP.flashRead(sectors[slot] * EEPROM_SIZE, (uint32_t*)image, EEPROM_SIZE)) {
+        return false;
+    }
+    if (slotChecksum(header.used) != header.crc) {
+        return false;
+    }
     
-    bool success = saveToEEPROM();
-    if (success) {
-        dirty = false;
+    // A valid slot of another namespace means the storage is not ours
+    if (header.nsLen != currentNamespace.length() ||
+        memcmp(image + HEADER_SIZE, currentNamespace.c_str(), header.nsLen) != 0) {
+        return false;
     }
     
-    return success;
+    activeSlot = slot;
+    generation = header.generation;
+    cache.clear();
+    logStart = HEADER_SIZE + header.nsLen;
+    replayLog(header.used);
+    
+    // A torn append leaves programmed bytes past the last complete commit;
+    // flash cannot be rewritten there without an erase, so the next commit
+    // compacts to the other slot instead
+    appendable = logEnd % 4 == 0;
+    for (uint16_t i = logEnd; appendable && i < EEPROM_SIZE; i++) {
+        appendable = image[i] == 0xFF;
+    }
+    return true;
 }
 
-bool StorageEEPROM::loadFromEEPROM() {
-    uint16_t addr = 0;
-    
-    // Check magic
-    uint32_t magic = 0;
-    for (int i = 0; i < 4; i++) {
-        magic |= ((uint32_t)EEPROM.read(addr++) << (i * 8));
-    }
-    
-    if (magic != MAGIC) {
+bool StorageEEPROM::loadLegacy() {
+    // Versions 1 and 2 were written by the EEPROM library to its sector
+    if (!ESP.flashRead(sectors[0] * EEPROM_SIZE, (uint32_t*)image, EEPROM_SIZE)) {
         return false;
     }
     
-    // Check version
-    uint8_t version = EEPROM.read(addr++);
-    if (version != VERSION) {
+    uint16_t addr = 0;
+    if (read32(image) != MAGIC) {
         return false;
     }
+    addr += 4;
     
-    // Read namespace length and namespace
-    uint8_t nsLen = EEPROM.read(addr++);
-    String ns = "";
-    for (uint8_t i = 0; i < nsLen; i++) {
-        ns += (char)EEPROM.read(addr++);
+    uint8_t version = image[addr++];
+    if (version != VERSION_LOG && version != VERSION_FLAT) {
+        return false;
     }
     
-    if (ns != currentNamespace) {
+    uint8_t nsLen = image[addr++];
+    if (nsLen != currentNamespace.length() ||
+        memcmp(image + addr, currentNamespace.c_str(), nsLen) != 0) {
         return false;
     }
+    addr += nsLen;
     
-    // Read entries
     cache.clear();
+    if (version == VERSION_LOG) {
+        logStart = addr;
+        replayLog(0);
+    } else {
+        loadFlat(addr);
+    }
+    
+    // Rewrite in the current format; this goes to slot B when there is one,
+    // so the old image stays readable until the new one is complete
+    ION_LOG("Converting EEPROM storage to version %d", VERSION);
+    activeSlot = 0;
+    generation = 0;
+    dirty = true;
+    if (!saveToEEPROM()) {
+        ION_LOG_E("EEPROM conversion failed");
+    }
+    return true;
+}
+
+void StorageEEPROM::loadFlat(uint16_t addr) {
+    // Version 1: one flat image rewritten on every commit
     while (addr < EEPROM_SIZE - 3) { // Need at least 3 bytes for entry header
-        uint8_t keyLen = EEPROM.read(addr++);
+        uint8_t keyLen = image[addr++];
         if (keyLen == 0 || keyLen == 0xFF) break; // End marker or uninitialized
+        if (addr + keyLen + 3 > EEPROM_SIZE) break;
+        
+        const char* key = (const char*)image + addr;
+        addr += keyLen;
         
-        // Read key
-        String key = "";
-        for (uint8_t i = 0; i < keyLen; i++) {
-            key += (char)EEPROM.read(addr++);
+        DataType type = (DataType)image[addr++];
+        uint16_t dataLen = image[addr] | ((uint16_t)image[addr + 1] << 8);
+        addr += 2;
+        if (addr + dataLen > EEPROM_SIZE) break;
+        if (type == EntryTable::TYPE_DELETED || type > EntryTable::TYPE_BYTES) break;
+        
+        storeRecord(key, keyLen, type, (const char*)image + addr, dataLen);
+        addr += dataLen;
+    }
+}
+
+void StorageEEPROM::replayLog(uint16_t verifiedEnd) {
+    // Records of a commit are applied once its last record checks out, so
+    // a torn append (power cut mid-write) drops that commit and nothing else.
+    // Only their offsets are kept until then; values are read from the image.
+    // Records up to verifiedEnd are covered by the slot checksum.
+    std::vector<uint16_t> pending;
+    pending.reserve(8);
+    uint32_t pendingSeq = 0;
+    uint16_t addr = skipPadding(logStart);
+    
+    sequence = 0;
+    logEnd = addr;
+    
+    while (addr + RECORD_HEADER + RECORD_CRC <= EEPROM_SIZE) {
+        if (image[addr] != RECORD_MARKER) {
+            break;
         }
         
-        // Read type and data
-        DataType type = (DataType)EEPROM.read(addr++);
-        uint16_t dataLen = EEPROM.read(addr++);
-        dataLen |= ((uint16_t)EEPROM.read(addr++) << 8);
+        const uint8_t* header = image + addr;
+        uint32_t seq = read32(header + 1);
+        uint8_t type = header[5];
+        uint8_t keyLen = header[6];
+        uint16_t dataLen = header[7] | ((uint16_t)header[8] << 8);
         
-        String value = "";
-        for (uint16_t i = 0; i < dataLen; i++) {
-            value += (char)EEPROM.read(addr++);
+        uint32_t end = (uint32_t)addr + RECORD_HEADER + keyLen + dataLen + RECORD_CRC;
+        if (keyLen == 0 || (type & ~RECORD_LAST) > EntryTable::TYPE_BYTES || end > EEPROM_SIZE) {
+            break;
         }
         
-        Entry entry;
-        entry.type = type;
-        entry.value = value;
-        cache[key] = entry;
+        // Checksummed records need no second pass per record
+        if (end > verifiedEnd) {
+            uint16_t crc = Hash::crc16(header + 1, end - RECORD_CRC - addr - 1);
+            uint16_t stored = image[end - 2] | ((uint16_t)image[end - 1] << 8);
+            if (crc != stored) {
+                break;
+            }
+        }
+        
+        // Stale records left behind by compaction have older sequence numbers
+        if (seq <= sequence || (!pending.empty() && seq != pendingSeq)) {
+            break;
+        }
+        
+        pending.push_back(addr);
+        pendingSeq = seq;
+        addr = end;
+        
+        if (type & RECORD_LAST) {
+            for (uint16_t record : pending) {
+                applyRecord(record);
+            }
+            pending.clear();
+            sequence = seq;
+            addr = skipPadding(addr);
+            logEnd = addr;
+        }
+    }
+}
+
+void StorageEEPROM::applyRecord(uint16_t addr) {
+    // Lengths were checked against the image by replayLog(). Values are
+    // copied into the table; a key updated many times in the log reuses
+    // its bytes as long as later values are no longer.
+    const uint8_t* header = image + addr;
+    DataType type = (DataType)(header[5] & ~RECORD_LAST);
+    uint8_t keyLen = header[6];
+    uint16_t dataLen = header[7] | ((uint16_t)header[8] << 8);
+    const char* key = (const char*)header + RECORD_HEADER;
+    
+    if (type == EntryTable::TYPE_DELETED) {
+        int index = cache.find(key, keyLen);
+        if (index >= 0) {
+            cache.erase(index);
+        }
+        return;
     }
     
-    return true;
+    int index = storeRecord(key, keyLen, type, key + keyLen, dataLen);
+    if (index >= 0) {
+        cache.at(index).dirty = false;
+    } else {
+        ION_LOG_E("EEPROM: out of memory");
+    }
 }
 
 bool StorageEEPROM::saveToEEPROM() {
-    uint16_t addr = 0;
-    
-    // Write magic
-    for (int i = 0; i < 4; i++) {
-        EEPROM.write(addr++, (MAGIC >> (i * 8)) & 0xFF);
+    // Entries stay dirty until the slot is written, so a failed save is
+    // retried by the next commit()
+    if (!compact() || !writeSlot()) {
+        return false;
     }
     
-    // Write version
-    EEPROM.write(addr++, VERSION);
+    markClean();
+    return true;
+}
+
+bool StorageEEPROM::writeSlot() {
+    // The compacted image goes to the slot not holding the current commit,
+    // header last; until that write completes, boot still finds the
+    // previous slot intact
+    uint8_t target = sectors[1] ? activeSlot ^ 1 : activeSlot;
+    
+    write32(image, MAGIC);
+    image[4] = VERSION;
+    image[5] = currentNamespace.length();
+    write32(image + 6, generation + 1);
+    image[10] = logEnd & 0xFF;
+    image[11] = (logEnd >> 8) & 0xFF;
+    uint16_t crc = slotChecksum(logEnd);
+    image[12] = crc & 0xFF;
+    image[13] = (crc >> 8) & 0xFF;
+    
+    // compact() leaves logEnd on a word boundary, past the header's
+    // first four words
+    uint32_t address = sectors[target] * EEPROM_SIZE;
+    if (!ESP.flashEraseSector(sectors[target]) ||
+        (logEnd > 16 && !ESP.flashWrite(address + 16, (uint32_t*)(image + 16), logEnd - 16)) ||
+        !ESP.flashWrite(address, (uint32_t*)image, 16)) {
+        ION_LOG_E("EEPROM: flash write failed");
+        appendable = false;
+        return false;
+    }
     
-    // Write namespace
-    uint8_t nsLen = currentNamespace.length();
-    EEPROM.write(addr++, nsLen);
-    for (uint8_t i = 0; i < nsLen; i++) {
-        EEPROM.write(addr++, currentNamespace[i]);
+    activeSlot = target;
+    generation++;
+    appendable = true;
+    return true;
+}
+
+uint16_t StorageEEPROM::slotChecksum(uint16_t used) {
+    // Generation and length, then namespace and log; skips magic and the CRC
+    uint16_t crc = Hash::crc16(image + 4, 8);
+    return Hash::crc16(image + HEADER_SIZE, used - HEADER_SIZE, crc);
+}
+
+uint32_t StorageEEPROM::backupSector(uint32_t eepromSector) {
+#if ION_EEPROM_BACKUP_SECTOR
+    (void)eepromSector;
+    return ION_EEPROM_BACKUP_SECTOR;
+#else
+    // Layouts with an 8 KB filesystem block size leave the sector just below
+    // EEPROM unused; anything else would overlap the filesystem
+    uint32_t fsEnd = ((uint32_t)(uintptr_t)&_FS_end - FLASH_MAPPED_BASE) / EEPROM_SIZE;
+    return fsEnd < eepromSector ? eepromSector - 1 : 0;
+#endif
+}
+
+bool StorageEEPROM::appendDirty() {
+    // Nothing to build on: a torn tail, or no slot in this format yet
+    if (!appendable) {
+        return false; // Caller compacts
     }
     
-    // Write entries
-    for (const auto& pair : cache) {
-        const String& key = pair.first;
-        const Entry& entry = pair.second;
-        
-        // Check if we have enough space
-        uint16_t needed = 1 + key.length() + 1 + 2 + entry.value.length();
-        if (addr + needed >= EEPROM_SIZE) {
-            return false; // Not enough space
+    // Check the whole commit fits before touching the image
+    uint32_t needed = 0;
+    int last = -1;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache.at(i).dirty) {
+            needed += recordSize(cache.at(i));
+            last = i;
         }
-        
-        // Write key length and key
-        EEPROM.write(addr++, (uint8_t)key.length());
-        for (size_t i = 0; i < key.length(); i++) {
-            EEPROM.write(addr++, key[i]);
+    }
+    if (last < 0) {
+        return true;
+    }
+    if (logEnd + align4(needed) > EEPROM_SIZE) {
+        return false; // Caller compacts
+    }
+    
+    sequence++;
+    uint16_t addr = logEnd;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache.at(i).dirty) {
+            addr = writeRecord(addr, cache.at(i), (int)i == last);
         }
-        
-        // Write type
-        EEPROM.write(addr++, (uint8_t)entry.type);
-        
-        // Write data length (2 bytes)
-        uint16_t dataLen = entry.value.length();
-        EEPROM.write(addr++, dataLen & 0xFF);
-        EEPROM.write(addr++, (dataLen >> 8) & 0xFF);
-        
-        // Write data
-        for (uint16_t i = 0; i < dataLen; i++) {
-            EEPROM.write(addr++, entry.value[i]);
+    }
+    addr = pad(addr);
+    
+    // Erased flash is all ones, so only the new words are programmed; the
+    // header and earlier commits are not touched
+    uint32_t address = sectors[activeSlot] * EEPROM_SIZE + logEnd;
+    if (!ESP.flashWrite(address, (uint32_t*)(image + logEnd), addr - logEnd)) {
+        ION_LOG_W("EEPROM: append failed, compacting");
+        sequence--;
+        appendable = false;
+        return false;
+    }
+    logEnd = addr;
+    return true;
+}
+
+bool StorageEEPROM::compact() {
+    // Header, then one record per live key
+    uint8_t nsLen = currentNamespace.length();
+    uint32_t needed = HEADER_SIZE + nsLen + 3; // Padding
+    int last = -1;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache.at(i).type != EntryTable::TYPE_DELETED) {
+            needed += recordSize(cache.at(i));
+            last = i;
         }
     }
+    if (needed > EEPROM_SIZE) {
+        ION_LOG_E("EEPROM: data does not fit in %d bytes", EEPROM_SIZE);
+        return false;
+    }
     
-    // Write end marker
-    if (addr < EEPROM_SIZE) {
-        EEPROM.write(addr, 0);
+    // The rest of the header is filled in by writeSlot()
+    uint16_t addr = HEADER_SIZE;
+    memcpy(image + addr, currentNamespace.c_str(), nsLen);
+    addr += nsLen;
+    logStart = addr;
+    
+    // Live keys go in as a single commit
+    sequence++;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache.at(i).type != EntryTable::TYPE_DELETED) {
+            addr = writeRecord(addr, cache.at(i), (int)i == last);
+        }
     }
+    logEnd = pad(addr);
     
-    return EEPROM.commit();
+    ION_LOG("EEPROM log compacted: %d bytes", logEnd);
+    return true;
+}
+
+uint16_t StorageEEPROM::skipPadding(uint16_t addr) {
+    // Commits start on a word boundary; the gap before one is erased flash
+    while (addr % 4 && addr < EEPROM_SIZE && image[addr] == 0xFF) {
+        addr++;
+    }
+    return addr;
+}
+
+uint16_t StorageEEPROM::pad(uint16_t addr) {
+    // Left erased, so the next commit can be programmed over it
+    uint16_t end = align4(addr);
+    memset(image + addr, 0xFF, end - addr);
+    return end;
+}
+
+uint16_t StorageEEPROM::writeRecord(uint16_t addr, const Entry& entry, bool last) {
+    char text[NUMBER_TEXT];
+    const uint8_t* data;
+    uint16_t dataLen = recordData(entry, text, data);
+    uint8_t header[RECORD_HEADER] = {
+        RECORD_MARKER,
+        (uint8_t)(sequence & 0xFF),
+        (uint8_t)((sequence >> 8) & 0xFF),
+        (uint8_t)((sequence >> 16) & 0xFF),
+        (uint8_t)((sequence >> 24) & 0xFF),
+        (uint8_t)(entry.type | (last ? RECORD_LAST : 0)),
+        entry.keyLen,
+        (uint8_t)(dataLen & 0xFF),
+        (uint8_t)((dataLen >> 8) & 0xFF)
+    };
+    
+    uint16_t start = addr;
+    memcpy(image + addr, header, RECORD_HEADER);
+    addr += RECORD_HEADER;
+    memcpy(image + addr, cache.keyOf(entry), entry.keyLen);
+    addr += entry.keyLen;
+    memcpy(image + addr, data, dataLen);
+    addr += dataLen;
+    
+    uint16_t crc = Hash::crc16(image + start + 1, addr - start - 1);
+    image[addr++] = crc & 0xFF;
+    image[addr++] = (crc >> 8) & 0xFF;
+    
+    return addr;
 }
 
 } // namespace IonConnect
 
 #endif // ION_PLATFORM_ESP8266
-
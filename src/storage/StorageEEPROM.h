@@ -1,22 +1,41 @@
 #ifndef STORAGE_EEPROM_H
 #define STORAGE_EEPROM_H
 
-#include "StorageProvider.h"
+#include "CachedStorage.h"
 
 #if ION_PLATFORM_ESP8266
 
-#include <EEPROM.h>
-#include <map>
+#include <vector>
 
 namespace IonConnect {
 
 /**
  * @brief EEPROM-based storage implementation for ESP8266
  * 
- * Emulates NVS-like key-value storage using EEPROM
- * Data format: [magic][version][key1_len][key1][type][data_len][data][key2_len][key2]...
+ * Emulates NVS-like key-value storage as an append-only log in one flash
+ * sector: [magic][version][ns_len][generation][used][crc16][ns][record]...
+ * 
+ * Each record is [marker][seq][type][key_len][data_len][key][data][crc16],
+ * with numbers as decimal text. In RAM the namespace is an EntryTable.
+ * commit() appends one record per changed key (a tombstone for removals),
+ * all with the same sequence number; the last one is flagged, so a commit
+ * is only replayed if all of its records are intact. When the log reaches
+ * the end of the region it is compacted to one record per live key.
+ * 
+ * The image alternates between two sectors (A is the EEPROM sector, B the
+ * spare one below it, see ION_EEPROM_BACKUP_SECTOR). Commits are padded to
+ * whole words and programmed into the erased tail of the active slot, so a
+ * commit writes only its own records; nothing is erased or rewritten. Each
+ * record carries its own CRC, and a torn append fails it and is dropped at
+ * boot. Compaction erases the other slot and writes the compacted log there
+ * with the generation incremented, header last; the header checksum covers
+ * the compacted part up to `used`. Boot reads both headers, loads the newer
+ * slot and falls back to the other if it fails its checksum, so a power cut
+ * mid-commit loses that commit only. A slot whose tail is no longer erased
+ * (a torn append) is compacted on the next commit. Without a spare sector,
+ * compaction rewrites sector A in place.
  */
-class StorageEEPROM : public StorageProvider {
+class StorageEEPROM : public CachedStorage {
 public:
     StorageEEPROM();
     virtual ~StorageEEPROM();
@@ -24,48 +43,62 @@ public:
     bool begin(const char* ns = "ionconnect") override;
     void end() override;
     bool clear() override;
-    bool exists(const char* key) override;
-    
-    String getString(const char* key, const String& defaultValue = "") override;
-    bool putString(const char* key, const String& value) override;
-    
-    int getInt(const char* key, int defaultValue = 0) override;
-    bool putInt(const char* key, int value) override;
-    
-    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) override;
-    bool putUInt(const char* key, uint32_t value) override;
-    
-    bool getBool(const char* key, bool defaultValue = false) override;
-    bool putBool(const char* key, bool value) override;
-    
-    bool remove(const char* key) override;
     bool commit() override;
     
 private:
-    static const uint16_t EEPROM_SIZE = 4096;
+    static const uint16_t EEPROM_SIZE = 4096;   // One flash sector per slot
     static const uint32_t MAGIC = 0x494F4E43; // "IONC"
-    static const uint8_t VERSION = 1;
+    static const uint8_t VERSION = 3;
+    static const uint8_t VERSION_LOG = 2;       // Single-sector log, read for migration
+    static const uint8_t VERSION_FLAT = 1;      // Flat image, read for migration
+    static const uint16_t HEADER_SIZE = 14;     // magic, version, ns_len, generation, used, crc
+    static const uint8_t RECORD_MARKER = 0xA5;
+    static const uint8_t RECORD_LAST = 0x80;    // Type flag: last record of a commit
+    static const uint16_t RECORD_HEADER = 9;    // marker, seq, type, key_len, data_len
+    static const uint16_t RECORD_CRC = 2;
+    static const size_t NUMBER_TEXT = 12;       // "-2147483648" and terminator
     
-    enum DataType : uint8_t {
-        TYPE_STRING = 1,
-        TYPE_INT = 2,
-        TYPE_UINT = 3,
-        TYPE_BOOL = 4
-    };
+    // Record types are the table's value types
+    typedef EntryTable::DataType DataType;
+    typedef EntryTable::Entry Entry;
     
-    struct Entry {
-        DataType type;
-        String value;
+    struct SlotHeader {
+        uint8_t nsLen;
+        uint32_t generation;
+        uint16_t used;          // Header, namespace and compacted log
+        uint16_t crc;
     };
     
-    bool initialized;
-    bool dirty;
     String currentNamespace;
-    std::map<String, Entry> cache;
+    uint8_t* image;             // RAM copy of the active slot
+    uint32_t sectors[2];        // Flash sector of each slot, 0 = none
+    uint8_t activeSlot;         // Holds the last complete commit
+    uint32_t generation;        // Of the active slot
+    uint16_t logStart;          // First record, after the header
+    uint16_t logEnd;            // Next append position
+    uint32_t sequence;          // Of the last complete commit
+    bool appendable;            // Flash past logEnd in the active slot is erased
+    bool cleared;               // By clear() since the last commit
     
     bool loadFromEEPROM();
-    bool saveToEEPROM();
-    void buildCache();
+    bool readHeader(uint8_t slot, SlotHeader& header);
+    bool loadSlot(uint8_t slot, const SlotHeader& header);
+    bool loadLegacy();
+    void loadFlat(uint16_t addr);
+    void replayLog(uint16_t verifiedEnd);
+    void applyRecord(uint16_t addr);
+    bool saveToEEPROM();        // Compact and commit
+    bool writeSlot();
+    uint16_t slotChecksum(uint16_t used);
+    static uint32_t backupSector(uint32_t eepromSector);
+    bool appendDirty();
+    bool compact();
+    uint16_t pad(uint16_t addr);
+    uint16_t skipPadding(uint16_t addr);
+    uint16_t writeRecord(uint16_t addr, const Entry& entry, bool last);
+    uint16_t recordData(const Entry& entry, char* text, const uint8_t*& data);
+    uint16_t recordSize(const Entry& entry);
+    int storeRecord(const char* key, uint8_t keyLen, DataType type, const char* data, uint16_t len);
 };
 
 } // namespace IonConnect
@@ -0,0 +1,257 @@
+#include "StorageLittleFS.h"
+
+#if ION_USE_LITTLEFS
+
+#include "../utils/Hash.h"
+#include "../utils/Logger.h"
+
+namespace IonConnect {
+
+static uint32_t read32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+StorageLittleFS::StorageLittleFS(fs::FS& filesystem, const char* dir)
+    : filesystem(filesystem), directory(dir) {
+}
+
+StorageLittleFS::~StorageLittleFS() {
+    end();
+}
+
+bool StorageLittleFS::begin(const char* ns) {
+    if (initialized && currentNamespace == ns) {
+        return true;
+    }
+    
+    if (initialized) {
+        end();
+    }
+    
+    if (!filesystem.exists(directory) && !filesystem.mkdir(directory)) {
+        ION_LOG_E("LittleFS storage: cannot create %s", directory.c_str());
+        return false;
+    }
+    
+    currentNamespace = ns;
+    String path = filePath("dat");
+    String tmp = filePath("tmp");
+    
+    if (!loadFile(path)) {
+        if (loadFile(tmp)) {
+            // A commit stopped between writing and renaming; finish it
+            ION_LOG_W("LittleFS storage: recovered %s", tmp.c_str());
+            filesystem.rename(tmp, path);
+        } else {
+            cache.clear();
+        }
+    }
+    
+    markClean();
+    initialized = true;
+    return true;
+}
+
+void StorageLittleFS::end() {
+    if (initialized && dirty) {
+        commit();
+    }
+    cache.clear();
+    initialized = false;
+    dirty = false;
+}
+
+bool StorageLittleFS::clear() {
+    if (!initialized) return false;
+    
+    // The next commit() replaces the file with an empty one
+    cache.clear();
+    dirty = true;
+    return true;
+}
+
+bool StorageLittleFS::commit() {
+    if (!initialized || !dirty) return true;
+    
+    String path = filePath("dat");
+    String tmp = filePath("tmp");
+    
+    bool success = writeFile(tmp);
+    if (success && !filesystem.rename(tmp, path)) {
+        // Some filesystems don't rename over an existing file. Until the
+        // second rename the complete copy is the .tmp, which begin() loads.
+        success = filesystem.remove(path) && filesystem.rename(tmp, path);
+    }
+    
+    if (success) {
+        markClean();
+    } else {
+        ION_LOG_E("LittleFS storage commit failed");
+    }
+    
+    return success;
+}
+
+String StorageLittleFS::filePath(const char* extension) {
+    String path = directory;
+    path += '/';
+    path += currentNamespace;
+    path += '.';
+    path += extension;
+    return path;
+}
+
+bool StorageLittleFS::loadFile(const String& path) {
+    if (!filesystem.exists(path)) {
+        return false;
+    }
+    
+    File file = filesystem.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    
+    uint8_t header[HEADER_SIZE];
+    if (file.read(header, HEADER_SIZE) != HEADER_SIZE ||
+        read32(header) != MAGIC || header[4] != VERSION) {
+        file.close();
+        ION_LOG_W("LittleFS storage: %s has an unknown format", path.c_str());
+        return false;
+    }
+    
+    uint16_t crc = Hash::crc16(header, HEADER_SIZE);
+    uint16_t count = header[5] | (header[6] << 8);
+    
+    // Values are read into one scratch buffer, grown to the largest so far
+    cache.clear();
+    uint8_t* data = nullptr;
+    size_t dataSize = 0;
+    bool valid = true;
+    
+    for (uint16_t i = 0; valid && i < count; i++) {
+        uint8_t record[RECORD_HEADER];
+        char key[256];
+        if (file.read(record, RECORD_HEADER) != RECORD_HEADER) {
+            valid = false;
+            break;
+        }
+        
+        DataType type = (DataType)record[0];
+        uint8_t keyLen = record[1];
+        uint16_t len = record[2] | (record[3] << 8);
+        
+        if (!data || len > dataSize) {
+            size_t size = len < 32 ? 32 : len;
+            uint8_t* grown = (uint8_t*)realloc(data, size);
+            if (!grown) {
+                ION_LOG_E("LittleFS storage: out of memory");
+                valid = false;
+                break;
+            }
+            data = grown;
+            dataSize = size;
+        }
+        
+        if (file.read((uint8_t*)key, keyLen) != keyLen ||
+            (len && file.read(data, len) != len)) {
+            valid = false;
+            break;
+        }
+        
+        crc = Hash::crc16(record, RECORD_HEADER, crc);
+        crc = Hash::crc16((const uint8_t*)key, keyLen, crc);
+        crc = Hash::crc16(data, len, crc);
+        
+        int index = -1;
+        if (type == EntryTable::TYPE_STRING || type == EntryTable::TYPE_BYTES) {
+            index = cache.setData(key, keyLen, type, data, len);
+        } else if ((type == EntryTable::TYPE_INT || type == EntryTable::TYPE_UINT ||
+                    type == EntryTable::TYPE_BOOL) && len == 4) {
+            index = cache.setNumber(key, keyLen, type, read32(data));
+        }
+        valid = index >= 0;
+    }
+    
+    uint8_t trailer[2];
+    valid = valid && file.read(trailer, 2) == 2 && (trailer[0] | (trailer[1] << 8)) == crc;
+    
+    free(data);
+    file.close();
+    
+    if (!valid) {
+        cache.clear();
+        ION_LOG_W("LittleFS storage: %s is damaged", path.c_str());
+    }
+    return valid;
+}
+
+bool StorageLittleFS::writeFile(const String& path) {
+    File file = filesystem.open(path, "w");
+    if (!file) {
+        return false;
+    }
+    
+    uint16_t count = 0;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache.at(i).type != EntryTable::TYPE_DELETED) {
+            count++;
+        }
+    }
+    
+    uint8_t header[HEADER_SIZE];
+    write32(header, MAGIC);
+    header[4] = VERSION;
+    header[5] = count & 0xFF;
+    header[6] = count >> 8;
+    
+    uint16_t crc = 0xFFFF;
+    bool success = writeChunk(file, header, HEADER_SIZE, crc);
+    
+    for (size_t i = 0; success && i < cache.size(); i++) {
+        const Entry& entry = cache.at(i);
+        if (entry.type == EntryTable::TYPE_DELETED) {
+            continue;
+        }
+        
+        uint8_t number[4];
+        const uint8_t* data = number;
+        uint16_t len = sizeof(number);
+        if (entry.hasData()) {
+            data = cache.dataOf(entry);
+            len = entry.value.data.length;
+        } else {
+            write32(number, entry.value.u);
+        }
+        
+        uint8_t record[RECORD_HEADER] = {
+            entry.type, entry.keyLen, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)
+        };
+        success = writeChunk(file, record, RECORD_HEADER, crc) &&
+                  writeChunk(file, cache.keyOf(entry), entry.keyLen, crc) &&
+                  writeChunk(file, data, len, crc);
+    }
+    
+    uint8_t trailer[2] = { (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8) };
+    success = success && file.write(trailer, 2) == 2;
+    
+    file.close();
+    return success;
+}
+
+bool StorageLittleFS::writeChunk(File& file, const void* data, size_t len, uint16_t& crc) {
+    if (len && file.write((const uint8_t*)data, len) != len) {
+        return false;
+    }
+    crc = Hash::crc16((const uint8_t*)data, len, crc);
+    return true;
+}
+
+} // namespace IonConnect
+
+#endif // ION_USE_LITTLEFS
@@ -0,0 +1,63 @@
+#ifndef STORAGE_LITTLEFS_H
+#define STORAGE_LITTLEFS_H
+
+#include "../core/IonTypes.h"
+#include "CachedStorage.h"
+
+#if ION_USE_LITTLEFS
+
+#include <FS.h>
+#include <LittleFS.h>
+
+namespace IonConnect {
+
+/**
+ * @brief LittleFS-based storage for configurations that outgrow NVS/EEPROM
+ * 
+ * Each namespace is one packed file, <dir>/<ns>.dat:
+ * [magic][version][count][record]...[crc16], where a record is
+ * [type][key_len][data_len][key][data] and numbers are 4 bytes little-endian.
+ * 
+ * The file is read into an EntryTable at begin() and every access after
+ * that is served from RAM. commit() writes the whole namespace to
+ * <ns>.tmp and renames it over <ns>.dat, so the data file is always either
+ * the previous or the new version. If <ns>.dat is missing or fails its
+ * checksum, begin() falls back to a complete <ns>.tmp left by an
+ * interrupted commit.
+ * 
+ * The filesystem must be mounted before begin(). Any fs::FS works, which
+ * makes the provider usable against other filesystems and in host tests.
+ */
+class StorageLittleFS : public CachedStorage {
+public:
+    StorageLittleFS(fs::FS& filesystem = LittleFS, const char* dir = "/ionconnect");
+    virtual ~StorageLittleFS();
+    
+    bool begin(const char* ns = "ionconnect") override;
+    void end() override;
+    bool clear() override;
+    bool commit() override;
+    
+private:
+    static const uint32_t MAGIC = 0x494F4E46; // "IONF"
+    static const uint8_t VERSION = 1;
+    static const uint16_t HEADER_SIZE = 7;      // magic, version, count
+    static const uint16_t RECORD_HEADER = 4;    // type, key_len, data_len
+    
+    typedef EntryTable::DataType DataType;
+    typedef EntryTable::Entry Entry;
+    
+    fs::FS& filesystem;
+    String directory;
+    String currentNamespace;
+    
+    String filePath(const char* extension);
+    bool loadFile(const String& path);
+    bool writeFile(const String& path);
+    static bool writeChunk(File& file, const void* data, size_t len, uint16_t& crc);
+};
+
+} // namespace IonConnect
+
+#endif // ION_USE_LITTLEFS
+#endif // STORAGE_LITTLEFS_H
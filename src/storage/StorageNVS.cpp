@@ -1,15 +1,25 @@
 #include "../core/IonTypes.h"
 #include "StorageNVS.h"
+#include "../utils/Logger.h"
 
 #if ION_PLATFORM_ESP32
 
 namespace IonConnect {
 
-StorageNVS::StorageNVS() : initialized(false) {
+// Totals over every instance, each committing under its own commitLock
+StorageNVS::Stats StorageNVS::stats = {0, 0, 0};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+StorageNVS::StorageNVS()
+    : handle(0), initialized(false), clearQueued(false), clearInflight(false) {
+    lock = xSemaphoreCreateMutex();
+    commitLock = xSemaphoreCreateMutex();
 }
 
 StorageNVS::~StorageNVS() {
     end();
+    vSemaphoreDelete(lock);
+    vSemaphoreDelete(commitLock);
 }
 
 bool StorageNVS::begin(const char* ns) {
@@ -22,79 +32,380 @@ bool StorageNVS::begin(const char* ns) {
     }
     
     currentNamespace = ns;
-    initialized = preferences.begin(ns, false); // false = read/write mode
+    esp_err_t err = nvs_open(ns, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ION_LOG_E("NVS open failed: %d", err);
+        return false;
+    }
     
-    return initialized;
+    initialized = true;
+    return true;
 }
 
 void StorageNVS::end() {
     if (initialized) {
-        preferences.end();
+        commit();
+        nvs_close(handle);
         initialized = false;
     }
+    pending.clear();
+    clearQueued = false;
 }
 
 bool StorageNVS::clear() {
     if (!initialized) return false;
-    return preferences.clear();
+    
+    // Queued like any write: everything before it is dropped
+    xSemaphoreTake(lock, portMAX_DELAY);
+    pending.clear();
+    clearQueued = true;
+    xSemaphoreGive(lock);
+    return true;
 }
 
 bool StorageNVS::exists(const char* key) {
     if (!initialized) return false;
-    return preferences.isKey(key);
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        return write.type != EntryTable::TYPE_DELETED;
+    }
+    return storedType(key) != EntryTable::TYPE_DELETED;
 }
 
 String StorageNVS::getString(const char* key, const String& defaultValue) {
     if (!initialized) return defaultValue;
-    return preferences.getString(key, defaultValue);
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        if (write.type != EntryTable::TYPE_STRING) {
+            return defaultValue;
+        }
+        String value;
+        value.concat((const char*)write.data.data(), write.data.size());
+        return value;
+    }
+    
+    size_t len = 0;
+    if (nvs_get_str(handle, key, nullptr, &len) != ESP_OK || len == 0) {
+        return defaultValue;
+    }
+    
+    char* buffer = (char*)malloc(len);
+    if (!buffer) {
+        ION_LOG_E("NVS: out of memory");
+        return defaultValue;
+    }
+    
+    String value = defaultValue;
+    if (nvs_get_str(handle, key, buffer, &len) == ESP_OK) {
+        value = buffer;
+    }
+    free(buffer);
+    return value;
 }
 
 bool StorageNVS::putString(const char* key, const String& value) {
     if (!initialized) return false;
-    return preferences.putString(key, value) > 0;
+    return queue(key, EntryTable::TYPE_STRING, 0, value.c_str(), value.length());
 }
 
 int StorageNVS::getInt(const char* key, int defaultValue) {
     if (!initialized) return defaultValue;
-    return preferences.getInt(key, defaultValue);
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        return write.type == EntryTable::TYPE_INT ? (int32_t)write.number : defaultValue;
+    }
+    
+    int32_t value;
+    return nvs_get_i32(handle, key, &value) == ESP_OK ? value : defaultValue;
 }
 
 bool StorageNVS::putInt(const char* key, int value) {
     if (!initialized) return false;
-    return preferences.putInt(key, value) > 0;
+    return queue(key, EntryTable::TYPE_INT, (uint32_t)value);
 }
 
 uint32_t StorageNVS::getUInt(const char* key, uint32_t defaultValue) {
     if (!initialized) return defaultValue;
-    return preferences.getUInt(key, defaultValue);
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        return write.type == EntryTable::TYPE_UINT ? write.number : defaultValue;
+    }
+    
+    uint32_t value;
+    return nvs_get_u32(handle, key, &value) == ESP_OK ? value : defaultValue;
 }
 
 bool StorageNVS::putUInt(const char* key, uint32_t value) {
     if (!initialized) return false;
-    return preferences.putUInt(key, value) > 0;
+    return queue(key, EntryTable::TYPE_UINT, value);
 }
 
 bool StorageNVS::getBool(const char* key, bool defaultValue) {
     if (!initialized) return defaultValue;
-    return preferences.getBool(key, defaultValue);
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        return write.type == EntryTable::TYPE_BOOL ? write.number != 0 : defaultValue;
+    }
+    
+    uint8_t value;
+    return nvs_get_u8(handle, key, &value) == ESP_OK ? value != 0 : defaultValue;
 }
 
 bool StorageNVS::putBool(const char* key, bool value) {
     if (!initialized) return false;
-    return preferences.putBool(key, value) > 0;
+    return queue(key, EntryTable::TYPE_BOOL, value ? 1 : 0);
 }
 
-bool StorageNVS::remove(const char* key) {
+size_t StorageNVS::getBytesLength(const char* key) {
+    if (!initialized) return 0;
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        return write.type == EntryTable::TYPE_BYTES ? write.data.size() : 0;
+    }
+    
+    size_t len = 0;
+    return nvs_get_blob(handle, key, nullptr, &len) == ESP_OK ? len : 0;
+}
+
+size_t StorageNVS::getBytes(const char* key, void* buffer, size_t maxLen) {
+    if (!initialized) return 0;
+    
+    PendingWrite write;
+    if (findQueued(key, write)) {
+        if (write.type != EntryTable::TYPE_BYTES || write.data.empty() || write.data.size() > maxLen) {
+            return 0;
+        }
+        memcpy(buffer, write.data.data(), write.data.size());
+        return write.data.size();
+    }
+    
+    size_t len = 0;
+    if (nvs_get_blob(handle, key, nullptr, &len) != ESP_OK || len == 0 || len > maxLen) {
+        return 0;
+    }
+    return nvs_get_blob(handle, key, buffer, &len) == ESP_OK ? len : 0;
+}
+
+bool StorageNVS::putBytes(const char* key, const void* value, size_t len) {
     if (!initialized) return false;
-    return preferences.remove(key);
+    return queue(key, EntryTable::TYPE_BYTES, 0, value, len);
+}
+
+bool StorageNVS::remove(const char* key) {
+    if (!initialized || !exists(key)) return false;
+    return queue(key, EntryTable::TYPE_DELETED, 0);
 }
 
 bool StorageNVS::commit() {
-    // NVS auto-commits, no action needed
+    if (!initialized) return true;
+    
+    // One commit at a time. The queue is handed over so that puts and reads
+    // from other tasks only wait for the swap, not for flash.
+    xSemaphoreTake(commitLock, portMAX_DELAY);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    inflight.swap(pending);
+    clearInflight = clearQueued;
+    clearQueued = false;
+    xSemaphoreGive(lock);
+    
+    if (inflight.empty() && !clearInflight) {
+        xSemaphoreGive(commitLock);
+        return true;
+    }
+    
+    bool success = true;
+    bool erased = !clearInflight;
+    Stats counted = {0, 0, 1};
+    if (clearInflight) {
+        erased = nvs_erase_all(handle) == ESP_OK;
+        success = erased;
+        if (erased) {
+            counted.writes++;
+        }
+    }
+    
+    // Oldest first, so that a power cut mid-commit leaves a prefix of the
+    // writes applied (ConfigManager's A/B blob relies on this order)
+    size_t written = 0;
+    while (written < inflight.size() && success) {
+        success = writeItem(inflight[written], counted);
+        if (success) {
+            written++;
+        }
+    }
+    
+    // Not committed: none of the writes can be relied on
+    if (nvs_commit(handle) != ESP_OK) {
+        success = false;
+        erased = !clearInflight;
+        written = 0;
+    }
+    
+    portENTER_CRITICAL(&statsMux);
+    stats.writes += counted.writes;
+    stats.bytes += counted.bytes;
+    stats.commits += counted.commits;
+    portEXIT_CRITICAL(&statsMux);
+    
+    // Requeue what was not written, ahead of newer writes, unless a newer
+    // write or clear() replaced it
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool newerClear = clearQueued;
+    if (!erased) {
+        clearQueued = true;
+    }
+    if (!newerClear) {
+        for (size_t i = inflight.size(); i-- > written;) {
+            if (!findIn(pending, inflight[i].key.c_str())) {
+                pending.insert(pending.begin(), std::move(inflight[i]));
+            }
+        }
+    }
+    inflight.clear();
+    clearInflight = false;
+    size_t left = pending.size();
+    xSemaphoreGive(lock);
+    xSemaphoreGive(commitLock);
+    
+    if (!success) {
+        ION_LOG_E("NVS commit failed, %d writes pending", left);
+    }
+    return success;
+}
+
+StorageNVS::DataType StorageNVS::storedType(const char* key) {
+    // NVS looks keys up by type, so try each type this class writes
+    int32_t i32;
+    uint32_t u32;
+    uint8_t u8;
+    size_t len = 0;
+    if (nvs_get_str(handle, key, nullptr, &len) == ESP_OK) return EntryTable::TYPE_STRING;
+    if (nvs_get_blob(handle, key, nullptr, &len) == ESP_OK) return EntryTable::TYPE_BYTES;
+    if (nvs_get_i32(handle, key, &i32) == ESP_OK) return EntryTable::TYPE_INT;
+    if (nvs_get_u32(handle, key, &u32) == ESP_OK) return EntryTable::TYPE_UINT;
+    if (nvs_get_u8(handle, key, &u8) == ESP_OK) return EntryTable::TYPE_BOOL;
+    return EntryTable::TYPE_DELETED;
+}
+
+bool StorageNVS::findQueued(const char* key, PendingWrite& write) {
+    // Newest first: the queue, then the commit in flight, then NVS. A
+    // queued clear() hides everything older than itself.
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const PendingWrite* found = findIn(pending, key);
+    bool cleared = !found && clearQueued;
+    if (!found && !cleared) {
+        found = findIn(inflight, key);
+        cleared = !found && clearInflight;
+    }
+    
+    if (found) {
+        write = *found;
+    } else if (cleared) {
+        write.type = EntryTable::TYPE_DELETED;
+    }
+    xSemaphoreGive(lock);
+    return found || cleared;
+}
+
+const StorageNVS::PendingWrite* StorageNVS::findIn(const std::vector<PendingWrite>& writes, const char* key) {
+    for (const PendingWrite& write : writes) {
+        if (write.key == key) {
+            return &write;
+        }
+    }
+    return nullptr;
+}
+
+bool StorageNVS::queue(const char* key, DataType type, uint32_t number, const void* data, size_t len) {
+    PendingWrite write;
+    write.key = key;
+    write.type = type;
+    write.number = number;
+    if (len) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        write.data.assign(bytes, bytes + len);
+    }
+    
+    // A newer write replaces an older one and moves to the end of the queue
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        if (it->key == key) {
+            pending.erase(it);
+            break;
+        }
+    }
+    pending.push_back(std::move(write));
+    xSemaphoreGive(lock);
+    return true;
+}
+
+StorageNVS::Stats StorageNVS::getStats() {
+    portENTER_CRITICAL(&statsMux);
+    Stats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
+}
+
+bool StorageNVS::writeItem(const PendingWrite& write, Stats& counted) {
+    const char* key = write.key.c_str();
+    size_t bytes = write.data.size();
+    esp_err_t err;
+    
+    // An item of another type under the same key would survive the set
+    if (write.type != EntryTable::TYPE_DELETED) {
+        DataType stored = storedType(key);
+        if (stored != EntryTable::TYPE_DELETED && stored != write.type) {
+            nvs_erase_key(handle, key);
+        }
+    }
+    
+    switch (write.type) {
+        case EntryTable::TYPE_STRING: {
+            // nvs_set_str() wants a terminated string
+            String value;
+            value.concat((const char*)write.data.data(), bytes);
+            err = nvs_set_str(handle, key, value.c_str());
+            bytes++;
+            break;
+        }
+        case EntryTable::TYPE_BYTES:
+            err = nvs_set_blob(handle, key, write.data.data(), bytes);
+            break;
+        case EntryTable::TYPE_INT:
+            err = nvs_set_i32(handle, key, (int32_t)write.number);
+            bytes = 4;
+            break;
+        case EntryTable::TYPE_UINT:
+            err = nvs_set_u32(handle, key, write.number);
+            bytes = 4;
+            break;
+        case EntryTable::TYPE_BOOL:
+            err = nvs_set_u8(handle, key, write.number ? 1 : 0);
+            bytes = 1;
+            break;
+        default:
+            err = nvs_erase_key(handle, key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+            break;
+    }
+    
+    if (err != ESP_OK) {
+        ION_LOG_E("NVS write of %s failed: %d", key, err);
+        return false;
+    }
+    counted.writes++;
+    counted.bytes += bytes;
     return true;
 }
 
 } // namespace IonConnect
 
 #endif // ION_PLATFORM_ESP32
-
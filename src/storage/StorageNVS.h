@@ -5,17 +5,34 @@
 
 #if ION_PLATFORM_ESP32
 
-#include <Preferences.h>
+#include "EntryTable.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <nvs.h>
+#include <vector>
 
 namespace IonConnect {
 
 /**
  * @brief NVS-based storage implementation for ESP32
  * 
- * Uses ESP32's Preferences library (NVS wrapper)
+ * Talks to NVS directly rather than through Preferences, which commits on
+ * every put. Writes are queued in RAM, in order and with repeated writes to
+ * a key coalesced, and reads see the queued values. commit() sets every
+ * queued item and then calls nvs_commit() once. Items use the same NVS types
+ * as Preferences (bool as u8), so existing data stays readable.
+ * 
+ * Safe to use from several tasks: commit() may run on the commit worker
+ * while the web server and the loop keep reading and queueing.
  */
 class StorageNVS : public StorageProvider {
 public:
+    struct Stats {
+        uint32_t writes;        // Items set or erased in NVS
+        uint32_t bytes;         // Value bytes of those items
+        uint32_t commits;       // nvs_commit() calls
+    };
+    
     StorageNVS();
     virtual ~StorageNVS();
     
@@ -36,17 +53,46 @@ public:
     bool getBool(const char* key, bool defaultValue = false) override;
     bool putBool(const char* key, bool value) override;
     
+    size_t getBytesLength(const char* key) override;
+    size_t getBytes(const char* key, void* buffer, size_t maxLen) override;
+    bool putBytes(const char* key, const void* value, size_t len) override;
+    
     bool remove(const char* key) override;
     bool commit() override;
     
+    static Stats getStats();     // Totals over all instances
+    
 private:
-    Preferences preferences;
+    // Record types are the table's value types; TYPE_DELETED erases the key
+    typedef EntryTable::DataType DataType;
+    
+    struct PendingWrite {
+        String key;
+        DataType type;
+        uint32_t number;                // TYPE_INT, TYPE_UINT, TYPE_BOOL
+        std::vector<uint8_t> data;      // TYPE_STRING, TYPE_BYTES
+    };
+    
+    nvs_handle_t handle;
     bool initialized;
     String currentNamespace;
+    SemaphoreHandle_t lock;             // Guards the fields below
+    SemaphoreHandle_t commitLock;       // Held for a whole commit()
+    std::vector<PendingWrite> pending;  // Oldest first
+    std::vector<PendingWrite> inflight; // Being written by commit()
+    bool clearQueued;                   // clear() before everything in `pending`
+    bool clearInflight;
+    
+    static Stats stats;
+    
+    DataType storedType(const char* key);      // TYPE_DELETED if absent
+    bool findQueued(const char* key, PendingWrite& write);
+    static const PendingWrite* findIn(const std::vector<PendingWrite>& writes, const char* key);
+    bool queue(const char* key, DataType type, uint32_t number, const void* data = nullptr, size_t len = 0);
+    bool writeItem(const PendingWrite& write, Stats& counted);
 };
 
 } // namespace IonConnect
 
 #endif // ION_PLATFORM_ESP32
 #endif // STORAGE_NVS_H
-
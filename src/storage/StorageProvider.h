@@ -8,7 +8,7 @@ namespace IonConnect {
 /**
  * @brief Abstract interface for persistent storage
  * 
- * Provides a unified interface for NVS (ESP32) and EEPROM (ESP8266)
+ * Provides a unified interface for NVS (ESP32), EEPROM (ESP8266) and LittleFS
  */
 class StorageProvider {
 public:
@@ -28,6 +28,9 @@ public:
     
     /**
      * @brief Clear all stored data
+     * 
+     * Like the puts, takes effect in RAM at once and on flash at the next
+     * commit().
      * @return true if successful
      */
     virtual bool clear() = 0;
@@ -103,6 +106,31 @@ public:
      */
     virtual bool putBool(const char* key, bool value) = 0;
     
+    /**
+     * @brief Get the size of a binary value
+     * @param key Storage key
+     * @return Size in bytes, or 0 if the key doesn't exist
+     */
+    virtual size_t getBytesLength(const char* key) = 0;
+    
+    /**
+     * @brief Get binary value
+     * @param key Storage key
+     * @param buffer Destination buffer
+     * @param maxLen Size of buffer
+     * @return Bytes read, or 0 if the key doesn't exist or doesn't fit
+     */
+    virtual size_t getBytes(const char* key, void* buffer, size_t maxLen) = 0;
+    
+    /**
+     * @brief Set binary value
+     * @param key Storage key
+     * @param value Data to store
+     * @param len Size of data in bytes
+     * @return true if successful
+     */
+    virtual bool putBytes(const char* key, const void* value, size_t len) = 0;
+    
     /**
      * @brief Remove a key
      * @param key Storage key
@@ -36,15 +36,9 @@ void Crypto::deriveKey() {
 }
 
 String Crypto::encrypt(const String& plaintext) {
-    if (!initialized) init();
-    
     size_t len = plaintext.length();
     uint8_t* output = new uint8_t[len];
-    
-    // Simple XOR cipher with key
-    for (size_t i = 0; i < len; i++) {
-        output[i] = plaintext[i] ^ key[i % 16];
-    }
+    encryptBytes(plaintext, output);
     
     String result = toHex(output, len);
     delete[] output;
@@ -53,19 +47,33 @@ String Crypto::encrypt(const String& plaintext) {
 }
 
 String Crypto::decrypt(const String& ciphertext) {
-    if (!initialized) init();
-    
     size_t len = ciphertext.length() / 2;
     uint8_t* data = new uint8_t[len];
     fromHex(ciphertext, data, len);
     
+    String result = decryptBytes(data, len);
+    delete[] data;
+    return result;
+}
+
+void Crypto::encryptBytes(const String& plaintext, uint8_t* output) {
+    if (!initialized) init();
+    
+    // Simple XOR cipher with key
+    for (size_t i = 0; i < plaintext.length(); i++) {
+        output[i] = plaintext[i] ^ key[i % 16];
+    }
+}
+
+String Crypto::decryptBytes(const uint8_t* data, size_t len) {
+    if (!initialized) init();
+    
     // XOR again to decrypt
-    String result = "";
+    String result;
+    result.reserve(len);
     for (size_t i = 0; i < len; i++) {
         result += (char)(data[i] ^ key[i % 16]);
     }
-    
-    delete[] data;
     return result;
 }
 
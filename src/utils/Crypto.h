@@ -15,8 +15,12 @@ namespace IonConnect {
 class Crypto {
 public:
     static void init();
-    static String encrypt(const String& plaintext);
+    static String encrypt(const String& plaintext);       // Hex ciphertext
     static String decrypt(const String& ciphertext);
+    
+    // Raw ciphertext, as long as the plaintext: for binary storage
+    static void encryptBytes(const String& plaintext, uint8_t* output);
+    static String decryptBytes(const uint8_t* data, size_t len);
     static String generateToken(size_t length = 32);
     
 private:
@@ -0,0 +1,49 @@
+#ifndef ION_HASH_H
+#define ION_HASH_H
+
+#include <Arduino.h>
+
+namespace IonConnect {
+
+/**
+ * @brief FNV-1a hashing for storage keys and fingerprints, CRC-16 for
+ *        storage record integrity
+ *
+ * Not cryptographic. String overloads read through pgm_read_byte, so they
+ * accept both RAM and PROGMEM strings.
+ */
+class Hash {
+public:
+    static const uint32_t FNV_OFFSET = 2166136261u;
+    static const uint32_t FNV_PRIME = 16777619u;
+
+    static uint32_t fnv1a(const char* str, uint32_t hash = FNV_OFFSET) {
+        uint8_t c;
+        while ((c = pgm_read_byte(str++)) != 0) {
+            hash = (hash ^ c) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static uint32_t fnv1a(const uint8_t* data, size_t len, uint32_t hash = FNV_OFFSET) {
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ data[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // CRC-16/CCITT-FALSE; chain calls by passing the previous result
+    static uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF) {
+        for (size_t i = 0; i < len; i++) {
+            crc ^= (uint16_t)data[i] << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+};
+
+} // namespace IonConnect
+
+#endif // ION_HASH_H
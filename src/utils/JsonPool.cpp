@@ -0,0 +1,146 @@
+#include "JsonPool.h"
+#include "Logger.h"
+
+#if ION_PLATFORM_ESP32
+    #include <freertos/FreeRTOS.h>
+#endif
+
+namespace IonConnect {
+
+// Leases come from the loop, the async web server task and BLE callbacks.
+// The ESP8266 runs them all cooperatively on one core, so only ESP32 locks.
+#if ION_PLATFORM_ESP32
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+    #define POOL_LOCK()   portENTER_CRITICAL(&poolMux)
+    #define POOL_UNLOCK() portEXIT_CRITICAL(&poolMux)
+#else
+    #define POOL_LOCK()
+    #define POOL_UNLOCK()
+#endif
+
+JsonPool::Slot JsonPool::slots[JsonPool::CLASS_COUNT][ION_JSON_POOL_SLOTS] = {};
+JsonPool::Fallback JsonPool::fallback = JsonPool::FALLBACK_HEAP;
+JsonPool::Stats JsonPool::stats = {};
+
+void* JsonPool::acquire(size_t size) {
+    Slot* slot = nullptr;
+    uint8_t sizeClass = 0;
+
+    POOL_LOCK();
+    if (size > stats.peakRequest) {
+        stats.peakRequest = size;
+    }
+    for (uint8_t c = 0; c < CLASS_COUNT && !slot; c++) {
+        if (size > classSize(c)) {
+            continue;
+        }
+        for (uint8_t i = 0; i < ION_JSON_POOL_SLOTS; i++) {
+            if (!slots[c][i].leased) {
+                slot = &slots[c][i];
+                slot->leased = true;
+                sizeClass = c;
+                break;
+            }
+        }
+    }
+    if (slot) {
+        stats.leases++;
+        if (++stats.leased > stats.peakLeased) {
+            stats.peakLeased = stats.leased;
+        }
+    }
+    POOL_UNLOCK();
+
+    if (slot) {
+        // Allocate outside the lock; the slot is already ours
+        if (!slot->buffer) {
+            slot->buffer = (uint8_t*)malloc(classSize(sizeClass));
+        }
+        if (slot->buffer) {
+            return slot->buffer;
+        }
+
+        POOL_LOCK();
+        slot->leased = false;
+        stats.leased--;
+        stats.leases--;
+        POOL_UNLOCK();
+    }
+
+    bool fail = fallback == FALLBACK_FAIL;
+    POOL_LOCK();
+    if (fail) {
+        stats.failures++;
+    } else {
+        stats.fallbacks++;
+    }
+    POOL_UNLOCK();
+
+    if (fail) {
+        ION_LOG_W("JSON pool exhausted (%d bytes requested)", size);
+        return nullptr;
+    }
+    return malloc(size);
+}
+
+void JsonPool::release(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    POOL_LOCK();
+    Slot* slot = find(ptr, nullptr);
+    if (slot) {
+        slot->leased = false;
+        stats.leased--;
+    }
+    POOL_UNLOCK();
+
+    if (!slot) {
+        free(ptr); // Heap fallback
+    }
+}
+
+void* JsonPool::resize(void* ptr, size_t size) {
+    // ArduinoJson only shrinks (shrinkToFit); pooled buffers stay as they are
+    uint8_t sizeClass = 0;
+    POOL_LOCK();
+    Slot* slot = find(ptr, &sizeClass);
+    POOL_UNLOCK();
+
+    if (slot) {
+        return size <= classSize(sizeClass) ? ptr : nullptr;
+    }
+    return realloc(ptr, size);
+}
+
+void JsonPool::setFallback(Fallback policy) {
+    fallback = policy;
+}
+
+JsonPool::Stats JsonPool::getStats() {
+    POOL_LOCK();
+    Stats copy = stats;
+    POOL_UNLOCK();
+    return copy;
+}
+
+size_t JsonPool::classSize(uint8_t sizeClass) {
+    return sizeClass == 0 ? ION_JSON_BUFFER_SIZE / 2 : ION_JSON_BUFFER_SIZE;
+}
+
+JsonPool::Slot* JsonPool::find(void* ptr, uint8_t* sizeClass) {
+    for (uint8_t c = 0; c < CLASS_COUNT; c++) {
+        for (uint8_t i = 0; i < ION_JSON_POOL_SLOTS; i++) {
+            if (slots[c][i].buffer == ptr && slots[c][i].leased) {
+                if (sizeClass) {
+                    *sizeClass = c;
+                }
+                return &slots[c][i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+} // namespace IonConnect
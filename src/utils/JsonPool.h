@@ -0,0 +1,80 @@
+#ifndef ION_JSON_POOL_H
+#define ION_JSON_POOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../core/IonTypes.h"
+
+namespace IonConnect {
+
+/**
+ * @brief Fixed set of reusable JSON document buffers
+ *
+ * Portal, BLE and network-list documents are short-lived and always one of
+ * two sizes, so instead of a fresh heap block per request they lease a
+ * buffer from here. Buffers are allocated on first use and then kept, so
+ * steady-state traffic does no heap allocation for JSON and cannot fragment
+ * the heap.
+ *
+ * Size classes are ION_JSON_BUFFER_SIZE / 2 and ION_JSON_BUFFER_SIZE, with
+ * ION_JSON_POOL_SLOTS buffers each. A request is served from the smallest
+ * free class that fits; when none is free (or it is larger than both), the
+ * fallback policy decides between a plain heap block and failing the lease
+ * (the document then has zero capacity, like a failed DynamicJsonDocument).
+ *
+ * Use PooledJsonDocument: it returns its buffer when it goes out of scope.
+ */
+class JsonPool {
+public:
+    enum Fallback : uint8_t {
+        FALLBACK_HEAP,      // Allocate from the heap (default)
+        FALLBACK_FAIL       // Return no memory
+    };
+
+    struct Stats {
+        uint8_t leased;         // Buffers currently out
+        uint8_t peakLeased;     // High-water mark of `leased`
+        size_t peakRequest;     // Largest capacity ever requested
+        uint32_t leases;        // Served from the pool
+        uint32_t fallbacks;     // Served from the heap
+        uint32_t failures;      // Not served at all
+    };
+
+    static void* acquire(size_t size);
+    static void release(void* ptr);
+    static void* resize(void* ptr, size_t size);
+
+    static void setFallback(Fallback policy);
+    static Stats getStats();
+
+private:
+    static const uint8_t CLASS_COUNT = 2;
+
+    struct Slot {
+        uint8_t* buffer;        // Allocated on first lease, then kept
+        bool leased;
+    };
+
+    static Slot slots[CLASS_COUNT][ION_JSON_POOL_SLOTS];
+    static Fallback fallback;
+    static Stats stats;
+
+    static size_t classSize(uint8_t sizeClass);
+    static Slot* find(void* ptr, uint8_t* sizeClass);
+};
+
+/**
+ * @brief ArduinoJson allocator backed by JsonPool
+ */
+struct JsonPoolAllocator {
+    void* allocate(size_t size) { return JsonPool::acquire(size); }
+    void deallocate(void* ptr) { JsonPool::release(ptr); }
+    void* reallocate(void* ptr, size_t size) { return JsonPool::resize(ptr, size); }
+};
+
+// Drop-in replacement for DynamicJsonDocument for transient documents
+typedef BasicJsonDocument<JsonPoolAllocator> PooledJsonDocument;
+
+} // namespace IonConnect
+
+#endif // ION_JSON_POOL_H
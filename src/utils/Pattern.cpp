@@ -0,0 +1,587 @@
+#include "Pattern.h"
+#include "Logger.h"
+
+namespace IonConnect {
+
+static const size_t CLASS_SIZE = 32;        // 256-bit bitmap
+static const size_t MAX_NODES = 128;
+static const uint8_t MAX_NESTING = 16;
+
+/**
+ * Parses a pattern into a node tree, then emits Pike VM instructions.
+ * Counted repetition is expanded by emitting the sub-expression again,
+ * which keeps the VM free of counters.
+ */
+class PatternCompiler {
+public:
+    PatternCompiler(Pattern& out, const char* source)
+        : out(out), src(source), pos(0), nesting(0), error(nullptr) {}
+
+    bool run() {
+        int root = parseAlternation();
+        if (!error && src[pos] != '\0') {
+            error = "unbalanced )";
+        }
+        if (!error) {
+            emit(root);
+            emitInst(Pattern::OP_MATCH);
+        }
+        return !error;
+    }
+
+    const char* errorMessage() const { return error; }
+
+private:
+    enum NodeType : uint8_t {
+        NODE_EMPTY, NODE_CHAR, NODE_ANY, NODE_CLASS, NODE_BOL, NODE_EOL,
+        NODE_CAT, NODE_ALT, NODE_REPEAT
+    };
+
+    struct Node {
+        uint8_t type;
+        uint8_t arg;
+        int16_t left;
+        int16_t right;
+        int16_t min;
+        int16_t max;            // -1 = unbounded
+    };
+
+    Pattern& out;
+    const char* src;
+    size_t pos;
+    uint8_t nesting;
+    const char* error;
+    std::vector<Node> nodes;
+
+    int node(uint8_t type, uint8_t arg = 0, int left = -1, int right = -1) {
+        if (nodes.size() >= MAX_NODES) {
+            error = "pattern too long";
+            return -1;
+        }
+        Node n = { type, arg, (int16_t)left, (int16_t)right, 0, 0 };
+        nodes.push_back(n);
+        return nodes.size() - 1;
+    }
+
+    // ---- Parser ----
+
+    int parseAlternation() {
+        int left = parseConcat();
+        while (!error && src[pos] == '|') {
+            pos++;
+            int right = parseConcat();
+            left = node(NODE_ALT, 0, left, right);
+        }
+        return left;
+    }
+
+    int parseConcat() {
+        int left = -1;
+        while (!error && src[pos] && src[pos] != '|' && src[pos] != ')') {
+            int atom = parseRepeat();
+            left = (left < 0) ? atom : node(NODE_CAT, 0, left, atom);
+        }
+        return (left < 0) ? node(NODE_EMPTY) : left;
+    }
+
+    int parseRepeat() {
+        int atom = parseAtom();
+
+        while (!error) {
+            int min, max;
+            char c = src[pos];
+            if (c == '*') {
+                min = 0; max = -1; pos++;
+            } else if (c == '+') {
+                min = 1; max = -1; pos++;
+            } else if (c == '?') {
+                min = 0; max = 1; pos++;
+            } else if (c == '{') {
+                pos++;
+                if (!parseCount(min, max)) {
+                    return -1;
+                }
+            } else {
+                break;
+            }
+
+            if (src[pos] == '?') {
+                pos++; // Lazy quantifier: same result for a yes/no match
+            }
+
+            atom = node(NODE_REPEAT, 0, atom);
+            if (atom >= 0) {
+                nodes[atom].min = min;
+                nodes[atom].max = max;
+            }
+        }
+
+        return atom;
+    }
+
+    bool parseCount(int& min, int& max) {
+        if (!parseNumber(min)) {
+            error = "bad {n,m}";
+            return false;
+        }
+        max = min;
+        if (src[pos] == ',') {
+            pos++;
+            max = -1;
+            if (src[pos] != '}' && !parseNumber(max)) {
+                error = "bad {n,m}";
+                return false;
+            }
+        }
+        if (src[pos] != '}' || (max >= 0 && max < min) || min > 64 || max > 64) {
+            error = "bad {n,m}";
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    bool parseNumber(int& value) {
+        if (src[pos] < '0' || src[pos] > '9') {
+            return false;
+        }
+        value = 0;
+        while (src[pos] >= '0' && src[pos] <= '9' && value < 1000) {
+            value = value * 10 + (src[pos++] - '0');
+        }
+        return true;
+    }
+
+    int parseAtom() {
+        char c = src[pos++];
+
+        switch (c) {
+            case '(': {
+                if (++nesting > MAX_NESTING) {
+                    error = "groups nested too deep";
+                    return -1;
+                }
+                if (src[pos] == '?') {
+                    if (src[pos + 1] != ':') {
+                        error = "lookaround is not supported";
+                        return -1;
+                    }
+                    pos += 2;
+                }
+                int inner = parseAlternation();
+                if (!error && src[pos] != ')') {
+                    error = "missing )";
+                    return -1;
+                }
+                pos++;
+                nesting--;
+                return inner;
+            }
+            case '[':
+                return parseClass();
+            case '.':
+                return node(NODE_ANY);
+            case '^':
+                return node(NODE_BOL);
+            case '$':
+                return node(NODE_EOL);
+            case '\\':
+                return parseEscape();
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                error = "nothing to repeat";
+                return -1;
+            default:
+                return node(NODE_CHAR, (uint8_t)c);
+        }
+    }
+
+    int parseEscape() {
+        char c = src[pos++];
+        uint8_t bits[CLASS_SIZE];
+
+        if (shorthandClass(c, bits)) {
+            return node(NODE_CLASS, addClass(bits));
+        }
+
+        switch (c) {
+            case 'n': return node(NODE_CHAR, '\n');
+            case 'r': return node(NODE_CHAR, '\r');
+            case 't': return node(NODE_CHAR, '\t');
+            case '\0':
+                error = "trailing \\";
+                return -1;
+            default:
+                if (isalnum((unsigned char)c)) {
+                    error = "unsupported escape";
+                    return -1;
+                }
+                return node(NODE_CHAR, (uint8_t)c);
+        }
+    }
+
+    int parseClass() {
+        uint8_t bits[CLASS_SIZE];
+        memset(bits, 0, sizeof(bits));
+
+        bool negate = (src[pos] == '^');
+        if (negate) {
+            pos++;
+        }
+
+        bool first = true;
+        while (src[pos] && (src[pos] != ']' || first)) {
+            first = false;
+            int lo = classChar(bits);
+            if (lo < 0) {
+                if (error) {
+                    return -1;
+                }
+                continue; // Shorthand merged into bits
+            }
+
+            int hi = lo;
+            if (src[pos] == '-' && src[pos + 1] && src[pos + 1] != ']') {
+                pos++;
+                hi = classChar(bits);
+                if (hi < 0 || hi < lo) {
+                    if (!error) {
+                        error = "bad class range";
+                    }
+                    return -1;
+                }
+            }
+            for (int ch = lo; ch <= hi; ch++) {
+                bits[ch >> 3] |= (1 << (ch & 7));
+            }
+        }
+
+        if (src[pos] != ']') {
+            error = "missing ]";
+            return -1;
+        }
+        pos++;
+
+        if (negate) {
+            for (size_t i = 0; i < CLASS_SIZE; i++) {
+                bits[i] = ~bits[i];
+            }
+        }
+        return node(NODE_CLASS, addClass(bits));
+    }
+
+    // One class member: returns the byte, or -1 after merging a shorthand
+    int classChar(uint8_t* bits) {
+        char c = src[pos++];
+        if (c != '\\') {
+            return (uint8_t)c;
+        }
+
+        c = src[pos++];
+        uint8_t shorthand[CLASS_SIZE];
+        if (shorthandClass(c, shorthand)) {
+            for (size_t i = 0; i < CLASS_SIZE; i++) {
+                bits[i] |= shorthand[i];
+            }
+            return -1;
+        }
+
+        switch (c) {
+            case 'n': return '\n';
+            case 'r': return '\r';
+            case 't': return '\t';
+            case '\0':
+                error = "trailing \\";
+                return -1;
+            default:
+                if (isalnum((unsigned char)c)) {
+                    error = "unsupported escape";
+                    return -1;
+                }
+                return (uint8_t)c;
+        }
+    }
+
+    static bool shorthandClass(char c, uint8_t* bits) {
+        char lower = c | 0x20;
+        if (lower != 'd' && lower != 'w' && lower != 's') {
+            return false;
+        }
+
+        memset(bits, 0, CLASS_SIZE);
+        for (int ch = 0; ch < 128; ch++) {
+            bool in = (lower == 'd') ? (ch >= '0' && ch <= '9')
+                    : (lower == 'w') ? (isalnum(ch) || ch == '_')
+                    : (ch == ' ' || (ch >= '\t' && ch <= '\r'));
+            if (in) {
+                bits[ch >> 3] |= (1 << (ch & 7));
+            }
+        }
+
+        if (c != lower) {
+            // \D \W \S
+            for (size_t i = 0; i < CLASS_SIZE; i++) {
+                bits[i] = ~bits[i];
+            }
+        }
+        return true;
+    }
+
+    uint8_t addClass(const uint8_t* bits) {
+        // Reuse an identical bitmap (e.g. \d repeated in an IP pattern)
+        size_t count = out.classes.size() / CLASS_SIZE;
+        for (size_t i = 0; i < count; i++) {
+            if (memcmp(&out.classes[i * CLASS_SIZE], bits, CLASS_SIZE) == 0) {
+                return i;
+            }
+        }
+        if (count >= 255) {
+            error = "too many classes";
+            return 0;
+        }
+        out.classes.insert(out.classes.end(), bits, bits + CLASS_SIZE);
+        return count;
+    }
+
+    // ---- Code generation ----
+
+    size_t emitInst(uint8_t op, uint8_t arg = 0) {
+        if (out.program.size() >= Pattern::MAX_PROGRAM) {
+            error = "pattern too complex";
+            return 0;
+        }
+        Pattern::Inst inst = { op, arg, 0, 0 };
+        out.program.push_back(inst);
+        return out.program.size() - 1;
+    }
+
+    void emit(int n) {
+        if (error || n < 0) {
+            return;
+        }
+
+        const Node nd = nodes[n];
+        switch (nd.type) {
+            case NODE_EMPTY:
+                break;
+            case NODE_CHAR:
+                emitInst(Pattern::OP_CHAR, nd.arg);
+                break;
+            case NODE_ANY:
+                emitInst(Pattern::OP_ANY);
+                break;
+            case NODE_CLASS:
+                emitInst(Pattern::OP_CLASS, nd.arg);
+                break;
+            case NODE_BOL:
+                emitInst(Pattern::OP_BOL);
+                break;
+            case NODE_EOL:
+                emitInst(Pattern::OP_EOL);
+                break;
+            case NODE_CAT:
+                emit(nd.left);
+                emit(nd.right);
+                break;
+            case NODE_ALT: {
+                size_t split = emitInst(Pattern::OP_SPLIT);
+                emit(nd.left);
+                size_t jmp = emitInst(Pattern::OP_JMP);
+                size_t second = out.program.size();
+                emit(nd.right);
+                patch(split, split + 1, second);
+                patch(jmp, out.program.size(), 0);
+                break;
+            }
+            case NODE_REPEAT:
+                emitRepeat(nd);
+                break;
+        }
+    }
+
+    void emitRepeat(const Node& nd) {
+        for (int i = 0; i < nd.min; i++) {
+            emit(nd.left);
+        }
+
+        if (nd.max < 0) {
+            // x*: L1: split L2, L3; L2: x; jmp L1; L3:
+            size_t split = emitInst(Pattern::OP_SPLIT);
+            emit(nd.left);
+            size_t jmp = emitInst(Pattern::OP_JMP);
+            patch(jmp, split, 0);
+            patch(split, split + 1, out.program.size());
+            return;
+        }
+
+        // x{0,k} as nested optionals: split L1, end; L1: x; split L2, end; ...
+        std::vector<size_t> splits;
+        for (int i = nd.min; i < nd.max && !error; i++) {
+            splits.push_back(emitInst(Pattern::OP_SPLIT));
+            emit(nd.left);
+        }
+        for (size_t split : splits) {
+            patch(split, split + 1, out.program.size());
+        }
+    }
+
+    void patch(size_t pc, size_t x, size_t y) {
+        if (error) {
+            return;
+        }
+        if (x >= Pattern::MAX_PROGRAM || y >= Pattern::MAX_PROGRAM) {
+            error = "pattern too complex";
+            return;
+        }
+        out.program[pc].x = x;
+        out.program[pc].y = y;
+    }
+};
+
+bool Pattern::compile(const char* pattern) {
+    clear();
+
+    // Parse from RAM: the compiler peeks ahead, which PROGMEM can't do cheaply
+    String source = FPSTR(pattern);
+    if (source.isEmpty()) {
+        return true;
+    }
+
+    PatternCompiler compiler(*this, source.c_str());
+    if (!compiler.run()) {
+        ION_LOG_W("Pattern not supported (%s): %s", compiler.errorMessage(), source.c_str());
+        clear();
+        return false;
+    }
+
+    program.shrink_to_fit();
+    classes.shrink_to_fit();
+    return true;
+}
+
+void Pattern::clear() {
+    program.clear();
+    classes.clear();
+}
+
+size_t Pattern::memoryUsage() const {
+    return program.capacity() * sizeof(Inst) + classes.capacity();
+}
+
+void Pattern::addThread(uint8_t* list, uint8_t pc, bool atStart, bool atEnd) const {
+    // Explicit stack: each pc is pushed at most once per step
+    uint8_t stack[MAX_PROGRAM];
+    size_t depth = 0;
+
+    list[pc >> 3] |= (1 << (pc & 7));
+    stack[depth++] = pc;
+
+    while (depth > 0) {
+        uint8_t current = stack[--depth];
+        const Inst& inst = program[current];
+        uint8_t next[2];
+        uint8_t count = 0;
+
+        switch (inst.op) {
+            case OP_JMP:
+                next[count++] = inst.x;
+                break;
+            case OP_SPLIT:
+                next[count++] = inst.x;
+                next[count++] = inst.y;
+                break;
+            case OP_BOL:
+                if (atStart) {
+                    next[count++] = current + 1;
+                }
+                break;
+            case OP_EOL:
+                if (atEnd) {
+                    next[count++] = current + 1;
+                }
+                break;
+            default:
+                break; // Consuming or MATCH: stays in the list
+        }
+
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t target = next[i];
+            if (!(list[target >> 3] & (1 << (target & 7)))) {
+                list[target >> 3] |= (1 << (target & 7));
+                stack[depth++] = target;
+            }
+        }
+    }
+}
+
+bool Pattern::matches(const char* text) const {
+    if (program.empty()) {
+        return true;
+    }
+
+    const size_t listSize = (MAX_PROGRAM + 7) / 8;
+    uint8_t lists[2][listSize];
+    uint8_t* current = lists[0];
+    uint8_t* next = lists[1];
+    const size_t count = program.size();
+
+    memset(current, 0, listSize);
+    addThread(current, 0, true, *text == '\0');
+
+    for (const char* p = text; ; p++) {
+        uint8_t c = (uint8_t)*p;
+        bool anyThread = false;
+
+        if (c == '\0') {
+            for (size_t pc = 0; pc < count; pc++) {
+                if ((current[pc >> 3] & (1 << (pc & 7))) && program[pc].op == OP_MATCH) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        memset(next, 0, listSize);
+        bool atEnd = (p[1] == '\0');
+
+        for (size_t pc = 0; pc < count; pc++) {
+            if (!(current[pc >> 3] & (1 << (pc & 7)))) {
+                continue;
+            }
+
+            const Inst& inst = program[pc];
+            bool step;
+            switch (inst.op) {
+                case OP_CHAR:
+                    step = (c == inst.arg);
+                    break;
+                case OP_ANY:
+                    step = (c != '\n');
+                    break;
+                case OP_CLASS:
+                    step = classes[inst.arg * CLASS_SIZE + (c >> 3)] & (1 << (c & 7));
+                    break;
+                default:
+                    step = false;
+                    break;
+            }
+
+            if (step) {
+                addThread(next, pc + 1, false, atEnd);
+                anyThread = true;
+            }
+        }
+
+        if (!anyThread) {
+            return false;
+        }
+
+        uint8_t* swap = current;
+        current = next;
+        next = swap;
+    }
+}
+
+} // namespace IonConnect
@@ -0,0 +1,66 @@
+#ifndef ION_PATTERN_H
+#define ION_PATTERN_H
+
+#include <Arduino.h>
+#include <vector>
+
+namespace IonConnect {
+
+/**
+ * @brief Non-backtracking matcher for schema `pattern` fields
+ *
+ * Supports the regex subset that field patterns use in practice: literals,
+ * `.`, classes (`[a-z]`, `[^...]`, `\d \w \s` and their negations),
+ * groups `(...)`/`(?:...)`, alternation `|`, repetition `* + ? {n} {n,}
+ * {n,m}` and anchors `^ $`. Backreferences and lookaround are rejected.
+ *
+ * Like the HTML `pattern` attribute, the whole value must match. Patterns
+ * are compiled once into a small NFA program and run as a Pike VM: time is
+ * linear in the input and stack use is fixed, whatever the pattern or
+ * input: two 32-byte thread lists in matches() and a MAX_PROGRAM (255)
+ * byte work stack in addThread(), about 320 bytes of arrays or ~550 bytes
+ * with both call frames (32-bit -Os build, gcc -fstack-usage).
+ */
+class Pattern {
+public:
+    static const size_t MAX_PROGRAM = 255;
+
+    Pattern() {}
+
+    bool compile(const char* pattern);      // Pattern may be in PROGMEM
+    bool isCompiled() const { return !program.empty(); }
+    bool matches(const char* text) const;   // True if not compiled
+    void clear();
+
+    size_t memoryUsage() const;             // Heap bytes held by the program
+
+private:
+    enum Op : uint8_t {
+        OP_CHAR,        // arg = byte
+        OP_ANY,
+        OP_CLASS,       // arg = class index
+        OP_SPLIT,       // x, y = next pcs
+        OP_JMP,         // x = next pc
+        OP_BOL,
+        OP_EOL,
+        OP_MATCH
+    };
+
+    struct Inst {
+        uint8_t op;
+        uint8_t arg;
+        uint8_t x;
+        uint8_t y;
+    };
+
+    std::vector<Inst> program;
+    std::vector<uint8_t> classes;           // 32-byte bitmaps, one per class
+
+    friend class PatternCompiler;
+
+    void addThread(uint8_t* list, uint8_t pc, bool atStart, bool atEnd) const;
+};
+
+} // namespace IonConnect
+
+#endif // ION_PATTERN_H
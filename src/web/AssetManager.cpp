@@ -12,7 +12,7 @@
 
 namespace IonConnect {
 
-AssetManager::AssetManager() : littleFSAvailable(false) {
+AssetManager::AssetManager() : littleFSAvailable(false), keepMounted(false) {
 }
 
 bool AssetManager::begin() {
@@ -33,10 +33,10 @@ bool AssetManager::begin() {
 
 void AssetManager::end() {
     #if ION_USE_LITTLEFS
-    if (littleFSAvailable) {
+    if (littleFSAvailable && !keepMounted) {
         LittleFS.end();
-        littleFSAvailable = false;
     }
+    littleFSAvailable = false;
     #endif
 }
 
@@ -17,6 +17,7 @@ public:
     
     bool begin();
     void end();
+    void setKeepMounted(bool keep) { keepMounted = keep; }     // LittleFS is shared with storage
     
     // Asset loading
     String loadHTML();
@@ -26,6 +27,7 @@ public:
     
 private:
     bool littleFSAvailable;
+    bool keepMounted;
     
     String loadFromLittleFS(const char* path);
     String loadFromPROGMEM(const char* assetType);
@@ -63,6 +63,7 @@ const r=await fetch('/api/schema');
 schema=await r.json();
 buildForm();
 loadConfig();
+loadNetworks();
 }catch(e){showStatus('Failed to load',true);}
 }
 function buildForm(){
@@ -99,6 +100,13 @@ else inp.value=cfg[k];
 });
 }catch(e){}
 }
+async function loadNetworks(){
+try{
+const r=await fetch('/api/networks');
+const data=await r.json();
+if(data.networks&&data.networks.length)displayNetworks(data.networks);
+}catch(e){}
+}
 async function scanNetworks(){
 const btn=document.getElementById('scanBtn');
 btn.disabled=true;
@@ -7,6 +7,7 @@ document.addEventListener('DOMContentLoaded', () => {
     setupEventListeners();
     connectSSE();
     loadDiagnostics();
+    loadNetworks();
 });
 
 // Setup event listeners
@@ -144,6 +145,23 @@ function setupConditionalVisibility(fields) {
     });
 }
 
+// Show the device's cached scan results; fetch again once a stale list
+// has been refreshed
+async function loadNetworks(retry = true) {
+    try {
+        const response = await fetch('/api/networks');
+        const data = await response.json();
+        const networks = data.networks || [];
+        
+        if (networks.length > 0) displayNetworks(networks);
+        if (retry && (networks.length === 0 || data.age < 0 || data.age > 30)) {
+            setTimeout(() => loadNetworks(false), 3000);
+        }
+    } catch (error) {
+        console.error('Failed to load networks:', error);
+    }
+}
+
 // Scan for WiFi networks
 async function scanNetworks() {
     const btn = document.getElementById('scan-btn');
@@ -346,6 +364,14 @@ function connectSSE() {
         updateStatus(data.state, data.ssid, data.ip, data.message);
     });
     
+    // Saves are written to flash after the request returns
+    eventSource.addEventListener('saved', (e) => {
+        const data = JSON.parse(e.data);
+        if (!data.success) {
+            showToast('Failed to write configuration to flash', 'error');
+        }
+    });
+    
     eventSource.onerror = (e) => {
         console.error('SSE error:', e);
         // Will auto-reconnect
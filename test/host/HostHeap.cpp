@@ -0,0 +1,103 @@
+// Heap accounting for the benchmarks (see mock/HostHeap.h): operator new
+// and delete, and malloc/free/realloc/calloc through -Wl,--wrap, record
+// every block that is not allocated under a HostHeap::Pause. Each block
+// carries a small header with its size and whether it was counted.
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "HostHeap.h"
+
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+namespace {
+
+struct Header {
+    size_t size;
+    size_t counted;
+    size_t pad[2];      // Keeps the payload 32-byte aligned, like malloc
+};
+
+void* allocate(size_t size) {
+    Header* h = (Header*)__real_malloc(sizeof(Header) + size);
+    if (!h) return nullptr;
+    h->size = size;
+    h->counted = HostHeap::paused == 0;
+    if (h->counted) {
+        HostHeap::allocations++;
+        HostHeap::liveBlocks++;
+        HostHeap::liveBytes += size;
+        if (HostHeap::liveBytes > HostHeap::peakBytes) HostHeap::peakBytes = HostHeap::liveBytes;
+    }
+    return h + 1;
+}
+
+void release(void* ptr) {
+    if (!ptr) return;
+    Header* h = (Header*)ptr - 1;
+    if (h->counted) {
+        HostHeap::liveBlocks--;
+        HostHeap::liveBytes -= h->size;
+    }
+    __real_free(h);
+}
+
+} // namespace
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+    return allocate(size);
+}
+
+void __wrap_free(void* ptr) {
+    release(ptr);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    void* ptr = allocate(n * size);
+    if (ptr) memset(ptr, 0, n * size);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (!ptr) return allocate(size);
+    Header* h = (Header*)ptr - 1;
+    void* copy = allocate(size);
+    if (copy) {
+        memcpy(copy, ptr, h->size < size ? h->size : size);
+        release(ptr);
+    }
+    return copy;
+}
+
+}
+
+void* operator new(size_t size) {
+    void* ptr = allocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    release(ptr);
+}
@@ -0,0 +1,44 @@
+// Minimal test helpers for the host tests: CHECK records a failure and
+// carries on, finish() prints the summary and gives main() its exit code.
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+static int hostChecks = 0;
+static int hostFailures = 0;
+
+#define CHECK(cond) do { \
+    hostChecks++; \
+    if (!(cond)) { \
+        hostFailures++; \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    hostChecks++; \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if (_a != _b) { \
+        hostFailures++; \
+        printf("  FAIL %s:%d: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+    } \
+} while (0)
+
+static inline int finish(const char* name) {
+    printf("%s: %d checks, %d failed\n", name, hostChecks, hostFailures);
+    return hostFailures ? 1 : 0;
+}
+
+// Wall-clock nanoseconds per call of `body`, best of `rounds`
+template<class F>
+double nsPerCall(long calls, F body, int rounds = 5) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < calls; i++) body(i);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() / calls < best) best = elapsed.count() / calls;
+    }
+    return best;
+}
@@ -0,0 +1,74 @@
+// Shared setup for the WiFiConnectionCore tests: the platform's storage,
+// emptied, behind a ConfigManager with the default schema, and a loop
+// driver that runs handle() every 10 simulated ms with the radio stepped
+// in between, like loop() on the device. The driver records the worst wall
+// time of a handle() call and any simulated time spent inside one
+// (delay()).
+#pragma once
+
+#include <chrono>
+#include "HostTest.h"
+#include "core/IonTypes.h"
+#include "modules/ConfigManager.h"
+#include "modules/WiFiConnectionCore.h"
+#include "schemas/default_schema.h"
+
+#if defined(ESP32)
+#include "nvs.h"
+#include "storage/StorageNVS.h"
+typedef IonConnect::StorageNVS HostStorage;
+#else
+#include "HostFlash.h"
+#include "storage/StorageEEPROM.h"
+typedef IonConnect::StorageEEPROM HostStorage;
+#endif
+
+struct WiFiHarness {
+    HostStorage storage;
+    IonConnect::ConfigManager config;
+    double worstMicros = 0;         // Longest handle() call, wall time
+    unsigned long worstBlocked = 0; // Longest handle() call, simulated ms
+    
+    WiFiHarness() : config(&storage) {
+        #if defined(ESP32)
+        hostNvsReset();
+        #else
+        hostFlash.reset();
+        #endif
+        hostClock = 1000;
+        sim = SimRadio();
+        CHECK(storage.begin("wifi"));
+        CHECK(config.loadSchema(IonConnect::DEFAULT_SCHEMA_FIELDS, IonConnect::DEFAULT_SCHEMA_FIELD_COUNT,
+                                IonConnect::DEFAULT_SCHEMA));
+        CHECK(config.load());
+    }
+    
+    // One pass of loop(): 10 ms later, radio first, then the state machine
+    void tick(IonConnect::WiFiConnectionCore& wifi) {
+        hostClock += 10;
+        sim.step();
+        unsigned long before = hostClock;
+        auto start = std::chrono::steady_clock::now();
+        wifi.handle();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() > worstMicros) worstMicros = elapsed.count();
+        if (hostClock - before > worstBlocked) worstBlocked = hostClock - before;
+    }
+    
+    void run(IonConnect::WiFiConnectionCore& wifi, unsigned long ms) {
+        for (unsigned long i = 0; i < ms / 10; i++) tick(wifi);
+    }
+    
+    // Runs until `done` or `limit` ms; returns the simulated ms it took
+    template<class F>
+    unsigned long runUntil(IonConnect::WiFiConnectionCore& wifi, F done, unsigned long limit = 60000) {
+        unsigned long start = hostClock;
+        while (!done() && hostClock - start < limit) tick(wifi);
+        return hostClock - start;
+    }
+    
+    void resetMeters() {
+        worstMicros = 0;
+        worstBlocked = 0;
+    }
+};
@@ -0,0 +1,120 @@
+// Stored size and load time of the non-schema config keys, binary
+// snapshot (ION_BINARY_CONFIG) against JSON text, by key count. A quarter
+// of the keys are secrets, stored as "enc:<hex>" in JSON and as raw
+// ciphertext in the snapshot.
+//
+// Decode times are host times. The JSON column parses with the host
+// ArduinoJson stand-in, not ArduinoJson itself, so it only shows the
+// trend; the snapshot column and the full load() use the library's code.
+#include "HostFlash.h"
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "modules/ConfigSnapshot.h"
+#include "storage/StorageEEPROM.h"
+#include "utils/Crypto.h"
+
+using namespace IonConnect;
+
+static const ConfigField TABLE[] = {
+    {"wifi_ssid", "", "text", "", "", "", "", nullptr, 0, 0, 32, 0, 0, false, false, FIELD_TEXT},
+};
+
+static String keyName(int i) {
+    char key[24];
+    snprintf(key, sizeof(key), i % 4 == 3 ? "svc%02d_token" : "app_key_%02d", i);
+    return key;
+}
+
+static String keyValue(int i) {
+    char value[32];
+    snprintf(value, sizeof(value), i % 4 == 3 ? "tok-%02d-a1b2c3d4e5" : "value-%02d/home/sensor", i);
+    return value;
+}
+
+int main() {
+    volatile size_t sink = 0;
+    
+    printf("Non-schema config keys, stored size and load time (host):\n");
+    printf("  %4s %9s %9s %6s %12s %12s %12s\n", "keys", "JSON B", "binary B", "ratio",
+           "JSON parse", "snap decode", "boot");
+    
+    for (int keys : {4, 8, 16, 32}) {
+        DynamicJsonDocument doc(ION_JSON_CONFIG_SIZE);
+        JsonObject root = doc.to<JsonObject>();
+        for (int i = 0; i < keys; i++) {
+            String value = keyValue(i);
+            root[keyName(i)] = i % 4 == 3 ? "enc:" + Crypto::encrypt(value) : value;
+        }
+        CHECK(!doc.overflowed());
+        
+        String json;
+        serializeJson(doc, json);
+        std::vector<uint8_t> snapshot;
+        ConfigSnapshot::encode(doc.as<JsonObjectConst>(), snapshot);
+        
+        DynamicJsonDocument out(ION_JSON_CONFIG_SIZE);
+        std::vector<uint8_t> scratch = snapshot;
+        CHECK(ConfigSnapshot::decode(scratch.data(), scratch.size(), out));
+        String roundTrip;
+        serializeJson(out, roundTrip);
+        CHECK(roundTrip == json);
+        
+        double parse = nsPerCall(2000, [&](long) { sink += !deserializeJson(out, json); });
+        double decode = nsPerCall(2000, [&](long) {
+            scratch = snapshot;     // decode() terminates strings in place
+            sink += ConfigSnapshot::decode(scratch.data(), scratch.size(), out);
+        });
+        
+        // Full boot from flash: StorageEEPROM::begin(), load() and the
+        // first read of a non-schema key (the snapshot is decoded lazily)
+        hostFlash.reset();
+        {
+            StorageEEPROM storage;
+            CHECK(storage.begin("bench"));
+            ConfigManager config(&storage);
+            CHECK(config.loadSchema(TABLE, 1, "{}"));
+            CHECK(config.load());
+            for (int i = 0; i < keys; i++) {
+                CHECK(config.set(keyName(i), keyValue(i)));
+            }
+            CHECK(config.flush());
+        }
+        double load = nsPerCall(200, [&](long) {
+            StorageEEPROM storage;
+            storage.begin("bench");
+            ConfigManager config(&storage);
+            config.loadSchema(TABLE, 1, "{}");
+            config.load();
+            sink += config.get(keyName(keys - 1)).length();
+        });
+        {
+            StorageEEPROM storage;
+            CHECK(storage.begin("bench"));
+            ConfigManager config(&storage);
+            config.loadSchema(TABLE, 1, "{}");
+            CHECK(config.load());
+            CHECK(config.get(keyName(keys - 1)) == keyValue(keys - 1));
+        }
+        
+        printf("  %4d %9zu %9zu %5.0f%% %9.1f us %9.1f us %9.1f us\n", keys, (size_t)json.length(), snapshot.size(),
+               100.0 * snapshot.size() / json.length(), parse / 1000, decode / 1000, load / 1000);
+    }
+    
+    // Size only: every value a secret, the case the snapshot halves
+    printf("\n  all keys secret:\n");
+    for (int keys : {4, 16}) {
+        DynamicJsonDocument doc(ION_JSON_CONFIG_SIZE);
+        JsonObject root = doc.to<JsonObject>();
+        for (int i = 0; i < keys; i++) {
+            root[keyName(i * 4 + 3)] = "enc:" + Crypto::encrypt(keyValue(i * 4 + 3));
+        }
+        String json;
+        serializeJson(doc, json);
+        std::vector<uint8_t> snapshot;
+        ConfigSnapshot::encode(doc.as<JsonObjectConst>(), snapshot);
+        printf("  %4d %9zu %9zu %5.0f%%\n", keys, (size_t)json.length(), snapshot.size(),
+               100.0 * snapshot.size() / json.length());
+    }
+    
+    return finish("bench_config_snapshot");
+}
@@ -0,0 +1,113 @@
+// StorageEEPROM boot: begin() on a full 4 KB log (a compacted base plus
+// appended commits until the sector is full), and on the same keys just
+// after compaction. Reports time and allocations per boot, what the loaded
+// cache keeps on the heap, and getString() afterwards.
+//
+// Sizes are host (64-bit) sizes as requested from new/malloc. The host
+// String is std::string-backed; per-call times are host times.
+#include "HostFlash.h"
+#include "HostHeap.h"
+#include "HostTest.h"
+#include "core/IonTypes.h"
+#include "storage/StorageEEPROM.h"
+
+using namespace IonConnect;
+
+static const int KEYS = 24;
+
+static String keyName(int i) {
+    char key[16];
+    snprintf(key, sizeof(key), "f%08x", (unsigned)(i * 2654435761u));
+    return key;
+}
+
+// Bytes in use in the slot with the newest generation
+static size_t activeBytes() {
+    const std::vector<uint8_t>* newest = nullptr;
+    uint32_t generation = 0;
+    for (auto& sector : hostFlash.sectors) {
+        const uint8_t* p = sector.second.data();
+        uint32_t g = p[6] | (p[7] << 8) | (p[8] << 16) | ((uint32_t)p[9] << 24);
+        if (p[0] != 0xFF && (!newest || g > generation)) {
+            newest = &sector.second;
+            generation = g;
+        }
+    }
+    size_t used = newest ? newest->size() : 0;
+    while (used && (*newest)[used - 1] == 0xFF) used--;
+    return used;
+}
+
+static void measure(const char* name) {
+    volatile size_t sink = 0;
+    
+    HostHeap::reset();
+    double boot = nsPerCall(2000, [&](long) {
+        StorageEEPROM s;
+        sink += s.begin("ion");
+    });
+    double bootAllocations = (double)HostHeap::allocations / (2000 * 5);
+    
+    size_t blocks = HostHeap::liveBlocks;
+    size_t bytes = HostHeap::liveBytes;
+    StorageEEPROM s;
+    CHECK(s.begin("ion"));
+    size_t keptBlocks = HostHeap::liveBlocks - blocks;
+    size_t keptBytes = HostHeap::liveBytes - bytes;
+    CHECK(s.getString("networks").startsWith("[{"));
+    
+    String keys[KEYS];
+    {
+        HostHeap::Pause pause;
+        for (int i = 0; i < KEYS; i++) keys[i] = keyName(i);
+    }
+    HostHeap::reset();
+    double get = nsPerCall(20000, [&](long i) { sink += s.getString(keys[i % KEYS].c_str()).length(); });
+    double getAllocations = (double)HostHeap::allocations / (20000 * 5);
+    
+    printf("  %-10s %6zu %9.1f us %7.1f %7zu %7zu %9.1f ns %6.2f\n", name, activeBytes(), boot / 1000,
+           bootAllocations, keptBlocks, keptBytes, get, getAllocations);
+}
+
+int main() {
+    hostFlash.reset();
+    {
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        char value[64];
+        for (int i = 0; i < KEYS; i++) {
+            snprintf(value, sizeof(value), "value-%d-%s", i, "abcdefghijklmnopqrstuvwxyz0123");
+            s.putString(keyName(i).c_str(), value);
+        }
+        s.putString("networks", "[{\"ssid\":\"home\",\"password\":\"enc:00112233445566778899aabbccddeeff\"}]");
+        CHECK(s.commit());
+        
+        // Updates until the next one would not fit and compact
+        for (int i = 0; activeBytes() < 4096 - 80; i++) {
+            snprintf(value, sizeof(value), "updated-%d-%s", i, "abcdefghijklmnopqrstuvwxyz");
+            s.putString(keyName(i % KEYS).c_str(), value);
+            CHECK(s.commit());
+        }
+    }
+    
+    printf("StorageEEPROM boot, %d keys plus a network list (host):\n", KEYS);
+    printf("  %-10s %6s %12s %7s %7s %7s %12s %6s\n", "image", "bytes", "begin()", "allocs", "blocks",
+           "bytes", "getString", "allocs");
+    measure("full log");
+    
+    // The same keys, compacted: one record each
+    {
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        String values[KEYS];
+        String networks = s.getString("networks");
+        for (int i = 0; i < KEYS; i++) values[i] = s.getString(keyName(i).c_str());
+        s.clear();
+        for (int i = 0; i < KEYS; i++) s.putString(keyName(i).c_str(), values[i]);
+        s.putString("networks", networks);
+        CHECK(s.commit());
+    }
+    measure("compacted");
+    
+    return finish("bench_eeprom_load");
+}
@@ -0,0 +1,171 @@
+// Heap cost and lookup time of the storage cache: EntryTable against the
+// std::map<String, Entry> StorageEEPROM used before, with numbers kept as
+// decimal text. Both hold the same 26 keys of a typical namespace.
+//
+// Sizes are host (64-bit) sizes as requested from new/malloc. The host
+// String is std::string, which keeps up to 15 characters inline; the
+// ESP8266 and ESP32 Strings keep 11, so on the device more of the map's
+// keys and values take a heap block of their own.
+#include "HostHeap.h"
+#include "HostTest.h"
+#include "storage/EntryTable.h"
+#include <map>
+
+using namespace IonConnect;
+
+typedef EntryTable::DataType DataType;
+
+// The cache StorageEEPROM had before EntryTable
+struct MapEntry {
+    DataType type;
+    String value;
+    bool dirty = true;
+};
+typedef std::map<String, MapEntry> MapCache;
+
+struct Item {
+    const char* key;
+    DataType type;
+    const char* value;
+};
+
+static const Item ITEMS[] = {
+    {"wifi_ssid", EntryTable::TYPE_STRING, "home-network-5g"},
+    {"wifi_password", EntryTable::TYPE_STRING, "correct horse battery staple"},
+    {"device_name", EntryTable::TYPE_STRING, "greenhouse-sensor"},
+    {"mqtt_host", EntryTable::TYPE_STRING, "broker.home.lan"},
+    {"mqtt_user", EntryTable::TYPE_STRING, "sensor"},
+    {"mqtt_password", EntryTable::TYPE_STRING, "enc:8f14e45fceea167a5a36dedd4bea2543"},
+    {"mqtt_topic", EntryTable::TYPE_STRING, "home/greenhouse/sensor"},
+    {"ntp_server", EntryTable::TYPE_STRING, "pool.ntp.org"},
+    {"timezone", EntryTable::TYPE_STRING, "CET-1CEST,M3.5.0,M10.5.0/3"},
+    {"ota_password", EntryTable::TYPE_STRING, "enc:c9f0f895fb98ab9159f51fd0297e236d"},
+    {"static_ip", EntryTable::TYPE_STRING, "192.168.1.50"},
+    {"gateway", EntryTable::TYPE_STRING, "192.168.1.1"},
+    {"subnet", EntryTable::TYPE_STRING, "255.255.255.0"},
+    {"dns", EntryTable::TYPE_STRING, "192.168.1.1"},
+    {"networks", EntryTable::TYPE_STRING, "[{\"ssid\":\"home-network-5g\",\"priority\":1}]"},
+    {"schema_hash", EntryTable::TYPE_STRING, "3b5d5c3712955042"},
+    {"mqtt_port", EntryTable::TYPE_INT, "1883"},
+    {"interval", EntryTable::TYPE_INT, "60"},
+    {"threshold", EntryTable::TYPE_INT, "-15"},
+    {"retries", EntryTable::TYPE_INT, "3"},
+    {"ap_channel", EntryTable::TYPE_INT, "6"},
+    {"boot_count", EntryTable::TYPE_INT, "1274"},
+    {"uptime_total", EntryTable::TYPE_UINT, "4224884534"},
+    {"config_gen", EntryTable::TYPE_UINT, "87"},
+    {"use_dhcp", EntryTable::TYPE_BOOL, "0"},
+    {"mqtt_tls", EntryTable::TYPE_BOOL, "1"},
+};
+static const int COUNT = sizeof(ITEMS) / sizeof(ITEMS[0]);
+
+struct Heap {
+    size_t allocations;
+    size_t blocks;
+    size_t bytes;
+};
+
+template<class F>
+static Heap measure(F build) {
+    size_t blocks = HostHeap::liveBlocks;
+    size_t bytes = HostHeap::liveBytes;
+    HostHeap::reset();
+    build();
+    return Heap{HostHeap::allocations, HostHeap::liveBlocks - blocks, HostHeap::liveBytes - bytes};
+}
+
+static void fillMap(MapCache& cache) {
+    for (const Item& item : ITEMS) {
+        MapEntry& entry = cache[item.key];
+        entry.type = item.type;
+        entry.value = item.value;
+    }
+}
+
+static void fillTable(EntryTable& table) {
+    for (const Item& item : ITEMS) {
+        if (item.type == EntryTable::TYPE_STRING) {
+            table.setData(item.key, strlen(item.key), item.type, item.value, strlen(item.value));
+        } else {
+            uint32_t value = item.type == EntryTable::TYPE_UINT ? strtoul(item.value, nullptr, 10)
+                                                                : (uint32_t)strtol(item.value, nullptr, 10);
+            table.setNumber(item.key, strlen(item.key), item.type, value);
+        }
+    }
+}
+
+int main() {
+    volatile long sink = 0;
+    
+    MapCache map;
+    EntryTable table;
+    Heap mapHeap = measure([&] { fillMap(map); });
+    Heap tableHeap = measure([&] { fillTable(table); });
+    
+    // Same contents
+    for (const Item& item : ITEMS) {
+        int index = table.find(item.key);
+        CHECK(index >= 0);
+        if (index < 0) continue;
+        const EntryTable::Entry& entry = table.at(index);
+        if (entry.hasData()) {
+            CHECK(map[item.key].value == String(item.value));
+            CHECK_EQ(entry.value.data.length, strlen(item.value));
+        } else if (entry.type == EntryTable::TYPE_UINT) {
+            CHECK_EQ(entry.value.u, strtoul(map[item.key].value.c_str(), nullptr, 10));
+        } else {
+            CHECK_EQ(entry.value.i, map[item.key].value.toInt());
+        }
+    }
+    
+    String keys[COUNT];
+    {
+        HostHeap::Pause pause;
+        for (int i = 0; i < COUNT; i++) keys[i] = ITEMS[i].key;
+    }
+    
+    // getInt(): the map parses the decimal text on every read
+    const int firstInt = 16;
+    double mapInt = nsPerCall(200000, [&](long i) {
+        auto it = map.find(keys[firstInt + i % 6]);
+        sink += it != map.end() ? it->second.value.toInt() : 0;
+    });
+    double tableInt = nsPerCall(200000, [&](long i) {
+        int index = table.find(keys[firstInt + i % 6].c_str());
+        sink += index >= 0 ? table.at(index).value.i : 0;
+    });
+    
+    // getString(): a copy of the value either way
+    HostHeap::reset();
+    double mapString = nsPerCall(200000, [&](long i) {
+        auto it = map.find(keys[i % 16]);
+        String value = it != map.end() ? it->second.value : String();
+        sink += value.length();
+    });
+    double mapStringAllocations = HostHeap::allocations / (200000.0 * 5);
+    HostHeap::reset();
+    double tableString = nsPerCall(200000, [&](long i) {
+        int index = table.find(keys[i % 16].c_str());
+        String value;
+        if (index >= 0) {
+            const EntryTable::Entry& entry = table.at(index);
+            value.concat((const char*)table.dataOf(entry), entry.value.data.length);
+        }
+        sink += value.length();
+    });
+    double tableStringAllocations = HostHeap::allocations / (200000.0 * 5);
+    
+    printf("Storage cache, %d keys (16 strings, 6 ints, 2 uints, 2 bools), host:\n", COUNT);
+    printf("  %-10s %7s %7s %7s %11s %11s %7s\n", "cache", "allocs", "blocks", "bytes", "getInt", "getString",
+           "allocs");
+    printf("  %-10s %7zu %7zu %7zu %8.1f ns %8.1f ns %7.2f\n", "std::map", mapHeap.allocations, mapHeap.blocks,
+           mapHeap.bytes, mapInt, mapString, mapStringAllocations);
+    printf("  %-10s %7zu %7zu %7zu %8.1f ns %8.1f ns %7.2f\n", "EntryTable", tableHeap.allocations,
+           tableHeap.blocks, tableHeap.bytes, tableInt, tableString, tableStringAllocations);
+    printf("  EntryTable arena: %zu bytes, %zu bytes per entry\n", table.capacity(), sizeof(EntryTable::Entry));
+    
+    CHECK_EQ(tableHeap.blocks, 1);
+    CHECK(tableHeap.bytes < mapHeap.bytes);
+    
+    return finish("bench_entry_table");
+}
@@ -0,0 +1,66 @@
+// Per-call cost of schema field access with ION_MAX_CONFIG_FIELDS fields:
+// the linear id scan getField() used before the sorted index, the indexed
+// getField()/get(), and a bound ConfigHandle. Keys are spread over the
+// whole table so the linear scan is measured at its average.
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "storage/StorageNVS.h"
+
+using namespace IonConnect;
+
+static const int FIELDS = ION_MAX_CONFIG_FIELDS;
+static const long CALLS = 200000;
+
+static char ids[FIELDS][16];
+static ConfigField table[FIELDS];
+
+// getField() before the index: strcmp over every descriptor
+static const ConfigField* linearField(ConfigManager& config, const String& key) {
+    for (size_t i = 0; i < config.getFieldCount(); i++) {
+        const ConfigField* field = config.getFieldAt(i);
+        if (strcmp_P(key.c_str(), field->id) == 0) {
+            return field;
+        }
+    }
+    return nullptr;
+}
+
+int main() {
+    for (int i = 0; i < FIELDS; i++) {
+        // Shared prefixes, as in real schemas (mqtt_host, mqtt_port, ...)
+        snprintf(ids[i], sizeof(ids[i]), "field_%02d", i);
+        table[i] = ConfigField{ids[i], "", "text", "value", "", "", "", nullptr, 0,
+                               0, 0, 0, 0, false, false, FIELD_TEXT};
+    }
+    
+    StorageNVS storage;
+    storage.begin("bench");
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(table, FIELDS, "{}"));
+    CHECK(config.load());
+    
+    String keys[FIELDS];
+    ConfigHandle handles[FIELDS];
+    for (int i = 0; i < FIELDS; i++) {
+        keys[i] = ids[(i * 7) % FIELDS];
+        handles[i] = config.getHandle(keys[i]);
+        CHECK(linearField(config, keys[i]) == config.getField(keys[i]));
+        CHECK(handles[i].get() == "value");
+    }
+    
+    volatile size_t sink = 0;
+    double linear = nsPerCall(CALLS, [&](long i) { sink += (size_t)linearField(config, keys[i % FIELDS]); });
+    double indexed = nsPerCall(CALLS, [&](long i) { sink += (size_t)config.getField(keys[i % FIELDS]); });
+    double get = nsPerCall(CALLS, [&](long i) { sink += config.get(keys[i % FIELDS]).length(); });
+    double handle = nsPerCall(CALLS, [&](long i) { sink += handles[i % FIELDS].get().length(); });
+    double handleInt = nsPerCall(CALLS, [&](long i) { sink += handles[i % FIELDS].getInt(); });
+    
+    printf("Field lookup, %d fields, ns per call (host, -O2):\n", FIELDS);
+    printf("  getField, linear scan (before)  %7.1f\n", linear);
+    printf("  getField, sorted index          %7.1f\n", indexed);
+    printf("  get(key) -> String copy         %7.1f\n", get);
+    printf("  ConfigHandle::get()             %7.1f\n", handle);
+    printf("  ConfigHandle::getInt()          %7.1f\n", handleInt);
+    
+    return finish("bench_field_lookup");
+}
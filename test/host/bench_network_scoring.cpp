@@ -0,0 +1,113 @@
+// Network choice over an hour of unreliable links, per scoring policy. Two
+// saved networks; RSSI varies by up to 5 dB every second, and each link is
+// lost a fixed time after joining. The AP then moves channel, so the
+// cached-BSSID rejoin fails and every reconnect scans and picks a network
+// again. In each scenario the network with the stronger mean is the worse
+// one to join: two weak APs whose signals cross, a strong AP that drops
+// every link soon after joining, and a preferred network with a weaker
+// signal. Reports reconnects, moves between the two networks and the share
+// of the hour spent connected.
+#include <random>
+#include "WiFiHarness.h"
+
+using namespace IonConnect;
+
+struct Scenario {
+    const char* description;
+    int rssiA, rssiB;               // Mean
+    int8_t priorityA, priorityB;
+    unsigned long holdA, holdB;     // Link lost this long after joining
+};
+
+struct Outcome {
+    int reconnects;
+    int switches;
+    double connected;               // Share of the hour
+};
+
+static Outcome run(const Scenario& scenario, ScoringPolicy* policy, uint8_t hysteresis) {
+    WiFiHarness host;
+    sim.dhcpTime = 0;
+    sim.scanTime = 2000;
+    std::vector<SimAP> aps = {{"alpha", scenario.rssiA, 1, {0xAA}}, {"beta", scenario.rssiB, 6, {0xBB}}};
+    sim.aps = aps;
+    
+    WiFiConnectionCore wifi(&host.config);
+    wifi.begin();
+    wifi.setMaxReconnectAttempts(255);
+    wifi.setScoringPolicy(policy, hysteresis);
+    wifi.addNetwork("alpha", "password1", scenario.priorityA);
+    wifi.addNetwork("beta", "password2", scenario.priorityB);
+    
+    Outcome outcome = {0, 0, 0};
+    String last;
+    wifi.onDisconnect([&] { outcome.reconnects++; });
+    wifi.onConnect([&] {
+        if (!last.isEmpty() && sim.joined != last) outcome.switches++;
+        last = sim.joined;
+    });
+    
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> noise(-5, 5);
+    unsigned long joinedAt = 0;
+    unsigned long connectedMs = 0;
+    wifi.connectToBest();
+    
+    for (unsigned long t = 0; t < 3600000UL; t += 10) {
+        // The first scan sees the means
+        if (hostClock % 1000 == 0 && hostClock > 5000) {
+            aps[0].rssi = scenario.rssiA + noise(rng);
+            aps[1].rssi = scenario.rssiB + noise(rng);
+            sim.aps = aps;
+        }
+        host.tick(wifi);
+        
+        if (sim.status != WL_CONNECTED) {
+            joinedAt = 0;
+            continue;
+        }
+        connectedMs += 10;
+        if (!joinedAt) joinedAt = hostClock;
+        bool alpha = sim.joined == "alpha";
+        if (hostClock - joinedAt >= (alpha ? scenario.holdA : scenario.holdB)) {
+            sim.dropLink();
+            joinedAt = 0;
+            SimAP& ap = aps[alpha ? 0 : 1];
+            ap.channel = ap.channel == 1 ? 11 : 1;
+            sim.aps = aps;
+        }
+    }
+    
+    outcome.connected = connectedMs / 36000.0;
+    return outcome;
+}
+
+int main() {
+    static const Scenario SCENARIOS[] = {
+        {"alpha -73 dBm, lost every 10 min; beta -72 dBm, lost 30 s after each join",
+         -73, -72, 0, 0, 600000, 30000},
+        {"alpha -74 dBm, lost every 10 min; beta -64 dBm, lost 20 s after each join",
+         -74, -64, 0, 0, 600000, 20000},
+        {"alpha -75 dBm, priority 5, lost every 20 min; beta -68 dBm, lost every 2 min",
+         -75, -68, 5, 0, 1200000, 120000},
+    };
+    RSSIScoringPolicy rssi;
+    WeightedScoringPolicy weighted;
+    
+    printf("One hour with two saved networks (simulated):\n");
+    for (const Scenario& scenario : SCENARIOS) {
+        printf("  %s\n", scenario.description);
+        printf("    %-24s %10s %9s %10s\n", "policy", "reconnects", "switches", "connected");
+        Outcome strongest = run(scenario, &rssi, 0);
+        Outcome scored = run(scenario, &weighted, 8);
+        printf("    %-24s %10d %9d %9.1f%%\n", "RSSI only", strongest.reconnects, strongest.switches,
+               strongest.connected);
+        printf("    %-24s %10d %9d %9.1f%%\n", "weighted, hysteresis 8", scored.reconnects, scored.switches,
+               scored.connected);
+        
+        CHECK(scored.reconnects < strongest.reconnects);
+        CHECK(scored.connected > strongest.connected);
+    }
+    
+    return finish("bench_network_scoring");
+}
@@ -0,0 +1,66 @@
+// Pattern matching cost for typical field patterns (hostname, MQTT topic,
+// IPv4), against std::regex as a reference backtracking engine, and how it
+// scales with input length.
+#include <regex>
+#include "HostTest.h"
+#include "utils/Pattern.h"
+
+using namespace IonConnect;
+
+struct Bench {
+    const char* name;
+    const char* pattern;
+    const char* text;
+};
+
+static const Bench BENCHES[] = {
+    {"hostname", "[a-zA-Z0-9]([a-zA-Z0-9-]{0,61}[a-zA-Z0-9])?(\\.[a-zA-Z0-9]([a-zA-Z0-9-]{0,61}[a-zA-Z0-9])?)*",
+     "sensor-node-17.home.local"},
+    {"mqtt topic", "[^#+]+(/[^#+]*)*", "home/livingroom/sensor/temperature"},
+    {"ipv4", "^\\d{1,3}(\\.\\d{1,3}){3}$", "192.168.100.200"},
+};
+
+int main() {
+    volatile int sink = 0;
+    
+    printf("Pattern, host -O2:\n");
+    printf("  %-11s %6s %10s %10s %11s\n", "pattern", "heap B", "compile", "match", "std::regex");
+    for (const Bench& b : BENCHES) {
+        Pattern p;
+        CHECK(p.compile(b.pattern));
+        CHECK(p.matches(b.text));
+        double compile = nsPerCall(2000, [&](long) { Pattern q; sink += q.compile(b.pattern); });
+        double match = nsPerCall(100000, [&](long) { sink += p.matches(b.text); });
+        std::regex re(b.pattern);
+        CHECK(std::regex_match(b.text, re));
+        double reference = nsPerCall(20000, [&](long) { sink += std::regex_match(b.text, re); });
+        printf("  %-11s %6zu %7.0f ns %7.0f ns %8.0f ns\n", b.name, p.memoryUsage(), compile, match, reference);
+    }
+    
+    // Linear in the input: cost per character stays flat
+    Pattern host;
+    CHECK(host.compile(BENCHES[0].pattern));
+    printf("\n  hostname, by input length:\n");
+    for (int labels : {1, 4, 16, 64}) {
+        std::string text;
+        for (int i = 0; i < labels; i++) text += i ? ".node15" : "node15";
+        CHECK(host.matches(text.c_str()));
+        double ns = nsPerCall(20000, [&](long) { sink += host.matches(text.c_str()); });
+        printf("    %4zu chars %9.0f ns  %5.1f ns/char\n", text.size(), ns, ns / text.size());
+    }
+    
+    // Pathological for backtracking: (a|aa)*c against a^n b
+    Pattern evil;
+    CHECK(evil.compile("(a|aa)*c"));
+    std::regex evilRe("(a|aa)*c");
+    printf("\n  (a|aa)*c on a^n b:     Pattern   std::regex\n");
+    for (int n : {8, 16, 24}) {
+        std::string text(n, 'a');
+        text += 'b';
+        double ns = nsPerCall(2000, [&](long) { sink += evil.matches(text.c_str()); });
+        double ref = nsPerCall(1, [&](long) { sink += std::regex_match(text, evilRe); }, 1);
+        printf("    n = %2d %19.0f ns %10.0f ns\n", n, ns, ref);
+    }
+    
+    return finish("bench_pattern");
+}
@@ -0,0 +1,93 @@
+// Heap cost of loading a schema: allocations made during the load, blocks
+// and bytes the loaded schema keeps, and the peak above the starting
+// point. Blocks freed during the load are transient; every block kept is
+// a separate object pinned in the heap until the next schema load.
+//
+// Sizes are host (64-bit) sizes as requested from new/malloc; pointers and
+// size_t are half that on the ESP32/ESP8266.
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "schemas/default_schema.h"
+
+using namespace IonConnect;
+
+struct Load {
+    size_t allocations;
+    size_t keptBlocks;
+    size_t keptBytes;
+    size_t peakBytes;
+};
+
+template<class F>
+static Load measure(F load) {
+    size_t blocks = HostHeap::liveBlocks;
+    size_t bytes = HostHeap::liveBytes;
+    HostHeap::reset();
+    CHECK(load());
+    return Load{HostHeap::allocations, HostHeap::liveBlocks - blocks, HostHeap::liveBytes - bytes,
+                HostHeap::peakBytes - bytes};
+}
+
+static void print(const char* name, const Load& l) {
+    printf("  %-30s %6zu %6zu %8zu %8zu\n", name, l.allocations, l.keptBlocks, l.keptBytes, l.peakBytes);
+}
+
+// 32 fields like an application schema, sized to fit the default
+// ION_JSON_SCHEMA_SIZE document: every field has an id, label and type;
+// a quarter have a pattern, a quarter are selects with four options
+static String schema32() {
+    HostHeap::Pause pause;
+    String json = "{\"fields\":[";
+    for (int i = 0; i < 32; i++) {
+        char field[200];
+        switch (i % 4) {
+            case 0:
+                snprintf(field, sizeof(field), "{\"id\":\"host%02d\",\"label\":\"Host %d\",\"type\":\"text\","
+                         "\"pattern\":\"[a-z0-9.-]+\"}", i, i);
+                break;
+            case 1:
+                snprintf(field, sizeof(field), "{\"id\":\"port%02d\",\"label\":\"Port %d\",\"type\":\"number\"}", i, i);
+                break;
+            case 2:
+                snprintf(field, sizeof(field), "{\"id\":\"tls%02d\",\"label\":\"TLS %d\",\"type\":\"checkbox\"}", i, i);
+                break;
+            default:
+                snprintf(field, sizeof(field), "{\"id\":\"mode%02d\",\"label\":\"Mode %d\",\"type\":\"select\","
+                         "\"options\":[\"auto\",\"on\",\"off\",\"eco\"]}", i, i);
+                break;
+        }
+        if (i) json += ",";
+        json += field;
+    }
+    json += "]}";
+    return json;
+}
+
+int main() {
+    String big = schema32();
+    
+    printf("Schema load heap, host sizes:\n");
+    printf("  %-30s %6s %6s %8s %8s\n", "", "allocs", "blocks", "kept B", "peak B");
+    {
+        ConfigManager config(nullptr);
+        print("default, runtime JSON", measure([&] { return config.loadSchema(DEFAULT_SCHEMA); }));
+        print("default, reload", measure([&] { return config.loadSchema(DEFAULT_SCHEMA); }));
+        CHECK_EQ(config.getFieldCount(), DEFAULT_SCHEMA_FIELD_COUNT);
+    }
+    {
+        ConfigManager config(nullptr);
+        print("default, compiled table", measure([&] {
+            return config.loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA);
+        }));
+    }
+    {
+        ConfigManager config(nullptr);
+        print("32 fields, runtime JSON", measure([&] { return config.loadSchema(big.c_str()); }));
+        print("32 fields, reload", measure([&] { return config.loadSchema(big.c_str()); }));
+        CHECK_EQ(config.getFieldCount(), 32);
+        CHECK(config.getField("mode31") != nullptr);
+    }
+    printf("  sizeof(ConfigField) = %zu\n", sizeof(ConfigField));
+    
+    return finish("bench_schema_heap");
+}
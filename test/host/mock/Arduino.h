@@ -0,0 +1,246 @@
+// Host stand-in for the Arduino core: just enough of String, Print/Stream,
+// timing and EspClass for the library sources to build and run on a PC.
+// Time is simulated: millis() returns hostClock, which tests advance.
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cctype>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+#define F(s) FPSTR(s)
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define pgm_read_word(a) (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
+#define pgm_read_ptr(a) (*(void* const*)(a))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define HEX 16
+#define DEC 10
+
+class __FlashStringHelper;
+
+class String {
+public:
+    String() {}
+    String(const char* c) { if (c) s = c; }
+    String(const __FlashStringHelper* c) { if (c) s = (const char*)c; }
+    String(const std::string& x) : s(x) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int v, unsigned base = 10) { format(base == 16 ? "%x" : "%d", v); }
+    explicit String(unsigned v, unsigned base = 10) { format(base == 16 ? "%x" : "%u", v); }
+    explicit String(long v) { s = std::to_string(v); }
+    explicit String(unsigned long v) { s = std::to_string(v); }
+    explicit String(long long v) { s = std::to_string(v); }
+    explicit String(unsigned long long v) { s = std::to_string(v); }
+    explicit String(unsigned char v, unsigned base = 10) { format(base == 16 ? "%x" : "%u", v); }
+    explicit String(float v, unsigned decimals = 2) { format("%.*f", (int)decimals, v); }
+    explicit String(double v, unsigned decimals = 2) { format("%.*f", (int)decimals, v); }
+
+    const char* c_str() const { return s.c_str(); }
+    size_t length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(size_t n) { s.reserve(n); return true; }
+    explicit operator bool() const { return true; }
+
+    char operator[](size_t i) const { return i < s.size() ? s[i] : 0; }
+    char& operator[](size_t i) { return s[i]; }
+    char charAt(size_t i) const { return (*this)[i]; }
+    void setCharAt(size_t i, char c) { if (i < s.size()) s[i] = c; }
+
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool operator<(const String& o) const { return s < o.s; }
+    bool equals(const String& o) const { return s == o.s; }
+    bool equalsIgnoreCase(const String& o) const {
+        return s.size() == o.s.size() && std::equal(s.begin(), s.end(), o.s.begin(),
+            [](char a, char b) { return tolower(a) == tolower(b); });
+    }
+    int compareTo(const String& o) const { return s.compare(o.s); }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { if (o) s += o; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned v) { s += std::to_string(v); return *this; }
+    String& operator+=(long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+    bool concat(const char* c, size_t n) { s.append(c, n); return true; }
+    bool concat(const char* c) { if (c) s += c; return true; }
+    bool concat(const String& o) { s += o.s; return true; }
+    bool concat(char c) { s += c; return true; }
+    bool concat(int v) { s += std::to_string(v); return true; }
+    bool concat(unsigned v) { s += std::to_string(v); return true; }
+    bool concat(long v) { s += std::to_string(v); return true; }
+    bool concat(unsigned long v) { s += std::to_string(v); return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+    friend String operator+(const String& a, int b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, long b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned long b) { return String(a.s + std::to_string(b)); }
+
+    bool startsWith(const String& p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+    bool endsWith(const String& p) const {
+        return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+    }
+    String substring(size_t from) const { return from > s.size() ? String() : String(s.substr(from)); }
+    String substring(size_t from, size_t to) const {
+        if (from > to) std::swap(from, to);
+        return from > s.size() ? String() : String(s.substr(from, to - from));
+    }
+    int indexOf(const String& p, size_t from = 0) const { return found(s.find(p.s, from)); }
+    int indexOf(const char* p, size_t from = 0) const { return found(s.find(p, from)); }
+    int indexOf(char c, size_t from = 0) const { return found(s.find(c, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    int lastIndexOf(const String& p) const { return found(s.rfind(p.s)); }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+    void toLowerCase() { for (auto& c : s) c = tolower(c); }
+    void toUpperCase() { for (auto& c : s) c = toupper(c); }
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+    void remove(size_t i) { if (i < s.size()) s.erase(i); }
+    void remove(size_t i, size_t n) { if (i < s.size()) s.erase(i, n); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        for (size_t pos = 0; (pos = s.find(from.s, pos)) != std::string::npos; pos += to.s.size()) {
+            s.replace(pos, from.s.size(), to.s);
+        }
+    }
+    void clear() { s.clear(); }
+
+private:
+    std::string s;
+
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    void format(const char* fmt, ...) {
+        char buf[64];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        s = buf;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) write(buffer[i]);
+        return size;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t println() { return write("\n"); }
+    template<class T> size_t println(const T& v) { return print(v) + println(); }
+    size_t printf(const char* fmt, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        return n > 0 ? write(buf) : 0;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        for (int c; n < length && (c = read()) >= 0;) buffer[n++] = (char)c;
+        return n;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString() {
+        String out;
+        for (int c; (c = read()) >= 0;) out += (char)c;
+        return out;
+    }
+};
+
+// Log output is dropped unless HOST_VERBOSE is set in the environment
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+extern HardwareSerial Serial;
+
+// Simulated time, in milliseconds; read by the library's tasks too
+extern std::atomic<unsigned long> hostClock;
+inline unsigned long millis() { return hostClock; }
+inline unsigned long micros() { return hostClock * 1000; }
+inline void delay(unsigned long ms) { hostClock += ms; }
+inline void yield() {}
+inline long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+inline long random(long howSmall, long howBig) { return howSmall + random(howBig - howSmall); }
+
+template<class A, class B> typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template<class A, class B> typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+template<class A, class B, class C> A constrain(A a, B lo, C hi) { return a < lo ? lo : (a > hi ? hi : a); }
+
+// Flash operations go to the simulated flash in HostFlash.h
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 40000; }
+    uint32_t getMaxFreeBlockSize() { return 30000; }
+    uint8_t getHeapFragmentation() { return 0; }
+    uint32_t getHeapSize() { return 80000; }
+    uint32_t getMinFreeHeap() { return 30000; }
+    uint32_t getMaxAllocHeap() { return 30000; }
+    uint32_t getChipId() { return 0x00C0FFEE; }
+    uint64_t getEfuseMac() { return 0x0000C0FFEE123456ULL; }
+    const char* getChipModel() { return "host"; }
+    uint8_t getChipRevision() { return 0; }
+    uint32_t getCpuFreqMHz() { return 80; }
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+    uint32_t getFreeSketchSpace() { return 1024 * 1024; }
+    uint32_t getSketchSize() { return 512 * 1024; }
+    uint32_t getCycleCount() { return 0; }
+    void restart() {}
+    void deepSleep(uint64_t) {}
+    bool flashEraseSector(uint32_t sector);
+    bool flashWrite(uint32_t address, uint32_t* data, size_t size);
+    bool flashRead(uint32_t address, uint32_t* data, size_t size);
+};
+extern EspClass ESP;
+
+#include "IPAddress.h"
@@ -0,0 +1,645 @@
+// Working stand-in for the part of ArduinoJson 6 the library uses: a
+// document with a fixed capacity, variants, objects, arrays, and JSON
+// parsing and printing.
+//
+// Memory behaves like the real thing where it shows on the heap: a
+// document allocates its whole capacity as one block through its
+// allocator, and nodes and copied strings are charged against it (16
+// bytes per node, as on a 32-bit target), failing with NoMemory when it
+// is used up. The nodes themselves live in host containers allocated
+// under HostHeap::Pause, so heap figures only show the document block.
+#pragma once
+
+#include <deque>
+#include <string_view>
+#include <unordered_set>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "Arduino.h"
+#include "HostHeap.h"
+
+namespace HostJson {
+
+enum Type : uint8_t { NUL, OBJECT, ARRAY, STRING, INTEGER, UNSIGNED, FLOAT, BOOLEAN };
+
+struct Node {
+    Type type = NUL;
+    const char* key = nullptr;      // Set for object members
+    Node* next = nullptr;           // Next member or element
+    Node* first = nullptr;          // Object or array content
+    Node* last = nullptr;
+    const char* str = nullptr;
+    long long i = 0;
+    unsigned long long u = 0;
+    double f = 0;
+    bool b = false;
+};
+
+struct Pool {
+    static const size_t SLOT_SIZE = 16;
+
+    size_t capacity = 0;
+    size_t used = 0;
+    bool overflowed = false;
+    std::deque<Node> nodes;
+    std::deque<std::string> strings;
+    std::unordered_set<std::string_view> index;    // Over `strings`
+
+    ~Pool() {
+        HostHeap::Pause pause;
+        nodes.clear();
+        index.clear();
+        strings.clear();
+    }
+
+    bool charge(size_t n) {
+        if (used + n > capacity) {
+            overflowed = true;
+            return false;
+        }
+        used += n;
+        return true;
+    }
+
+    Node* newNode() {
+        if (!charge(SLOT_SIZE)) return nullptr;
+        HostHeap::Pause pause;
+        nodes.emplace_back();
+        return &nodes.back();
+    }
+
+    // Copies are deduplicated, as in ArduinoJson 6.16+
+    const char* copy(const char* s, size_t n) {
+        auto found = index.find(std::string_view(s, n));
+        if (found != index.end()) return found->data();
+        if (!charge(n + 1)) return nullptr;
+        HostHeap::Pause pause;
+        strings.emplace_back(s, n);
+        index.insert(std::string_view(strings.back()));
+        return strings.back().c_str();
+    }
+
+    void clear() {
+        HostHeap::Pause pause;
+        nodes.clear();
+        index.clear();
+        strings.clear();
+        used = 0;
+        overflowed = false;
+    }
+};
+
+inline void reset(Node* n) {
+    n->type = NUL;
+    n->first = n->last = nullptr;
+    n->str = nullptr;
+}
+
+inline void append(Node* parent, Node* child) {
+    if (parent->last) {
+        parent->last->next = child;
+    } else {
+        parent->first = child;
+    }
+    parent->last = child;
+}
+
+inline Node* member(Node* object, const char* key) {
+    if (!object || object->type != OBJECT || !key) return nullptr;
+    for (Node* n = object->first; n; n = n->next) {
+        if (strcmp(n->key, key) == 0) return n;
+    }
+    return nullptr;
+}
+
+inline Node* element(Node* array, size_t index) {
+    if (!array || array->type != ARRAY) return nullptr;
+    Node* n = array->first;
+    while (n && index--) n = n->next;
+    return n;
+}
+
+inline size_t count(const Node* n) {
+    if (!n || (n->type != OBJECT && n->type != ARRAY)) return 0;
+    size_t c = 0;
+    for (const Node* m = n->first; m; m = m->next) c++;
+    return c;
+}
+
+bool deepCopy(Pool* pool, Node* to, const Node* from);
+void write(const Node* n, std::string& out, int indent, int depth);
+
+template<class T> struct IsString : std::false_type {};
+template<> struct IsString<String> : std::true_type {};
+template<> struct IsString<std::string> : std::true_type {};
+
+} // namespace HostJson
+
+class JsonVariant;
+class JsonObject;
+class JsonArray;
+
+class JsonString {
+public:
+    JsonString(const char* s = nullptr) : s(s) {}
+    const char* c_str() const { return s; }
+    size_t size() const { return s ? strlen(s) : 0; }
+    bool isNull() const { return !s; }
+    explicit operator bool() const { return s != nullptr; }
+    bool operator==(const char* o) const { return s && o && strcmp(s, o) == 0; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    operator String() const { return String(s); }
+
+private:
+    const char* s;
+};
+
+class JsonVariant {
+public:
+    JsonVariant() : pool(nullptr), node(nullptr), index(0) {}
+    JsonVariant(HostJson::Pool* pool, HostJson::Node* node) : pool(pool), node(node), index(0) {}
+
+    bool isNull() const { return !node || node->type == HostJson::NUL; }
+    size_t size() const { return HostJson::count(node); }
+    size_t memoryUsage() const { return pool ? pool->used : 0; }
+
+    template<class T> T as() const;
+    template<class T> bool is() const;
+
+    template<class T> T operator|(const T& fallback) const {
+        return is<T>() ? as<T>() : fallback;
+    }
+    const char* operator|(const char* fallback) const {
+        return is<const char*>() ? as<const char*>() : fallback;
+    }
+
+    JsonVariant operator[](const char* key) const {
+        HostJson::Node* n = HostJson::member(node, key);
+        if (n) return JsonVariant(pool, n);
+        HostHeap::Pause pause;  // Proxies are free on the device
+        JsonVariant proxy;
+        proxy.pool = pool;
+        proxy.parent = std::make_shared<JsonVariant>(*this);
+        proxy.key = key;
+        return proxy;
+    }
+    JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+    JsonVariant operator[](const __FlashStringHelper* key) const { return (*this)[(const char*)key]; }
+    JsonVariant operator[](char* key) const { return (*this)[(const char*)key]; }
+    JsonVariant operator[](int i) const { return JsonVariant(pool, HostJson::element(node, i)); }
+    JsonVariant operator[](size_t i) const { return JsonVariant(pool, HostJson::element(node, i)); }
+
+    bool containsKey(const char* key) const { return HostJson::member(node, key) != nullptr; }
+    bool containsKey(const String& key) const { return containsKey(key.c_str()); }
+    bool containsKey(const __FlashStringHelper* key) const { return containsKey((const char*)key); }
+
+    void remove(const char* key) const {
+        if (!node || node->type != HostJson::OBJECT) return;
+        HostJson::Node* prev = nullptr;
+        for (HostJson::Node* n = node->first; n; prev = n, n = n->next) {
+            if (strcmp(n->key, key) == 0) {
+                (prev ? prev->next : node->first) = n->next;
+                if (node->last == n) node->last = prev;
+                return;
+            }
+        }
+    }
+    void remove(const String& key) const { remove(key.c_str()); }
+    void remove(const __FlashStringHelper* key) const { remove((const char*)key); }
+
+    template<class T> bool set(const T& value) const {
+        HostJson::Node* n = materialize();
+        if (!n) return false;
+        return assign(n, value);
+    }
+    template<class T> const JsonVariant& operator=(const T& value) const {
+        set(value);
+        return *this;
+    }
+    const JsonVariant& operator=(const JsonVariant& value) const {
+        set(value);
+        return *this;
+    }
+    JsonVariant(const JsonVariant&) = default;
+
+    template<class T> T to() const;
+    JsonObject createNestedObject() const;
+    JsonArray createNestedArray() const;
+    template<class K> JsonObject createNestedObject(const K& key) const;
+    template<class K> JsonArray createNestedArray(const K& key) const;
+
+    JsonVariant add() const {
+        HostJson::Node* array = materialize();
+        if (!array) return JsonVariant();
+        if (array->type == HostJson::NUL) array->type = HostJson::ARRAY;
+        if (array->type != HostJson::ARRAY) return JsonVariant();
+        HostJson::Node* n = pool->newNode();
+        if (!n) return JsonVariant();
+        HostJson::append(array, n);
+        return JsonVariant(pool, n);
+    }
+    template<class T> bool add(const T& value) const {
+        JsonVariant v = add();
+        return v.node && v.set(value);
+    }
+
+    HostJson::Node* getNode() const { return node; }
+    HostJson::Pool* getPool() const { return pool; }
+
+protected:
+    HostJson::Pool* pool;
+    mutable HostJson::Node* node;
+    std::shared_ptr<JsonVariant> parent;    // Pending member or element of it
+    std::string key;
+    size_t index;
+
+    // Creates a pending member on first write, like ArduinoJson's proxies
+    HostJson::Node* materialize() const {
+        if (node) return node;
+        if (!parent || !pool) return nullptr;
+        HostJson::Node* object = parent->materialize();
+        if (!object) return nullptr;
+        if (object->type == HostJson::NUL) object->type = HostJson::OBJECT;
+        if (object->type != HostJson::OBJECT) return nullptr;
+        if ((node = HostJson::member(object, key.c_str()))) return node;
+        HostJson::Node* n = pool->newNode();
+        const char* k = n ? pool->copy(key.data(), key.size()) : nullptr;
+        if (!k) return nullptr;
+        n->key = k;
+        HostJson::append(object, n);
+        return node = n;
+    }
+
+    bool assign(HostJson::Node* n, std::nullptr_t) const { HostJson::reset(n); return true; }
+    bool assign(HostJson::Node* n, bool v) const { HostJson::reset(n); n->type = HostJson::BOOLEAN; n->b = v; return true; }
+    bool assign(HostJson::Node* n, const char* v) const {
+        // Linked, not copied, as ArduinoJson does for const char*
+        HostJson::reset(n);
+        if (!v) return true;
+        n->type = HostJson::STRING;
+        n->str = v;
+        return true;
+    }
+    bool assign(HostJson::Node* n, char* v) const { return copyString(n, v, v ? strlen(v) : 0); }
+    bool assign(HostJson::Node* n, const String& v) const { return copyString(n, v.c_str(), v.length()); }
+    bool assign(HostJson::Node* n, const std::string& v) const { return copyString(n, v.data(), v.size()); }
+    bool assign(HostJson::Node* n, const __FlashStringHelper* v) const {
+        const char* s = (const char*)v;
+        return copyString(n, s, s ? strlen(s) : 0);
+    }
+    bool assign(HostJson::Node* n, const JsonString& v) const { return copyString(n, v.c_str(), v.size()); }
+    bool assign(HostJson::Node* n, const JsonVariant& v) const {
+        HostJson::reset(n);
+        return !v.node || HostJson::deepCopy(pool, n, v.node);
+    }
+    template<class T>
+    typename std::enable_if<std::is_arithmetic<T>::value, bool>::type assign(HostJson::Node* n, T v) const {
+        HostJson::reset(n);
+        if (std::is_floating_point<T>::value) {
+            n->type = HostJson::FLOAT;
+            n->f = (double)v;
+        } else if (std::is_signed<T>::value) {
+            n->type = HostJson::INTEGER;
+            n->i = (long long)v;
+        } else {
+            n->type = HostJson::UNSIGNED;
+            n->u = (unsigned long long)v;
+        }
+        return true;
+    }
+    template<size_t N> bool assign(HostJson::Node* n, const char (&v)[N]) const { return assign(n, (const char*)v); }
+    template<size_t N> bool assign(HostJson::Node* n, char (&v)[N]) const { return assign(n, (char*)v); }
+
+    bool copyString(HostJson::Node* n, const char* s, size_t len) const {
+        HostJson::reset(n);
+        if (!s) return true;
+        const char* copy = pool->copy(s, len);
+        if (!copy) return false;
+        n->type = HostJson::STRING;
+        n->str = copy;
+        return true;
+    }
+
+    friend class JsonDocument;
+};
+
+class JsonPair {
+public:
+    JsonPair(HostJson::Pool* pool, HostJson::Node* node) : pool(pool), node(node) {}
+    JsonString key() const { return JsonString(node->key); }
+    JsonVariant value() const { return JsonVariant(pool, node); }
+
+private:
+    HostJson::Pool* pool;
+    HostJson::Node* node;
+};
+
+template<class Item>
+class JsonIterator {
+public:
+    JsonIterator(HostJson::Pool* pool, HostJson::Node* node) : pool(pool), node(node) {}
+    Item operator*() const { return Item(pool, node); }
+    JsonIterator& operator++() {
+        node = node->next;
+        return *this;
+    }
+    bool operator!=(const JsonIterator& o) const { return node != o.node; }
+    bool operator==(const JsonIterator& o) const { return node == o.node; }
+
+private:
+    HostJson::Pool* pool;
+    HostJson::Node* node;
+};
+
+class JsonObject : public JsonVariant {
+public:
+    JsonObject() {}
+    JsonObject(const JsonVariant& v) : JsonVariant(v) {}
+    typedef JsonIterator<JsonPair> iterator;
+    iterator begin() const {
+        bool valid = node && node->type == HostJson::OBJECT;
+        return iterator(pool, valid ? node->first : nullptr);
+    }
+    iterator end() const { return iterator(pool, nullptr); }
+    using JsonVariant::operator=;
+};
+
+class JsonArray : public JsonVariant {
+public:
+    JsonArray() {}
+    JsonArray(const JsonVariant& v) : JsonVariant(v) {}
+    typedef JsonIterator<JsonVariant> iterator;
+    iterator begin() const {
+        bool valid = node && node->type == HostJson::ARRAY;
+        return iterator(pool, valid ? node->first : nullptr);
+    }
+    iterator end() const { return iterator(pool, nullptr); }
+    using JsonVariant::operator=;
+};
+
+typedef JsonVariant JsonVariantConst;
+typedef JsonObject JsonObjectConst;
+typedef JsonArray JsonArrayConst;
+typedef JsonPair JsonPairConst;
+
+template<class T> T JsonVariant::as() const {
+    using namespace HostJson;
+    typedef typename std::remove_cv<T>::type U;
+    if constexpr (std::is_same<U, JsonVariant>::value || std::is_same<U, JsonObject>::value ||
+                  std::is_same<U, JsonArray>::value) {
+        if (std::is_same<U, JsonObject>::value && (!node || node->type != OBJECT)) return U();
+        if (std::is_same<U, JsonArray>::value && (!node || node->type != ARRAY)) return U();
+        return U(*this);
+    } else if constexpr (std::is_same<U, const char*>::value) {
+        return node && node->type == STRING ? node->str : nullptr;
+    } else if constexpr (std::is_same<U, JsonString>::value) {
+        return JsonString(node && node->type == STRING ? node->str : nullptr);
+    } else if constexpr (IsString<U>::value) {
+        // Non-strings come back serialized, as in ArduinoJson 6.18+
+        if (node && node->type == STRING) return U(node->str);
+        std::string out;
+        write(node, out, 0, 0);
+        return U(out.c_str());
+    } else if constexpr (std::is_same<U, bool>::value) {
+        if (!node) return false;
+        switch (node->type) {
+            case BOOLEAN: return node->b;
+            case INTEGER: return node->i != 0;
+            case UNSIGNED: return node->u != 0;
+            case FLOAT: return node->f != 0;
+            default: return false;
+        }
+    } else if constexpr (std::is_arithmetic<U>::value) {
+        if (!node) return U(0);
+        switch (node->type) {
+            case INTEGER: return (U)node->i;
+            case UNSIGNED: return (U)node->u;
+            case FLOAT: return std::is_floating_point<U>::value || (node->f > -9.3e18 && node->f < 9.3e18) ? (U)node->f : U(0);
+            case BOOLEAN: return (U)node->b;
+            default: return U(0);
+        }
+    } else {
+        static_assert(sizeof(T) == 0, "as<T>() not supported by the host ArduinoJson");
+    }
+}
+
+template<class T> bool JsonVariant::is() const {
+    using namespace HostJson;
+    typedef typename std::remove_cv<T>::type U;
+    if (!node) return false;
+    if constexpr (std::is_same<U, JsonVariant>::value) {
+        return true;
+    } else if constexpr (std::is_same<U, JsonObject>::value) {
+        return node->type == OBJECT;
+    } else if constexpr (std::is_same<U, JsonArray>::value) {
+        return node->type == ARRAY;
+    } else if constexpr (std::is_same<U, const char*>::value || std::is_same<U, char*>::value ||
+                         IsString<U>::value || std::is_same<U, JsonString>::value) {
+        return node->type == STRING;
+    } else if constexpr (std::is_same<U, bool>::value) {
+        return node->type == BOOLEAN;
+    } else if constexpr (std::is_floating_point<U>::value) {
+        return node->type == FLOAT || node->type == INTEGER || node->type == UNSIGNED;
+    } else if constexpr (std::is_integral<U>::value) {
+        if (node->type == INTEGER) {
+            return node->i >= (long long)std::numeric_limits<U>::min() &&
+                   (node->i < 0 || (unsigned long long)node->i <= (unsigned long long)std::numeric_limits<U>::max());
+        }
+        if (node->type == UNSIGNED) {
+            return node->u <= (unsigned long long)std::numeric_limits<U>::max();
+        }
+        return false;
+    } else {
+        static_assert(sizeof(T) == 0, "is<T>() not supported by the host ArduinoJson");
+    }
+}
+
+template<class T> T JsonVariant::to() const {
+    HostJson::Node* n = materialize();
+    if (!n) return T();
+    HostJson::reset(n);
+    if (std::is_same<T, JsonObject>::value) n->type = HostJson::OBJECT;
+    if (std::is_same<T, JsonArray>::value) n->type = HostJson::ARRAY;
+    return T(JsonVariant(pool, n));
+}
+
+inline JsonObject JsonVariant::createNestedObject() const { return add().to<JsonObject>(); }
+inline JsonArray JsonVariant::createNestedArray() const { return add().to<JsonArray>(); }
+template<class K> JsonObject JsonVariant::createNestedObject(const K& key) const {
+    return (*this)[key].template to<JsonObject>();
+}
+template<class K> JsonArray JsonVariant::createNestedArray(const K& key) const {
+    return (*this)[key].template to<JsonArray>();
+}
+
+class JsonDocument : public JsonVariant {
+public:
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    size_t capacity() const { return data.capacity; }
+    bool overflowed() const { return data.overflowed; }
+    size_t memoryUsage() const { return data.used; }
+    bool garbageCollect() { return true; }
+    void clear() {
+        data.clear();
+        HostJson::reset(&root);
+    }
+
+    template<class T> JsonDocument& operator=(const T& value) {
+        clear();
+        JsonVariant::set(value);
+        return *this;
+    }
+
+protected:
+    HostJson::Pool data;
+    HostJson::Node root;
+
+    JsonDocument() : JsonVariant(&data, &root) {}
+    void setCapacity(size_t capacity) { data.capacity = capacity; }
+};
+
+struct DefaultAllocator {
+    void* allocate(size_t size) { return malloc(size); }
+    void deallocate(void* ptr) { free(ptr); }
+    void* reallocate(void* ptr, size_t size) { return realloc(ptr, size); }
+};
+
+template<class Allocator>
+class BasicJsonDocument : public JsonDocument, private Allocator {
+public:
+    explicit BasicJsonDocument(size_t capacity, Allocator alloc = Allocator()) : Allocator(alloc) {
+        block = capacity ? this->allocate(capacity) : nullptr;
+        setCapacity(block ? capacity : 0);
+    }
+    BasicJsonDocument(const BasicJsonDocument& src) : BasicJsonDocument(src.capacity()) {
+        set(src);
+    }
+    ~BasicJsonDocument() {
+        if (block) this->deallocate(block);
+    }
+    BasicJsonDocument& operator=(const BasicJsonDocument& src) {
+        clear();
+        set(src);
+        return *this;
+    }
+    template<class T> BasicJsonDocument& operator=(const T& value) {
+        clear();
+        set(value);
+        return *this;
+    }
+
+private:
+    void* block;    // The capacity, as allocated on the device; unused here
+};
+
+typedef BasicJsonDocument<DefaultAllocator> DynamicJsonDocument;
+
+template<size_t N>
+class StaticJsonDocument : public JsonDocument {
+public:
+    StaticJsonDocument() { setCapacity(N); }
+    template<class T> StaticJsonDocument& operator=(const T& value) {
+        clear();
+        set(value);
+        return *this;
+    }
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+    DeserializationError(Code code = Ok) : c(code) {}
+    Code code() const { return c; }
+    explicit operator bool() const { return c != Ok; }
+    bool operator==(Code x) const { return c == x; }
+    bool operator!=(Code x) const { return c != x; }
+    const char* c_str() const {
+        static const char* names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+        return names[c];
+    }
+
+private:
+    Code c;
+};
+
+namespace DeserializationOption {
+struct NestingLimit {
+    explicit NestingLimit(int limit = 10) : value(limit) {}
+    int value;
+};
+} // namespace DeserializationOption
+
+namespace HostJson {
+DeserializationError parse(JsonDocument& doc, const char* input, size_t length, int nestingLimit);
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length,
+                                            DeserializationOption::NestingLimit limit = DeserializationOption::NestingLimit()) {
+    return HostJson::parse(doc, input, length, limit.value);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input,
+                                            DeserializationOption::NestingLimit limit = DeserializationOption::NestingLimit()) {
+    return HostJson::parse(doc, input, input ? strlen(input) : 0, limit.value);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const uint8_t* input, size_t length,
+                                            DeserializationOption::NestingLimit limit = DeserializationOption::NestingLimit()) {
+    return HostJson::parse(doc, (const char*)input, length, limit.value);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input,
+                                            DeserializationOption::NestingLimit limit = DeserializationOption::NestingLimit()) {
+    return HostJson::parse(doc, input.c_str(), input.length(), limit.value);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, Stream& input,
+                                            DeserializationOption::NestingLimit limit = DeserializationOption::NestingLimit()) {
+    std::string text;
+    for (int c; (c = input.read()) >= 0;) text += (char)c;
+    return HostJson::parse(doc, text.data(), text.size(), limit.value);
+}
+
+inline std::string hostJsonText(const JsonVariant& v, int indent = 0) {
+    std::string out;
+    HostJson::write(v.getNode(), out, indent, 0);
+    return out;
+}
+
+inline size_t measureJson(const JsonVariant& v) { return hostJsonText(v).size(); }
+// Strings are appended to, as in ArduinoJson 6
+inline size_t serializeJson(const JsonVariant& v, String& out) {
+    std::string text = hostJsonText(v);
+    out.concat(text.data(), text.size());
+    return text.size();
+}
+inline size_t serializeJson(const JsonVariant& v, std::string& out) {
+    std::string text = hostJsonText(v);
+    out += text;
+    return text.size();
+}
+inline size_t serializeJson(const JsonVariant& v, char* buffer, size_t size) {
+    std::string text = hostJsonText(v);
+    if (!size) return 0;
+    size_t n = text.size() < size - 1 ? text.size() : size - 1;
+    memcpy(buffer, text.data(), n);
+    buffer[n] = '\0';
+    return n;
+}
+inline size_t serializeJson(const JsonVariant& v, Print& out) {
+    std::string text = hostJsonText(v);
+    return out.write((const uint8_t*)text.data(), text.size());
+}
+inline size_t serializeJsonPretty(const JsonVariant& v, String& out) {
+    std::string text = hostJsonText(v, 2);
+    out.concat(text.data(), text.size());
+    return text.size();
+}
+inline size_t serializeJsonPretty(const JsonVariant& v, Print& out) {
+    std::string text = hostJsonText(v, 2);
+    return out.write((const uint8_t*)text.data(), text.size());
+}
+
+#define JSON_OBJECT_SIZE(n) ((n) * 16)
+#define JSON_ARRAY_SIZE(n) ((n) * 16)
+
+#include "HostJsonImpl.h"
@@ -0,0 +1,156 @@
+// Filesystem stand-in: an fs::FS over a directory on the host, so file
+// storage runs against real files. Paths are relative to the root given to
+// the constructor; begin() creates it, like mounting. Like HostFlash, a
+// power cut can be scheduled after a number of bytes: a write in progress
+// stops part way and every later change fails until restorePower().
+// rename() and remove() count as one byte each. With renameReplaces off,
+// rename() fails when the target exists, as on SPIFFS and FAT.
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+namespace fs {
+
+class FS;
+
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* handle, FS* owner, const char* path) : impl(std::make_shared<Impl>(handle, owner, path)) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    size_t read(uint8_t* buffer, size_t size) { return impl ? fread(buffer, 1, size, impl->handle) : 0; }
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    int available() override { return impl ? (int)(size() - position()) : 0; }
+    size_t size() const {
+        if (!impl) return 0;
+        long at = ftell(impl->handle);
+        fseek(impl->handle, 0, SEEK_END);
+        long end = ftell(impl->handle);
+        fseek(impl->handle, at, SEEK_SET);
+        return end;
+    }
+    bool seek(uint32_t pos) { return impl && fseek(impl->handle, pos, SEEK_SET) == 0; }
+    size_t position() const { return impl ? ftell(impl->handle) : 0; }
+    void flush() {
+        if (impl) fflush(impl->handle);
+    }
+    void close() { impl.reset(); }
+    const char* name() const { return impl ? impl->path.c_str() : ""; }
+    bool isDirectory() { return false; }
+    File openNextFile() { return File(); }
+    explicit operator bool() const { return impl != nullptr; }
+
+private:
+    struct Impl {
+        FILE* handle;
+        FS* owner;
+        std::string path;
+        Impl(FILE* handle, FS* owner, const char* path) : handle(handle), owner(owner), path(path) {}
+        ~Impl() { fclose(handle); }
+    };
+    std::shared_ptr<Impl> impl;     // Shared by copies, like the real File
+};
+
+class FS {
+public:
+    bool renameReplaces = true;
+    long cutAfter = -1;         // Bytes until the power fails; -1 = never
+    bool powerLost = false;
+    size_t bytesWritten = 0;    // Including partial writes, renames and removes
+
+    explicit FS(const char* root = "littlefs") : root(root) {}
+
+    bool begin(bool = false) {
+        std::error_code error;
+        std::filesystem::create_directories(root, error);
+        return std::filesystem::is_directory(root, error);
+    }
+    void end() {}
+
+    File open(const char* path, const char* mode = "r") {
+        bool reading = mode[0] == 'r' && mode[1] != '+';
+        if (powerLost && !reading) return File();
+        FILE* handle = fopen(full(path).c_str(), reading ? "rb" : mode[0] == 'a' ? "ab" : "w+b");
+        return handle ? File(handle, this, path) : File();
+    }
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char* path) {
+        std::error_code error;
+        return std::filesystem::exists(full(path), error);
+    }
+    bool exists(const String& path) { return exists(path.c_str()); }
+
+    bool remove(const char* path) {
+        if (!exists(path) || spend(1) != 1) return false;
+        return std::remove(full(path).c_str()) == 0;
+    }
+    bool remove(const String& path) { return remove(path.c_str()); }
+
+    bool rename(const char* from, const char* to) {
+        if (!exists(from) || (!renameReplaces && exists(to)) || spend(1) != 1) return false;
+        return std::rename(full(from).c_str(), full(to).c_str()) == 0;
+    }
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+
+    bool mkdir(const char* path) {
+        if (powerLost) return false;
+        std::error_code error;
+        return std::filesystem::create_directory(full(path), error);
+    }
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+
+    // Test access
+    void restorePower() {
+        cutAfter = -1;
+        powerLost = false;
+    }
+
+    // Deletes everything under the root
+    void wipe() {
+        std::error_code error;
+        std::filesystem::remove_all(root, error);
+        std::filesystem::create_directories(root, error);
+    }
+
+    // Consumes `n` bytes of the power budget; returns how many happen
+    size_t spend(size_t n) {
+        if (powerLost) return 0;
+        if (cutAfter >= 0 && (long)n > cutAfter) {
+            n = cutAfter;
+            cutAfter = 0;
+            powerLost = true;
+        } else if (cutAfter >= 0) {
+            cutAfter -= n;
+        }
+        bytesWritten += n;
+        return n;
+    }
+
+private:
+    std::string root;
+
+    std::string full(const char* path) { return root + (path[0] == '/' ? "" : "/") + path; }
+};
+
+inline size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!impl) return 0;
+    size_t n = fwrite(buffer, 1, impl->owner->spend(size), impl->handle);
+    fflush(impl->handle);   // What was written stays written when the power fails
+    return n;
+}
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,91 @@
+// Simulated SPI flash behind ESP.flashRead/flashWrite/flashEraseSector.
+// Programming can only clear bits, like NOR flash, and every byte written
+// or erased is counted. A power cut can be scheduled after a number of
+// bytes: the operation in progress stops part way and every later one
+// fails until the test "reboots" with restorePower().
+#pragma once
+
+#include <map>
+#include <vector>
+#include "Arduino.h"
+
+struct HostFlash {
+    static const uint32_t SECTOR_SIZE = 4096;
+
+    std::map<uint32_t, std::vector<uint8_t>> sectors;
+    size_t bytesWritten = 0;    // Programmed, including partial writes
+    size_t erases = 0;          // Sector erases started
+    size_t reprograms = 0;      // Bytes programmed without an erase since their last write
+    long cutAfter = -1;         // Bytes (programmed or erased) until the power fails; -1 = never
+    bool powerLost = false;
+
+    std::vector<uint8_t>& sector(uint32_t index) {
+        std::vector<uint8_t>& data = sectors[index];
+        if (data.empty()) data.assign(SECTOR_SIZE, 0xFF);
+        return data;
+    }
+
+    void reset() {
+        sectors.clear();
+        resetCounters();
+        restorePower();
+    }
+
+    void resetCounters() {
+        bytesWritten = 0;
+        erases = 0;
+        reprograms = 0;
+    }
+
+    void restorePower() {
+        cutAfter = -1;
+        powerLost = false;
+    }
+
+    // Consumes `n` bytes of the power budget; returns how many happen
+    size_t spend(size_t n) {
+        if (cutAfter < 0) return n;
+        if ((long)n <= cutAfter) {
+            cutAfter -= n;
+            return n;
+        }
+        n = cutAfter;
+        cutAfter = 0;
+        powerLost = true;
+        return n;
+    }
+
+    bool erase(uint32_t index) {
+        if (powerLost) return false;
+        erases++;
+        std::vector<uint8_t>& data = sector(index);
+        size_t n = spend(SECTOR_SIZE);
+        std::fill(data.begin(), data.begin() + n, 0xFF);
+        return !powerLost;
+    }
+
+    bool write(uint32_t address, const uint8_t* bytes, size_t size) {
+        if (powerLost || address % 4 || size % 4) return false;
+        std::vector<uint8_t>& data = sector(address / SECTOR_SIZE);
+        uint32_t offset = address % SECTOR_SIZE;
+        if (offset + size > SECTOR_SIZE) return false;
+        size_t n = spend(size);
+        for (size_t i = 0; i < n; i++) {
+            if (data[offset + i] != 0xFF) reprograms++;
+            data[offset + i] &= bytes[i];
+        }
+        bytesWritten += n;
+        return !powerLost;
+    }
+
+    bool read(uint32_t address, uint8_t* bytes, size_t size) {
+        if (powerLost || address % 4) return false;
+        std::vector<uint8_t>& data = sector(address / SECTOR_SIZE);
+        uint32_t offset = address % SECTOR_SIZE;
+        if (offset + size > SECTOR_SIZE) return false;
+        memcpy(bytes, &data[offset], size);
+        return true;
+    }
+};
+
+extern HostFlash hostFlash;
@@ -0,0 +1,131 @@
+// FreeRTOS stand-in on std::thread (see freertos/FreeRTOS.h).
+#include "freertos/FreeRTOS.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable changed;
+    unsigned count;
+    unsigned max;
+};
+
+struct HostTask {
+    HostSemaphore notify{{}, {}, 0, 0xFFFFFFFFu};
+    std::thread thread;
+};
+
+namespace {
+
+struct TaskExit {};
+
+thread_local HostTask* currentTask = nullptr;
+
+BaseType_t take(HostSemaphore* s, TickType_t ticksToWait, bool all, uint32_t* taken) {
+    std::unique_lock<std::mutex> lock(s->mutex);
+    auto ready = [s] { return s->count > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+        s->changed.wait(lock, ready);
+    } else if (!s->changed.wait_for(lock, std::chrono::milliseconds(ticksToWait), ready)) {
+        if (taken) *taken = 0;
+        return pdFALSE;
+    }
+    if (taken) *taken = s->count;
+    s->count = all ? 0 : s->count - 1;
+    return pdTRUE;
+}
+
+BaseType_t give(HostSemaphore* s) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->count >= s->max) return pdFALSE;
+    s->count++;
+    s->changed.notify_all();
+    return pdTRUE;
+}
+
+} // namespace
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char*, uint32_t, void* arg,
+                       UBaseType_t, TaskHandle_t* handle) {
+    HostTask* task = new HostTask();
+    if (handle) *handle = task;
+    task->thread = std::thread([task, code, arg] {
+        currentTask = task;
+        try {
+            code(arg);
+        } catch (TaskExit&) {
+        }
+    });
+    // Tasks are never joined: like the device, a task that returns without
+    // vTaskDelete is a bug, and deleted tasks just end their thread
+    task->thread.detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t) {
+    return xTaskCreate(code, name, stackDepth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Only self-deletion is supported; the HostTask is leaked on purpose
+    // because other threads may still hold the handle
+    if (!task || task == currentTask) throw TaskExit();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    uint32_t taken = 0;
+    take(&currentTask->notify, ticksToWait, clearOnExit, &taken);
+    return taken;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    give(&task->notify);
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HostSemaphore{{}, {}, 1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new HostSemaphore{{}, {}, 0, 1};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    return take(semaphore, ticksToWait, false, nullptr);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return give(semaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    auto* lock = reinterpret_cast<std::atomic<int>*>(const_cast<int*>(&mux->locked));
+    int expected = 0;
+    while (!lock->compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+        expected = 0;
+        std::this_thread::yield();
+    }
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+    auto* lock = reinterpret_cast<std::atomic<int>*>(const_cast<int*>(&mux->locked));
+    lock->store(0, std::memory_order_release);
+}
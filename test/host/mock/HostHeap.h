@@ -0,0 +1,25 @@
+// Heap accounting for the host benchmarks. HostHeap.cpp (linked into
+// benchmarks only) counts every block the code under test allocates with
+// new or malloc; mock internals that have no counterpart on the device
+// (the ArduinoJson stand-in's node storage) run under a Pause.
+#pragma once
+
+#include <cstddef>
+
+struct HostHeap {
+    static inline size_t allocations = 0;   // Blocks allocated since reset()
+    static inline size_t liveBlocks = 0;
+    static inline size_t liveBytes = 0;     // Requested sizes, no allocator overhead
+    static inline size_t peakBytes = 0;     // Since reset()
+    static inline int paused = 0;
+
+    struct Pause {
+        Pause() { paused++; }
+        ~Pause() { paused--; }
+    };
+
+    static void reset() {
+        allocations = 0;
+        peakBytes = liveBytes;
+    }
+};
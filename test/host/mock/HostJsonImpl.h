@@ -0,0 +1,303 @@
+// Parser and writer for the host ArduinoJson stand-in (ArduinoJson.h).
+#pragma once
+
+#include <limits>
+
+namespace HostJson {
+
+inline bool deepCopy(Pool* pool, Node* to, const Node* from) {
+    to->type = from->type;
+    to->i = from->i;
+    to->u = from->u;
+    to->f = from->f;
+    to->b = from->b;
+    to->first = to->last = nullptr;
+    if (from->type == STRING) {
+        to->str = pool->copy(from->str, strlen(from->str));
+        return to->str != nullptr;
+    }
+    for (const Node* n = from->first; n; n = n->next) {
+        Node* copy = pool->newNode();
+        if (!copy) return false;
+        if (n->key && !(copy->key = pool->copy(n->key, strlen(n->key)))) return false;
+        append(to, copy);
+        if (!deepCopy(pool, copy, n)) return false;
+    }
+    return true;
+}
+
+inline void writeString(const char* s, std::string& out) {
+    out += '"';
+    for (; *s; s++) {
+        switch (*s) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                if ((uint8_t)*s < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", *s);
+                    out += buf;
+                } else {
+                    out += *s;
+                }
+        }
+    }
+    out += '"';
+}
+
+inline void newline(std::string& out, int indent, int depth) {
+    if (!indent) return;
+    out += '\n';
+    out.append(indent * depth, ' ');
+}
+
+inline void write(const Node* n, std::string& out, int indent, int depth) {
+    if (!n) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    switch (n->type) {
+        case NUL: out += "null"; break;
+        case BOOLEAN: out += n->b ? "true" : "false"; break;
+        case INTEGER: out += std::to_string(n->i); break;
+        case UNSIGNED: out += std::to_string(n->u); break;
+        case FLOAT:
+            if (!std::isfinite(n->f)) {
+                out += "null";
+            } else {
+                snprintf(buf, sizeof(buf), "%.9g", n->f);
+                out += buf;
+            }
+            break;
+        case STRING: writeString(n->str, out); break;
+        case OBJECT:
+        case ARRAY: {
+            bool object = n->type == OBJECT;
+            out += object ? '{' : '[';
+            for (const Node* m = n->first; m; m = m->next) {
+                newline(out, indent, depth + 1);
+                if (object) {
+                    writeString(m->key, out);
+                    out += indent ? ": " : ":";
+                }
+                write(m, out, indent, depth + 1);
+                if (m->next) out += ',';
+            }
+            if (n->first) newline(out, indent, depth);
+            out += object ? '}' : ']';
+            break;
+        }
+    }
+}
+
+class Parser {
+public:
+    Parser(Pool* pool, const char* p, size_t length, int limit)
+        : pool(pool), p(p), end(p + length), limit(limit) {}
+
+    DeserializationError::Code run(Node* root) {
+        skip();
+        if (p >= end) return DeserializationError::EmptyInput;
+        DeserializationError::Code err = value(root, 0);
+        return err;
+    }
+
+private:
+    Pool* pool;
+    const char* p;
+    const char* end;
+    int limit;
+
+    void skip() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    DeserializationError::Code string(const char*& result) {
+        std::string s;
+        {
+            HostHeap::Pause pause;
+            p++;
+            while (true) {
+                if (p >= end || !*p) return DeserializationError::IncompleteInput;
+                char c = *p++;
+                if (c == '"') break;
+                if (c != '\\') {
+                    s += c;
+                    continue;
+                }
+                if (p >= end) return DeserializationError::IncompleteInput;
+                c = *p++;
+                switch (c) {
+                    case 'n': s += '\n'; break;
+                    case 'r': s += '\r'; break;
+                    case 't': s += '\t'; break;
+                    case 'b': s += '\b'; break;
+                    case 'f': s += '\f'; break;
+                    case 'u': {
+                        if (end - p < 4) return DeserializationError::IncompleteInput;
+                        unsigned code = strtoul(std::string(p, 4).c_str(), nullptr, 16);
+                        p += 4;
+                        if (code < 0x80) {
+                            s += (char)code;
+                        } else if (code < 0x800) {
+                            s += (char)(0xC0 | (code >> 6));
+                            s += (char)(0x80 | (code & 0x3F));
+                        } else {
+                            s += (char)(0xE0 | (code >> 12));
+                            s += (char)(0x80 | ((code >> 6) & 0x3F));
+                            s += (char)(0x80 | (code & 0x3F));
+                        }
+                        break;
+                    }
+                    default: s += c;
+                }
+            }
+        }
+        result = pool->copy(s.data(), s.size());
+        HostHeap::Pause pause;
+        s = std::string();
+        return result ? DeserializationError::Ok : DeserializationError::NoMemory;
+    }
+
+    DeserializationError::Code value(Node* n, int depth) {
+        skip();
+        if (p >= end || !*p) return DeserializationError::IncompleteInput;
+        char c = *p;
+        if (c == '{' || c == '[') {
+            if (depth >= limit) return DeserializationError::TooDeep;
+            bool object = c == '{';
+            n->type = object ? OBJECT : ARRAY;
+            p++;
+            skip();
+            if (p < end && *p == (object ? '}' : ']')) {
+                p++;
+                return DeserializationError::Ok;
+            }
+            while (true) {
+                Node* child = pool->newNode();
+                if (!child) return DeserializationError::NoMemory;
+                if (object) {
+                    skip();
+                    if (p >= end || !*p) return DeserializationError::IncompleteInput;
+                    if (*p != '"') return DeserializationError::InvalidInput;
+                    DeserializationError::Code err = string(child->key);
+                    if (err) return err;
+                    skip();
+                    if (p >= end || !*p) return DeserializationError::IncompleteInput;
+                    if (*p++ != ':') return DeserializationError::InvalidInput;
+                }
+                DeserializationError::Code err = value(child, depth + 1);
+                if (err) return err;
+                if (object) {
+                    // Duplicate keys: the last one wins, as in ArduinoJson
+                    Node* existing = member(n, child->key);
+                    if (existing) {
+                        *existing = Node{existing->type, existing->key, existing->next};
+                        Node* keep = existing->next;
+                        *existing = *child;
+                        existing->next = keep;
+                    } else {
+                        append(n, child);
+                    }
+                } else {
+                    append(n, child);
+                }
+                skip();
+                if (p >= end || !*p) return DeserializationError::IncompleteInput;
+                char sep = *p++;
+                if (sep == ',') continue;
+                if (sep == (object ? '}' : ']')) return DeserializationError::Ok;
+                return DeserializationError::InvalidInput;
+            }
+        }
+        if (c == '"') {
+            n->type = STRING;
+            return string(n->str);
+        }
+        if (literal("true")) {
+            n->type = BOOLEAN;
+            n->b = true;
+            return DeserializationError::Ok;
+        }
+        if (literal("false")) {
+            n->type = BOOLEAN;
+            n->b = false;
+            return DeserializationError::Ok;
+        }
+        if (literal("null")) {
+            n->type = NUL;
+            return DeserializationError::Ok;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) return number(n);
+        return DeserializationError::InvalidInput;
+    }
+
+    bool literal(const char* word) {
+        size_t len = strlen(word);
+        if ((size_t)(end - p) < len || strncmp(p, word, len) != 0) return false;
+        p += len;
+        return true;
+    }
+
+    DeserializationError::Code number(Node* n) {
+        const char* start = p;
+        bool isFloat = false;
+        if (*p == '-') p++;
+        while (p < end && (isdigit((uint8_t)*p) || *p == '.' || *p == 'e' || *p == 'E' ||
+                           ((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E')))) {
+            if (*p == '.' || *p == 'e' || *p == 'E') isFloat = true;
+            p++;
+        }
+        char buf[48];
+        size_t len = p - start;
+        if (!len || len >= sizeof(buf)) return DeserializationError::InvalidInput;
+        memcpy(buf, start, len);
+        buf[len] = '\0';
+        char* stop;
+        if (!isFloat) {
+            errno = 0;
+            if (buf[0] == '-') {
+                long long v = strtoll(buf, &stop, 10);
+                if (!errno && *stop == '\0') {
+                    n->type = INTEGER;
+                    n->i = v;
+                    return DeserializationError::Ok;
+                }
+            } else {
+                unsigned long long v = strtoull(buf, &stop, 10);
+                if (!errno && *stop == '\0') {
+                    if (v <= (unsigned long long)std::numeric_limits<long long>::max()) {
+                        n->type = INTEGER;
+                        n->i = (long long)v;
+                    } else {
+                        n->type = UNSIGNED;
+                        n->u = v;
+                    }
+                    return DeserializationError::Ok;
+                }
+            }
+        }
+        double v = strtod(buf, &stop);
+        if (*stop != '\0') return DeserializationError::InvalidInput;
+        n->type = FLOAT;
+        n->f = v;
+        return DeserializationError::Ok;
+    }
+};
+
+inline DeserializationError parse(JsonDocument& doc, const char* input, size_t length, int nestingLimit) {
+    doc.clear();
+    if (!input) return DeserializationError::EmptyInput;
+    Parser parser(doc.getPool(), input, length, nestingLimit);
+    DeserializationError::Code err = parser.run(doc.getNode());
+    if (err) doc.clear();
+    return err;
+}
+
+} // namespace HostJson
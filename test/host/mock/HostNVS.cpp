@@ -0,0 +1,164 @@
+// NVS stand-in (see nvs.h): one map of typed values per namespace. As in
+// NVS, items are found by key and type, so setting a key as another type
+// adds a second item beside the first; nvs_erase_key() removes both.
+#include "nvs.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum Kind { STR, BLOB, I32, U32, U8 };
+
+typedef std::map<Kind, std::vector<uint8_t>> Items;   // One per type
+
+std::mutex lock;
+std::map<std::string, std::map<std::string, Items>> spaces;
+std::vector<std::string> handles;   // nvs_handle_t - 1 indexes the namespace name
+uint32_t commits = 0;
+uint32_t failCommits = 0;
+
+std::map<std::string, Items>* space(nvs_handle_t handle) {
+    if (handle == 0 || handle > handles.size()) return nullptr;
+    return &spaces[handles[handle - 1]];
+}
+
+const std::vector<uint8_t>* find(std::map<std::string, Items>* values, const char* key, Kind kind) {
+    auto it = values->find(key);
+    if (it == values->end()) return nullptr;
+    auto item = it->second.find(kind);
+    return item == it->second.end() ? nullptr : &item->second;
+}
+
+esp_err_t set(nvs_handle_t handle, const char* key, Kind kind, const void* data, size_t length) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto* values = space(handle);
+    if (!values || !key) return ESP_FAIL;
+    const uint8_t* p = (const uint8_t*)data;
+    (*values)[key][kind] = std::vector<uint8_t>(p, p + length);
+    return ESP_OK;
+}
+
+esp_err_t getFixed(nvs_handle_t handle, const char* key, Kind kind, void* out, size_t length) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto* values = space(handle);
+    if (!values) return ESP_FAIL;
+    const std::vector<uint8_t>* bytes = find(values, key, kind);
+    if (!bytes) return ESP_ERR_NVS_NOT_FOUND;
+    memcpy(out, bytes->data(), length);
+    return ESP_OK;
+}
+
+esp_err_t getVariable(nvs_handle_t handle, const char* key, Kind kind, void* out, size_t* length) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto* values = space(handle);
+    if (!values || !length) return ESP_FAIL;
+    const std::vector<uint8_t>* bytes = find(values, key, kind);
+    if (!bytes) return ESP_ERR_NVS_NOT_FOUND;
+    size_t size = bytes->size();
+    if (!out) {
+        *length = size;
+        return ESP_OK;
+    }
+    if (*length < size) return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(out, bytes->data(), size);
+    *length = size;
+    return ESP_OK;
+}
+
+} // namespace
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t, nvs_handle_t* handle) {
+    std::lock_guard<std::mutex> guard(lock);
+    handles.push_back(name);
+    spaces[name];
+    *handle = handles.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t) {}
+
+esp_err_t nvs_commit(nvs_handle_t) {
+    std::lock_guard<std::mutex> guard(lock);
+    commits++;
+    if (failCommits) {
+        failCommits--;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto* values = space(handle);
+    if (!values) return ESP_FAIL;
+    return values->erase(key) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto* values = space(handle);
+    if (!values) return ESP_FAIL;
+    values->clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    return set(handle, key, STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out, size_t* length) {
+    return getVariable(handle, key, STR, out, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    return set(handle, key, BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length) {
+    return getVariable(handle, key, BLOB, out, length);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+    return set(handle, key, I32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out) {
+    return getFixed(handle, key, I32, out, sizeof(*out));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    return set(handle, key, U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out) {
+    return getFixed(handle, key, U32, out, sizeof(*out));
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+    return set(handle, key, U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out) {
+    return getFixed(handle, key, U8, out, sizeof(*out));
+}
+
+uint32_t hostNvsCommits() {
+    std::lock_guard<std::mutex> guard(lock);
+    return commits;
+}
+
+void hostNvsFailCommits(uint32_t count) {
+    std::lock_guard<std::mutex> guard(lock);
+    failCommits = count;
+}
+
+void hostNvsReset() {
+    std::lock_guard<std::mutex> guard(lock);
+    spaces.clear();
+    commits = 0;
+    failCommits = 0;
+}
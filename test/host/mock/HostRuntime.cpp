@@ -0,0 +1,32 @@
+// Globals behind the host stand-ins: the clock, Serial, the simulated
+// flash and radio, and the filesystem objects.
+#include "Arduino.h"
+#include "HostFlash.h"
+#include "HostWiFi.h"
+#include "LittleFS.h"
+
+std::atomic<unsigned long> hostClock(0);
+HardwareSerial Serial;
+EspClass ESP;
+HostFlash hostFlash;
+SimRadio sim;
+WiFiClass WiFi;
+
+size_t HardwareSerial::write(uint8_t c) {
+    static const bool verbose = getenv("HOST_VERBOSE") != nullptr;
+    if (verbose) fputc(c, stdout);
+    return 1;
+}
+
+bool EspClass::flashEraseSector(uint32_t sector) {
+    return hostFlash.erase(sector);
+}
+
+bool EspClass::flashWrite(uint32_t address, uint32_t* data, size_t size) {
+    return hostFlash.write(address, (const uint8_t*)data, size);
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size) {
+    return hostFlash.read(address, (uint8_t*)data, size);
+}
+fs::FS LittleFS;
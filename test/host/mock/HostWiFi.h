@@ -0,0 +1,286 @@
+// Simulated station interface shared by the WiFi.h (ESP32) and
+// ESP8266WiFi.h stand-ins. SimRadio holds the access points in range and
+// models scans, joins and DHCP on the simulated clock; the test moves it
+// forward with sim.step(), which also delivers the driver's events the
+// way the ESP32 event task or the ESP8266 SDK callbacks would.
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+#include "IPAddress.h"
+
+typedef int WiFiEvent_t;
+enum {
+    SYSTEM_EVENT_SCAN_DONE = 1,
+    SYSTEM_EVENT_STA_CONNECTED = 4,
+    SYSTEM_EVENT_STA_DISCONNECTED = 5,
+    SYSTEM_EVENT_STA_GOT_IP = 7
+};
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum { WIFI_SCAN_RUNNING = -1, WIFI_SCAN_FAILED = -2 };
+
+struct WiFiEventStationModeGotIP { IPAddress ip, mask, gw; };
+struct WiFiEventStationModeDisconnected { String ssid; uint8_t reason; };
+struct WiFiEventStationModeConnected { String ssid; uint8_t bssid[6]; uint8_t channel; };
+typedef std::shared_ptr<void> WiFiEventHandler;
+
+struct SimAP {
+    const char* ssid;
+    int rssi;
+    int channel;
+    uint8_t bssid[6];
+};
+
+struct SimRadio {
+    std::vector<SimAP> aps;     // In range now
+
+    // Scans
+    unsigned long scanTime = 2500;
+    bool scanning = false;
+    bool scanned = false;       // Results held by the driver
+    unsigned long scanDoneAt = 0;
+    int scans = 0;
+    int deletes = 0;
+    std::function<void(int)> scanCallback;  // ESP8266 scanNetworksAsync()
+
+    // Association
+    unsigned long joinTime = 3300;      // Driver scans all channels first
+    unsigned long fastJoinTime = 300;   // Channel and BSSID given
+    bool rejectAuth = false;            // AP refuses the password
+    wl_status_t status = WL_DISCONNECTED;
+    wl_status_t pendingStatus = WL_DISCONNECTED;
+    unsigned long joinAt = 0;
+    String joined;
+    int joinedChannel = 0;
+    uint8_t joinedBssid[6] = {0};
+    int begins = 0;
+    int fastBegins = 0;
+
+    // Addressing: a static configuration, or DHCP after dhcpTime
+    bool dhcp = true;
+    unsigned long dhcpTime = 1500;
+    unsigned long ipAt = 0;     // Renewal answered
+    IPAddress ip, gateway, subnet, dns;
+    IPAddress lease[4] = {
+        IPAddress(192, 168, 1, 50), IPAddress(255, 255, 255, 0),
+        IPAddress(192, 168, 1, 1), IPAddress(192, 168, 1, 1)
+    };  // ip, subnet, gateway, dns
+    int configs = 0;
+
+    // Events go out from step() only, like the driver's own task
+    bool events = false;
+    bool gotIPPending = false;
+    bool disconnectPending = false;
+    void (*eventHandler)(WiFiEvent_t) = nullptr;
+    std::function<void(const WiFiEventStationModeGotIP&)> gotIPHandler;
+    std::function<void(const WiFiEventStationModeDisconnected&)> disconnectedHandler;
+
+    void update() {
+        if (scanning && hostClock >= scanDoneAt) {
+            scanning = false;
+            scanned = true;
+        }
+        if (joinAt && hostClock >= joinAt) {
+            // WL_CONNECTED means associated and addressed, on both platforms
+            joinAt = 0;
+            status = pendingStatus;
+            if (status == WL_CONNECTED) {
+                if (dhcp) takeLease();
+                gotIPPending = true;
+            }
+        }
+        if (ipAt && hostClock >= ipAt) {
+            ipAt = 0;
+            if (status == WL_CONNECTED) {
+                takeLease();
+                gotIPPending = true;
+            }
+        }
+    }
+
+    void takeLease() {
+        ip = lease[0];
+        subnet = lease[1];
+        gateway = lease[2];
+        dns = lease[3];
+    }
+
+    // Advances the radio to hostClock and delivers pending events
+    void step() {
+        update();
+        if (scanned && scanCallback) {
+            // The ESP8266 SDK reports the scan from its own context
+            std::function<void(int)> callback = scanCallback;
+            scanCallback = nullptr;
+            callback((int)aps.size());
+        }
+        if (!events) {
+            gotIPPending = disconnectPending = false;
+            return;
+        }
+        if (disconnectPending) {
+            disconnectPending = false;
+            if (eventHandler) eventHandler(SYSTEM_EVENT_STA_DISCONNECTED);
+            if (disconnectedHandler) disconnectedHandler(WiFiEventStationModeDisconnected());
+        }
+        if (gotIPPending && status == WL_CONNECTED) {
+            gotIPPending = false;
+            if (eventHandler) eventHandler(SYSTEM_EVENT_STA_GOT_IP);
+            if (gotIPHandler) gotIPHandler(WiFiEventStationModeGotIP());
+        }
+    }
+
+    void dropLink() {
+        status = WL_CONNECTION_LOST;
+        joinAt = 0;
+        disconnectPending = true;
+        gotIPPending = false;
+        if (dhcp) ip = IPAddress();
+    }
+
+    void begin(const char* ssid, int32_t channel, const uint8_t* bssid) {
+        begins++;
+        if (channel) fastBegins++;
+        joined = ssid;
+        status = WL_DISCONNECTED;
+        pendingStatus = WL_NO_SSID_AVAIL;
+        gotIPPending = false;
+        for (const SimAP& ap : aps) {
+            if (joined == ap.ssid && (!channel || (ap.channel == channel && !memcmp(ap.bssid, bssid, 6)))) {
+                pendingStatus = rejectAuth ? WL_CONNECT_FAILED : WL_CONNECTED;
+                joinedChannel = ap.channel;
+                memcpy(joinedBssid, ap.bssid, 6);
+                break;
+            }
+        }
+        joinAt = hostClock + (channel ? fastJoinTime : joinTime);
+        if (pendingStatus == WL_CONNECTED && dhcp) joinAt += dhcpTime;
+        ipAt = 0;
+        if (dhcp) ip = IPAddress();
+    }
+
+    void config(IPAddress address, IPAddress gw, IPAddress mask, IPAddress dnsServer) {
+        configs++;
+        dhcp = !(uint32_t)address;
+        if (!dhcp) {
+            ip = address;
+            gateway = gw;
+            subnet = mask;
+            dns = dnsServer;
+            ipAt = 0;
+            return;
+        }
+        // Back to DHCP on a live link: the ESP32 drops the address until
+        // the server answers, the ESP8266 keeps using the old one meanwhile
+        if (status != WL_CONNECTED) return;
+        #if defined(ESP32)
+        ip = IPAddress();
+        #endif
+        ipAt = hostClock + dhcpTime;
+    }
+
+    const SimAP* at(uint8_t i) const { return i < aps.size() ? &aps[i] : nullptr; }
+};
+
+extern SimRadio sim;
+
+class WiFiClass {
+public:
+    bool mode(int) { return true; }
+    int getMode() { return WIFI_STA; }
+    bool setAutoReconnect(bool) { return true; }
+    bool persistent(bool) { return true; }
+    bool setHostname(const char*) { return true; }
+
+    int onEvent(void (*handler)(WiFiEvent_t)) {
+        sim.eventHandler = handler;
+        return 0;
+    }
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f) {
+        sim.gotIPHandler = f;
+        return WiFiEventHandler();
+    }
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f) {
+        sim.disconnectedHandler = f;
+        return WiFiEventHandler();
+    }
+
+    int begin(const char* ssid, const char* = nullptr, int32_t channel = 0,
+              const uint8_t* bssid = nullptr, bool = true) {
+        sim.begin(ssid, channel, bssid);
+        return 0;
+    }
+    bool config(IPAddress ip, IPAddress gateway, IPAddress subnet,
+                IPAddress dns = IPAddress(), IPAddress = IPAddress()) {
+        sim.config(ip, gateway, subnet, dns);
+        return true;
+    }
+    bool disconnect(bool = false, bool = false) {
+        sim.status = WL_DISCONNECTED;
+        sim.joinAt = 0;
+        return true;
+    }
+    wl_status_t status() {
+        sim.update();
+        return sim.status;
+    }
+
+    int16_t scanNetworks(bool = false, bool = false) {
+        sim.scans++;
+        sim.scanning = true;
+        sim.scanned = false;
+        sim.scanDoneAt = hostClock + sim.scanTime;
+        return WIFI_SCAN_RUNNING;
+    }
+    void scanNetworksAsync(std::function<void(int)> callback, bool = false) {
+        scanNetworks();
+        sim.scanCallback = callback;
+    }
+    int16_t scanComplete() {
+        sim.update();
+        return sim.scanning ? WIFI_SCAN_RUNNING : sim.scanned ? (int16_t)sim.aps.size() : WIFI_SCAN_FAILED;
+    }
+    void scanDelete() {
+        sim.scanned = false;
+        sim.deletes++;
+    }
+
+    String SSID() { return status() == WL_CONNECTED ? sim.joined : String(); }
+    String SSID(uint8_t i) { return sim.at(i) ? String(sim.at(i)->ssid) : String(); }
+    int32_t RSSI() { return status() == WL_CONNECTED ? -60 : 0; }
+    int32_t RSSI(uint8_t i) { return sim.at(i) ? sim.at(i)->rssi : 0; }
+    uint8_t encryptionType(uint8_t) { return 3; }
+    int32_t channel() { return status() == WL_CONNECTED ? sim.joinedChannel : 0; }
+    int32_t channel(uint8_t i) { return sim.at(i) ? sim.at(i)->channel : 0; }
+    uint8_t* BSSID() { return status() == WL_CONNECTED ? sim.joinedBssid : nullptr; }
+    uint8_t* BSSID(uint8_t i) { return sim.at(i) ? sim.aps[i].bssid : nullptr; }
+    String BSSIDstr() { return String(); }
+
+    IPAddress localIP() { return status() == WL_CONNECTED ? sim.ip : IPAddress(); }
+    IPAddress gatewayIP() { sim.update(); return sim.gateway; }
+    IPAddress subnetMask() { sim.update(); return sim.subnet; }
+    IPAddress dnsIP(uint8_t = 0) { sim.update(); return sim.dns; }
+    String macAddress() { return String("24:0A:C4:00:00:01"); }
+    uint8_t* macAddress(uint8_t* mac) {
+        static const uint8_t address[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+        memcpy(mac, address, 6);
+        return mac;
+    }
+
+    bool softAP(const char*, const char* = nullptr) { return true; }
+    bool softAPConfig(IPAddress, IPAddress, IPAddress) { return true; }
+    bool softAPdisconnect(bool = false) { return true; }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+};
+
+extern WiFiClass WiFi;
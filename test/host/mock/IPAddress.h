@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+    IPAddress() : bytes{0, 0, 0, 0} {}
+    IPAddress(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) : bytes{b0, b1, b2, b3} {}
+    IPAddress(uint32_t address) { memcpy(bytes, &address, 4); }
+
+    operator uint32_t() const {
+        uint32_t address;
+        memcpy(&address, bytes, 4);
+        return address;
+    }
+    uint8_t operator[](int i) const { return bytes[i]; }
+    uint8_t& operator[](int i) { return bytes[i]; }
+    bool operator==(const IPAddress& o) const { return memcmp(bytes, o.bytes, 4) == 0; }
+    bool operator!=(const IPAddress& o) const { return !(*this == o); }
+    bool isSet() const { return (uint32_t)*this != 0; }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+        return String(buf);
+    }
+    bool fromString(const char* text) {
+        unsigned b[4];
+        if (sscanf(text, "%u.%u.%u.%u", &b[0], &b[1], &b[2], &b[3]) != 4) return false;
+        for (int i = 0; i < 4; i++) {
+            if (b[i] > 255) return false;
+            bytes[i] = b[i];
+        }
+        return true;
+    }
+    bool fromString(const String& text) { return fromString(text.c_str()); }
+
+private:
+    uint8_t bytes[4];
+};
@@ -0,0 +1,139 @@
+#!/bin/bash
+#
+# Builds and runs the host tests and benchmarks: library sources compiled
+# for the PC against the stand-ins in mock/ (simulated clock, flash, radio,
+# NVS and FreeRTOS on threads).
+#
+#   test/host/run.sh              # everything
+#   test/host/run.sh eeprom       # names containing "eeprom"
+#
+# Tests run under AddressSanitizer and UBSan (ThreadSanitizer for the
+# threaded ones); benchmarks are built with -O2 and the heap counter, and
+# print their figures. Set HOST_VERBOSE=1 to see the library's log output.
+
+set -e
+
+HERE="$(cd "$(dirname "$0")" && pwd)"
+ROOT="$(cd "$HERE/../.." && pwd)"
+OUT="${HOST_BUILD_DIR:-$ROOT/_host_build}"
+CXX="${CXX:-g++}"
+FILTER="$1"
+
+mkdir -p "$OUT"
+
+COMMON="-std=gnu++17 -g -Wall -Wno-unused-variable -I$HERE/mock -I$HERE -I$ROOT/src -DION_DEBUG=1"
+ESP8266_LINK="-no-pie -Wl,--defsym,_EEPROM_start=0x405FB000 -Wl,--defsym,_FS_end=0x405FA000"
+
+# Library sources that build on the host, and the stand-ins' runtime
+LIB="modules/ConfigManager.cpp modules/ConfigSnapshot.cpp modules/ConfigStream.cpp
+     modules/ConfigTransaction.cpp modules/CommitWorker.cpp modules/NetworkScorer.cpp
+     modules/WiFiConnectionCore.cpp utils/Crypto.cpp utils/JsonPool.cpp utils/Pattern.cpp
+     storage/CachedStorage.cpp storage/EntryTable.cpp storage/StorageEEPROM.cpp
+     storage/StorageLittleFS.cpp storage/StorageNVS.cpp"
+RUNTIME="mock/HostRuntime.cpp mock/HostFreeRTOS.cpp mock/HostNVS.cpp"
+
+FAILED=0
+RAN=0
+
+# flavor: test | bench | tsan
+flags_for() {
+    case "$1" in
+        test)  echo "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer -fno-sanitize-recover=undefined" ;;
+        tsan)  echo "-O1 -fsanitize=thread" ;;
+        bench) echo "-O2" ;;
+    esac
+}
+
+# Compiles the library once per platform and flavor into an archive
+build_lib() {
+    local platform=$1 flavor=$2
+    local lib="$OUT/lib-$platform-$flavor.a"
+    local dir="$OUT/obj-$platform-$flavor"
+    local flags="$COMMON -D$platform $(flags_for "$flavor")"
+    if [ -f "$lib" ] && [ -z "$(find "$ROOT/src" "$HERE/mock" -newer "$lib" -name '*.[ch]*' | head -1)" ]; then
+        return 0
+    fi
+    mkdir -p "$dir"
+    rm -f "$lib" "$dir"/*.o
+    local objs=() src obj
+    for src in $LIB; do
+        local obj="$dir/$(basename "${src%.cpp}").o"
+        "$CXX" $flags -c "$ROOT/src/$src" -o "$obj" &
+        objs+=("$obj")
+    done
+    for src in $RUNTIME; do
+        local obj="$dir/$(basename "${src%.cpp}").o"
+        "$CXX" $flags -c "$HERE/$src" -o "$obj" &
+        objs+=("$obj")
+    done
+    wait
+    ar rcs "$lib" "${objs[@]}"
+}
+
+# run <flavor> <platform> <source> [args...]
+run() {
+    local flavor=$1 platform=$2 src=$3
+    shift 3
+    local name="${src%.cpp}-$platform"
+    if [ -n "$FILTER" ] && [[ "$name" != *"$FILTER"* ]]; then
+        return 0
+    fi
+    build_lib "$platform" "$flavor"
+    local flags="$COMMON -D$platform $(flags_for "$flavor")"
+    local link=""
+    local extra=""
+    [ "$platform" = ESP8266 ] && link="$ESP8266_LINK"
+    if [ "$flavor" = bench ]; then
+        extra="$HERE/HostHeap.cpp"
+        link="$link -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc"
+    fi
+    echo "== $name"
+    RAN=$((RAN + 1))
+    if ! "$CXX" $flags "$HERE/$src" $extra "$OUT/lib-$platform-$flavor.a" $link -lpthread -o "$OUT/$name"; then
+        echo "   build failed"
+        FAILED=$((FAILED + 1))
+        return 0
+    fi
+    if ! (cd "$OUT" && "./$name" "$@"); then
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+cd "$HERE"
+
+run test  ESP32   test_config_values.cpp
+run test  ESP32   test_config_events.cpp
+run test  ESP32   test_config_import.cpp
+run test  ESP32   test_config_transaction.cpp
+run test  ESP32   test_pattern.cpp
+run test  ESP8266 test_eeprom_storage.cpp
+run test  ESP32   test_littlefs_storage.cpp
+run test  ESP32   test_nvs_storage.cpp
+run test  ESP32   test_legacy_migration.cpp
+run test  ESP8266 test_legacy_migration.cpp
+run test  ESP32   test_wifi_reconnect.cpp
+run test  ESP8266 test_wifi_reconnect.cpp
+run test  ESP32   test_wifi_fast_rejoin.cpp
+run test  ESP8266 test_wifi_fast_rejoin.cpp
+run test  ESP32   test_wifi_lease.cpp
+run test  ESP8266 test_wifi_lease.cpp
+run test  ESP32   test_wifi_scoring.cpp
+run test  ESP8266 test_wifi_scoring.cpp
+run test  ESP8266 test_wifi_scan_cache.cpp
+run tsan  ESP32   test_commit_worker.cpp
+run tsan  ESP32   test_wifi_scan_cache.cpp
+run bench ESP32   bench_field_lookup.cpp
+run bench ESP32   bench_pattern.cpp
+run bench ESP32   bench_schema_heap.cpp
+run bench ESP8266 bench_schema_heap.cpp
+run bench ESP8266 bench_config_snapshot.cpp
+run bench ESP8266 bench_eeprom_load.cpp
+run bench ESP8266 bench_entry_table.cpp
+run bench ESP32   bench_network_scoring.cpp
+
+echo
+if [ "$FAILED" -ne 0 ]; then
+    echo "$FAILED of $RAN host test programs failed"
+    exit 1
+fi
+echo "$RAN host test programs passed"
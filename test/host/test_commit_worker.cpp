@@ -0,0 +1,58 @@
+// CommitWorker on a task: requests from the loop and from another task
+// while commits run, and end() returning only once the task has exited.
+// Built with ThreadSanitizer, which reports any unsynchronised access to
+// the worker's state.
+#include <atomic>
+#include <thread>
+#include "HostTest.h"
+#include "modules/CommitWorker.h"
+#include "storage/StorageNVS.h"
+
+using namespace IonConnect;
+
+int main() {
+    StorageNVS storage;
+    CHECK(storage.begin("worker"));
+    std::atomic<int> commits(0);
+    std::atomic<int> failures(0);
+    
+    for (int cycle = 0; cycle < 100; cycle++) {
+        CommitWorker worker(&storage, true);
+        worker.onComplete([&](bool success) {
+            commits++;
+            if (!success) failures++;
+        });
+        CHECK(worker.begin());
+        
+        // A web or BLE handler staging writes on its own task
+        std::thread handler([&] {
+            for (int i = 0; i < 20; i++) {
+                storage.putInt("remote", cycle * 100 + i);
+                worker.request();
+                worker.isBusy();
+            }
+        });
+        for (int i = 0; i < 20; i++) {
+            storage.putInt("local", cycle * 100 + i);
+            worker.request();
+            worker.isBusy();
+        }
+        handler.join();
+        
+        // Everything requested is committed by the time end() returns
+        worker.end();
+        CHECK(!worker.isBusy());
+        
+        StorageNVS reader;
+        CHECK(reader.begin("worker"));
+        CHECK_EQ(reader.getInt("local", -1), cycle * 100 + 19);
+        CHECK_EQ(reader.getInt("remote", -1), cycle * 100 + 19);
+        reader.end();
+    }
+    
+    CHECK(commits > 0);
+    CHECK_EQ(failures, 0);
+    printf("%d commits in 100 start/stop cycles\n", commits.load());
+    
+    return finish("test_commit_worker");
+}
@@ -0,0 +1,68 @@
+// Change events: writes are batched until handle() and coalesced per key,
+// and a callback may set() values and register further subscribers while
+// the batch is being delivered.
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "storage/StorageNVS.h"
+
+using namespace IonConnect;
+
+static const ConfigField TABLE[] = {
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_NUMBER},
+    {"host", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+};
+
+int main() {
+    StorageNVS storage;
+    storage.begin("events");
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(TABLE, 2, "{}"));
+    CHECK(config.load());
+    
+    // A callback that subscribes others (enough to reallocate the list)
+    // and writes another key, registered ahead of the port subscriber
+    int added = 0;
+    int addedEvents = 0;
+    String hostSeen;
+    config.onChange("host", [&](const String& key, const String& value) {
+        for (int i = 0; i < 32; i++) {
+            config.onChange(nullptr, [&](const String& key, const String& value) { addedEvents++; });
+            added++;
+        }
+        hostSeen = value;
+        config.setInt("port", 3000);
+    });
+    
+    // Repeated writes before handle(): one event with the latest value
+    int portEvents = 0;
+    String lastPort;
+    config.onChange("port", [&](const String& key, const String& value) {
+        portEvents++;
+        lastPort = value;
+    });
+    CHECK(config.setInt("port", 1000));
+    CHECK(config.setInt("port", 2000));
+    CHECK_EQ(portEvents, 0);
+    config.handle();
+    CHECK_EQ(portEvents, 1);
+    CHECK(lastPort == "2000");
+    config.handle();
+    CHECK_EQ(portEvents, 1);
+    
+    // The new subscribers start with the next batch, which also carries
+    // the callback's write
+    CHECK(config.set("host", "broker.local"));
+    config.handle();
+    CHECK(hostSeen == "broker.local");
+    CHECK_EQ(added, 32);
+    CHECK_EQ(addedEvents, 0);
+    CHECK_EQ(portEvents, 1);
+    
+    config.handle();
+    CHECK_EQ(portEvents, 2);
+    CHECK(lastPort == "3000");
+    CHECK_EQ(addedEvents, 32);
+    CHECK_EQ(added, 32);
+    
+    return finish("test_config_events");
+}
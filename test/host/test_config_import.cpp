@@ -0,0 +1,96 @@
+// Backup import: every value is validated against its field before any
+// is applied, and a rejected import leaves the config as it was. Values
+// outside the schema are parsed without leaving the JSON pool.
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "storage/StorageNVS.h"
+#include "utils/JsonPool.h"
+
+using namespace IonConnect;
+
+static const ConfigField TABLE[] = {
+    {"host", "", "text", "", "", "[a-z.]+", "", nullptr, 0, 0, 16, 0, 0, true, false, FIELD_TEXT},
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 1, 65535, false, false, FIELD_NUMBER},
+    {"tls", "", "checkbox", "false", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_CHECKBOX},
+    {"secret", "", "password", "", "", "", "", nullptr, 0, 0, 8, 0, 0, false, true, FIELD_PASSWORD},
+};
+
+static String backup(const char* config) {
+    return String("{\"version\":\"1.0\",\"config\":") + config + "}";
+}
+
+int main() {
+    StorageNVS storage;
+    storage.begin("import");
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(TABLE, 4, "{}"));
+    CHECK(config.load());
+    CHECK(config.set("host", "broker.lan"));
+    CHECK(config.set("port", "8883"));
+    CHECK(config.set("secret", "s3cret"));
+    CHECK(config.set("note", "kept"));
+    CHECK(config.flush());
+    
+    const char* invalid[] = {
+        "{\"host\":\"Broker\",\"port\":\"1884\"}",                // Pattern
+        "{\"host\":\"a.very.long.host.name\",\"port\":\"1884\"}", // maxLength
+        "{\"host\":\"b.lan\",\"port\":\"70000\"}",                // max
+        "{\"host\":\"b.lan\",\"port\":\"12ab\"}",                 // Not a number
+        "{\"host\":\"b.lan\",\"tls\":\"maybe\"}",                 // Not a boolean
+        "{\"host\":\"\",\"port\":\"1884\"}",                      // Required, empty
+        "{\"port\":\"1884\"}",                                    // Required, missing, no default
+        "{\"host\":\"b.lan\",\"secret\":\"far-too-long\"}",       // maxLength, plain
+    };
+    for (const char* body : invalid) {
+        CHECK(!config.importJSON(backup(body)));
+        CHECK(config.get("host") == "broker.lan");
+        CHECK_EQ(config.getInt("port"), 8883);
+        CHECK(config.get("secret") == "s3cret");
+        CHECK(config.get("note") == "kept");
+    }
+    
+    // Encrypted values are checked after decryption
+    String longSecret = "enc:" + config.encryptValue("far-too-long");
+    CHECK(!config.importJSON(backup(("{\"host\":\"b.lan\",\"secret\":\"" + longSecret + "\"}").c_str())));
+    CHECK(config.get("host") == "broker.lan");
+    
+    // A round trip through export restores everything
+    String saved = config.exportJSON();
+    CHECK(config.importJSON(backup("{\"host\":\"other.lan\",\"tls\":\"true\",\"extra\":\"x\"}")));
+    CHECK(config.get("host") == "other.lan");
+    CHECK_EQ(config.getInt("port"), 1883);      // Missing: back to the default
+    CHECK(config.getBool("tls"));
+    CHECK(config.get("secret") == "");
+    CHECK(config.get("extra") == "x");
+    CHECK(config.get("note", "gone") == "gone");
+    
+    CHECK(config.importJSON(saved));
+    CHECK(config.get("host") == "broker.lan");
+    CHECK_EQ(config.getInt("port"), 8883);
+    CHECK(config.get("secret") == "s3cret");
+    CHECK(config.get("note") == "kept");
+    CHECK(config.flush());
+    
+    // With every large buffer but one taken, as with ION_JSON_POOL_SLOTS 1:
+    // the staged extras hold the last one, and values outside the schema
+    // lease small buffers instead of the heap
+    {
+        std::vector<PooledJsonDocument*> held;
+        for (int i = 1; i < ION_JSON_POOL_SLOTS; i++) {
+            held.push_back(new PooledJsonDocument(ION_JSON_BUFFER_SIZE));
+        }
+        uint32_t fallbacks = JsonPool::getStats().fallbacks;
+        CHECK(config.importJSON(backup("{\"host\":\"b.lan\",\"note\":\"kept\",\"retries\":3,"
+                                       "\"zones\":[1,2,3],\"owner\":{\"name\":\"ops\"}}")));
+        CHECK_EQ(JsonPool::getStats().fallbacks, fallbacks);
+        CHECK(config.get("note") == "kept");
+        CHECK(config.get("retries") == "3");
+        CHECK(config.get("zones") == "[1,2,3]");
+        CHECK(config.get("owner") == "{\"name\":\"ops\"}");
+        for (PooledJsonDocument* doc : held) {
+            delete doc;
+        }
+    }
+    
+    return finish("test_config_import");
+}
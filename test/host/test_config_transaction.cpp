@@ -0,0 +1,74 @@
+// Transactions: all-or-nothing commits, and failure when the schema is
+// replaced while a transaction is open.
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "storage/StorageNVS.h"
+
+using namespace IonConnect;
+
+static const ConfigField TWO[] = {
+    {"host", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, true, false, FIELD_TEXT},
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 1, 65535, false, false, FIELD_NUMBER},
+};
+
+static const ConfigField ONE[] = {
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 1, 65535, false, false, FIELD_NUMBER},
+};
+
+int main() {
+    StorageNVS storage;
+    storage.begin("tx");
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(TWO, 2, "{}"));
+    CHECK(config.load());
+    
+    {
+        ConfigTransaction tx = config.beginTransaction();
+        CHECK(tx.set("host", "a.lan"));
+        CHECK(tx.set("port", "99999"));
+        CHECK(!tx.commit());
+        CHECK(tx.failedKey() == "port");
+        CHECK(config.get("host") == "");
+    }
+    {
+        ConfigTransaction tx = config.beginTransaction();
+        CHECK(tx.set("host", "a.lan"));
+        CHECK(tx.set("port", "8883"));
+        CHECK(tx.set("note", "x"));
+        CHECK_EQ(tx.size(), 3);
+        CHECK(tx.commit());
+        CHECK(config.get("host") == "a.lan");
+        CHECK_EQ(config.getInt("port"), 8883);
+        CHECK(config.get("note") == "x");
+    }
+    
+    // A schema with fewer fields replaces the one the transaction was
+    // opened under: staged indices would point past the new table
+    {
+        ConfigTransaction tx = config.beginTransaction();
+        CHECK(tx.set("host", "b.lan"));
+        CHECK(config.loadSchema(ONE, 1, "{}"));
+        CHECK(!tx.set("port", "1884"));
+        CHECK(!tx.set("other", "y"));
+        CHECK(!tx.commit());
+        CHECK_EQ(config.getInt("port"), 8883);
+        CHECK(config.get("other", "none") == "none");
+    }
+    
+    // And one with more fields: the side buffer is too small for them
+    {
+        ConfigTransaction tx = config.beginTransaction();
+        CHECK(config.loadSchema(TWO, 2, "{}"));
+        CHECK(!tx.set("port", "1885"));
+        CHECK(!tx.commit());
+        CHECK_EQ(config.getInt("port"), 8883);
+    }
+    {
+        ConfigTransaction tx = config.beginTransaction();
+        CHECK(tx.set("port", "1884"));
+        CHECK(tx.commit());
+        CHECK_EQ(config.getInt("port"), 1884);
+    }
+    
+    return finish("test_config_transaction");
+}
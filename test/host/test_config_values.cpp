@@ -0,0 +1,221 @@
+// Typed setters: setFloat() on number and text fields, including values
+// that must be rejected before they reach the int32_t conversion. Then
+// per-key persistence: a burst of set() calls inside the commit delay is
+// written once, as the records of the changed keys only, and clear()
+// drops the records. Last, records of fields whose type changed between
+// boots are converted to the new type or dropped.
+#include <algorithm>
+#include "HostTest.h"
+#include "modules/ConfigManager.h"
+#include "storage/StorageNVS.h"
+#include "utils/Hash.h"
+
+using namespace IonConnect;
+
+static const ConfigField TABLE[] = {
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_NUMBER},
+    {"level", "", "number", "5", "", "", "", nullptr, 0, 0, 0, 1, 10, false, false, FIELD_NUMBER},
+    {"ratio", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+};
+
+// The same ids under other types
+static const ConfigField BEFORE[] = {
+    {"port", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+    {"level", "", "number", "5", "", "", "", nullptr, 0, 0, 0, 1, 10, false, false, FIELD_NUMBER},
+    {"name", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+    {"debug", "", "checkbox", "false", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_CHECKBOX},
+};
+static const ConfigField AFTER[] = {
+    {"port", "", "number", "1883", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_NUMBER},
+    {"level", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+    {"name", "", "number", "42", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_NUMBER},
+    {"debug", "", "text", "", "", "", "", nullptr, 0, 0, 0, 0, 0, false, false, FIELD_TEXT},
+};
+
+// Records the keys written to storage and counts commits
+struct RecordingStorage : public StorageNVS {
+    std::vector<String> written;
+    int commits = 0;
+    
+    bool putString(const char* key, const String& value) override {
+        written.push_back(key);
+        return StorageNVS::putString(key, value);
+    }
+    bool putInt(const char* key, int value) override {
+        written.push_back(key);
+        return StorageNVS::putInt(key, value);
+    }
+    bool putUInt(const char* key, uint32_t value) override {
+        written.push_back(key);
+        return StorageNVS::putUInt(key, value);
+    }
+    bool putBool(const char* key, bool value) override {
+        written.push_back(key);
+        return StorageNVS::putBool(key, value);
+    }
+    bool putBytes(const char* key, const void* value, size_t len) override {
+        written.push_back(key);
+        return StorageNVS::putBytes(key, value, len);
+    }
+    bool remove(const char* key) override {
+        written.push_back(key);
+        return StorageNVS::remove(key);
+    }
+    bool commit() override {
+        commits++;
+        return StorageNVS::commit();
+    }
+};
+
+static String recordKey(const char* id) {
+    char key[16];
+    snprintf(key, sizeof(key), "f%08lx", (unsigned long)Hash::fnv1a(id));
+    return key;
+}
+
+int main() {
+    StorageNVS storage;
+    storage.begin("values");
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(TABLE, 3, "{}"));
+    CHECK(config.load());
+    
+    // Whole numbers go to number fields as integers
+    CHECK(config.setFloat("port", 8883.0f));
+    CHECK_EQ(config.getInt("port"), 8883);
+    CHECK(!config.setFloat("port", 1.5f));
+    CHECK_EQ(config.getInt("port"), 8883);
+    
+    // Not finite, or outside int32_t: rejected, value unchanged
+    CHECK(!config.setFloat("port", NAN));
+    CHECK(!config.setFloat("port", INFINITY));
+    CHECK(!config.setFloat("port", -INFINITY));
+    CHECK(!config.setFloat("port", 2147483648.0f));
+    CHECK(!config.setFloat("port", 3e9f));
+    CHECK(!config.setFloat("port", -3e9f));
+    CHECK(!config.setFloat("port", 1e30f));
+    CHECK_EQ(config.getInt("port"), 8883);
+    
+    // Limits of the range are accepted
+    CHECK(config.setFloat("port", -2147483648.0f));
+    CHECK_EQ(config.getInt("port"), INT32_MIN);
+    CHECK(config.setFloat("port", 2147483520.0f));     // Largest float below 2^31
+    CHECK_EQ(config.getInt("port"), 2147483520LL);
+    
+    // Schema min/max still apply
+    CHECK(!config.setFloat("level", 11.0f));
+    CHECK(config.setFloat("level", 7.0f));
+    CHECK_EQ(config.getInt("level"), 7);
+    
+    // Text fields and non-schema keys keep the decimal form, never "nan"
+    CHECK(config.setFloat("ratio", 0.25f));
+    CHECK(config.get("ratio") == "0.25");
+    CHECK(!config.setFloat("ratio", NAN));
+    CHECK(config.get("ratio") == "0.25");
+    CHECK(!config.setFloat("extra", INFINITY));
+    CHECK(config.get("extra", "none") == "none");
+    CHECK(config.setFloat("extra", -2.5f));
+    CHECK(config.get("extra") == "-2.5");
+    
+    ConfigHandle port = config.getHandle("port");
+    CHECK(!port.setFloat(NAN));
+    CHECK(port.setFloat(80.0f));
+    CHECK_EQ(port.getInt(), 80);
+    
+    // A burst of writes inside the commit delay: one commit, and only the
+    // records of the keys that changed
+    RecordingStorage recorded;
+    CHECK(recorded.begin("burst"));
+    {
+        ConfigManager burst(&recorded);
+        CHECK(burst.loadSchema(TABLE, 3, "{}"));
+        CHECK(burst.load());
+        CHECK(burst.flush());   // Stores the fingerprint
+        burst.setCommitDelay(1000);
+        recorded.written.clear();
+        recorded.commits = 0;
+        
+        for (int i = 0; i < 10; i++) {
+            CHECK(burst.setInt("port", 1000 + i));
+            CHECK(burst.set("ratio", String(i)));
+            CHECK(burst.save());
+            hostClock += 50;
+            burst.handle();
+        }
+        CHECK(burst.setInt("port", 1009));  // Unchanged
+        CHECK(burst.save());
+        CHECK_EQ(recorded.commits, 0);
+        CHECK(recorded.written.empty());
+        
+        hostClock += 500;
+        burst.handle();
+        CHECK_EQ(recorded.commits, 1);
+        std::sort(recorded.written.begin(), recorded.written.end());
+        std::vector<String> expected = {recordKey("port"), recordKey("ratio")};
+        std::sort(expected.begin(), expected.end());
+        CHECK(recorded.written == expected);
+        CHECK(!burst.isDirty());
+        
+        hostClock += 5000;
+        burst.handle();
+        CHECK_EQ(recorded.commits, 1);
+        CHECK_EQ(recorded.getInt(recordKey("port").c_str()), 1009);
+        CHECK(recorded.getString(recordKey("ratio").c_str()) == "9");
+        CHECK(!recorded.exists(recordKey("level").c_str()));
+        
+        // clear() drops every record; the next boot reads the defaults
+        CHECK(burst.clear());
+        CHECK(!recorded.exists(recordKey("port").c_str()));
+        CHECK(!recorded.exists(recordKey("ratio").c_str()));
+        CHECK_EQ(burst.getInt("port"), 1883);
+    }
+    {
+        ConfigManager reboot(&recorded);
+        CHECK(reboot.loadSchema(TABLE, 3, "{}"));
+        CHECK(reboot.load());
+        CHECK_EQ(reboot.getInt("port"), 1883);
+        CHECK(reboot.get("ratio").isEmpty());
+    }
+    
+    // Field types changed between boots: text to number converts when the
+    // text is a number and is dropped otherwise; numbers and checkboxes
+    // become their text
+    StorageNVS typed;
+    CHECK(typed.begin("types"));
+    {
+        ConfigManager boot(&typed);
+        CHECK(boot.loadSchema(BEFORE, 4, "{}"));
+        CHECK(boot.load());
+        CHECK(boot.set("port", "8080"));
+        CHECK(boot.setInt("level", 7));
+        CHECK(boot.set("name", "kitchen"));
+        CHECK(boot.setBool("debug", true));
+        CHECK(boot.flush());
+    }
+    {
+        ConfigManager boot(&typed);
+        CHECK(boot.loadSchema(AFTER, 4, "{}"));
+        CHECK(boot.load());
+        CHECK_EQ(boot.getInt("port"), 8080);
+        CHECK(boot.get("level") == "7");
+        CHECK_EQ(boot.getInt("name"), 42);
+        CHECK(boot.get("name") == "42");
+        CHECK(boot.get("debug") == "true");
+        CHECK(boot.flush());
+        CHECK_EQ(typed.getInt(recordKey("port").c_str(), -1), 8080);
+        CHECK(typed.getString(recordKey("level").c_str()) == "7");
+        CHECK(!typed.exists(recordKey("name").c_str()));
+        CHECK(typed.getString(recordKey("debug").c_str()) == "true");
+    }
+    {
+        ConfigManager boot(&typed);
+        CHECK(boot.loadSchema(AFTER, 4, "{}"));
+        CHECK(boot.load());
+        CHECK_EQ(boot.getInt("port"), 8080);
+        CHECK(boot.get("level") == "7");
+        CHECK_EQ(boot.getInt("name"), 42);
+        CHECK(boot.get("debug") == "true");
+    }
+    
+    return finish("test_config_values");
+}
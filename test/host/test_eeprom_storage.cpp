@@ -0,0 +1,232 @@
+// StorageEEPROM on the simulated flash: commits program only their own
+// records into the erased tail, sectors are erased on compaction only, and
+// a power cut at any byte of an append or a compaction leaves either the
+// previous commit or the new one.
+#include "HostFlash.h"
+#include "HostTest.h"
+#include "core/IonTypes.h"
+#include "storage/StorageEEPROM.h"
+#include "utils/Hash.h"
+
+using namespace IonConnect;
+
+static bool previousState(StorageEEPROM& s) {
+    return s.getString("ssid") == "home" && s.getInt("n", -1) == 1 && s.getBool("flag") &&
+           s.getString("note", "none") == "kept";
+}
+
+static bool newState(StorageEEPROM& s) {
+    return s.getString("ssid") == "office-2g" && s.getInt("n", -1) == 2 && s.getBool("flag") &&
+           s.getString("note", "none") == "none";
+}
+
+static void seed() {
+    hostFlash.reset();
+    StorageEEPROM s;
+    CHECK(s.begin("ion"));
+    s.putString("ssid", "home");
+    s.putInt("n", 1);
+    s.putBool("flag", true);
+    s.putString("note", "kept");
+    CHECK(s.commit());
+}
+
+// Commits under test: an append (two changes and a removal), and a
+// compaction forced by clear() that leaves the same state
+static void update(StorageEEPROM& s) {
+    s.putString("ssid", "office-2g");
+    s.putInt("n", 2);
+    s.remove("note");
+    s.commit();
+}
+
+static void rewrite(StorageEEPROM& s) {
+    s.clear();
+    s.putString("ssid", "office-2g");
+    s.putInt("n", 2);
+    s.putBool("flag", true);
+    s.commit();
+}
+
+// Bytes programmed and erased by `commit`, from the current flash contents
+static size_t budgetOf(void (*commit)(StorageEEPROM&)) {
+    std::map<uint32_t, std::vector<uint8_t>> before = hostFlash.sectors;
+    hostFlash.resetCounters();
+    {
+        StorageEEPROM s;
+        s.begin("ion");
+        commit(s);
+    }
+    size_t budget = hostFlash.bytesWritten + hostFlash.erases * HostFlash::SECTOR_SIZE;
+    hostFlash.sectors = before;
+    return budget;
+}
+
+// Cuts the power after each byte of `commit`, reboots and checks the
+// outcome; returns how many cuts kept the previous commit
+static int cutEveryByte(void (*commit)(StorageEEPROM&), size_t budget) {
+    std::map<uint32_t, std::vector<uint8_t>> before = hostFlash.sectors;
+    int kept = 0;
+    for (size_t cut = 0; cut <= budget; cut++) {
+        hostFlash.sectors = before;
+        {
+            StorageEEPROM s;
+            s.begin("ion");
+            hostFlash.cutAfter = cut;
+            commit(s);
+        }
+        hostFlash.restorePower();
+        
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        bool previous = previousState(s);
+        bool current = newState(s);
+        if (!previous && !current) {
+            printf("  FAIL cut after %zu bytes: neither commit\n", cut);
+        }
+        CHECK(previous || current);
+        if (cut == budget) {
+            CHECK(current);
+        }
+        kept += previous;
+        
+        // Storage stays usable: a torn tail is compacted away
+        s.putInt("n", 3);
+        CHECK(s.commit());
+        s.end();
+        CHECK(s.begin("ion"));
+        CHECK_EQ(s.getInt("n", -1), 3);
+    }
+    return kept;
+}
+
+int main() {
+    // Bytes programmed per commit
+    seed();
+    {
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        hostFlash.resetCounters();
+        s.putInt("n", 100);
+        CHECK(s.commit());
+        CHECK_EQ(hostFlash.erases, 0);
+        CHECK_EQ(hostFlash.reprograms, 0);
+        CHECK_EQ(hostFlash.bytesWritten, 16);   // 9 + "n" + "100" + crc, padded
+        printf("One int key changed: %zu bytes programmed, %zu sectors erased\n",
+               hostFlash.bytesWritten, hostFlash.erases);
+        
+        hostFlash.resetCounters();
+        update(s);
+        CHECK_EQ(hostFlash.erases, 0);
+        CHECK_EQ(hostFlash.reprograms, 0);
+        printf("Two keys changed and one removed: %zu bytes programmed\n", hostFlash.bytesWritten);
+        
+        // An unchanged value is not written
+        hostFlash.resetCounters();
+        s.putInt("n", 2);
+        CHECK(s.commit());
+        CHECK_EQ(hostFlash.bytesWritten, 0);
+    }
+    
+    // Many commits: erases come from compaction only, nothing is programmed twice
+    seed();
+    {
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        hostFlash.resetCounters();
+        const int commits = 2000;
+        for (int i = 0; i < commits; i++) {
+            s.putInt("n", 1000 + i);
+            CHECK(s.commit());
+        }
+        CHECK_EQ(hostFlash.reprograms, 0);
+        CHECK(hostFlash.erases > 0);
+        CHECK(hostFlash.erases <= commits * 20 / 4096 + 1);
+        printf("%d commits: %.1f bytes programmed per commit, %zu sector erases\n",
+               commits, (double)hostFlash.bytesWritten / commits, hostFlash.erases);
+        s.end();
+        
+        CHECK(s.begin("ion"));
+        CHECK_EQ(s.getInt("n", -1), 1000 + commits - 1);
+        CHECK(s.getString("ssid") == "home");
+        CHECK(s.getString("note") == "kept");
+    }
+    
+    // Power cut at every byte of an append
+    seed();
+    {
+        size_t budget = budgetOf(update);
+        int kept = cutEveryByte(update, budget);
+        CHECK(kept > 0 && kept <= (int)budget);
+        printf("Append cut at each of %zu bytes: %d kept the previous commit, %zu the new one\n",
+               budget + 1, kept, budget + 1 - kept);
+    }
+    
+    // Power cut at every byte of a compaction, erase included
+    seed();
+    {
+        size_t budget = budgetOf(rewrite);
+        CHECK(budget > HostFlash::SECTOR_SIZE);
+        int kept = cutEveryByte(rewrite, budget);
+        CHECK(kept > (int)HostFlash::SECTOR_SIZE);
+        printf("Compaction cut at each of %zu bytes: %d kept the previous commit, %zu the new one\n",
+               budget + 1, kept, budget + 1 - kept);
+    }
+    
+    // A torn append is not built on: the next commit compacts to the other slot
+    seed();
+    {
+        {
+            StorageEEPROM s;
+            s.begin("ion");
+            hostFlash.cutAfter = 10;
+            update(s);
+        }
+        hostFlash.restorePower();
+        hostFlash.resetCounters();
+        StorageEEPROM s;
+        CHECK(s.begin("ion"));
+        CHECK(previousState(s));
+        s.putInt("n", 5);
+        CHECK(s.commit());
+        CHECK_EQ(hostFlash.erases, 1);
+        CHECK_EQ(hostFlash.reprograms, 0);
+        s.end();
+        CHECK(s.begin("ion"));
+        CHECK_EQ(s.getInt("n", -1), 5);
+        CHECK(s.getString("note") == "kept");
+    }
+    
+    // A version 2 image whose conversion fails (power cut) is still loaded,
+    // and the next commit() writes it in the current format
+    hostFlash.reset();
+    {
+        std::vector<uint8_t> image = {0x43, 0x4E, 0x4F, 0x49, 2, 3, 'i', 'o', 'n'};
+        const uint8_t header[] = {0xA5, 1, 0, 0, 0, 1 | 0x80, 4, 4, 0};
+        size_t start = image.size();
+        image.insert(image.end(), header, header + sizeof(header));
+        image.insert(image.end(), {'s', 's', 'i', 'd', 'h', 'o', 'm', 'e'});
+        uint16_t crc = Hash::crc16(&image[start + 1], image.size() - start - 1);
+        image.push_back(crc & 0xFF);
+        image.push_back(crc >> 8);
+        uint32_t eepromSector = 0x3FB; // _EEPROM_start in run.sh
+        memcpy(hostFlash.sector(eepromSector).data(), image.data(), image.size());
+        
+        StorageEEPROM s;
+        hostFlash.cutAfter = 0;
+        CHECK(s.begin("ion"));
+        CHECK(s.getString("ssid") == "home");
+        hostFlash.restorePower();
+        hostFlash.resetCounters();
+        CHECK(s.commit());
+        CHECK(hostFlash.bytesWritten > 0);
+        s.end();
+        
+        hostFlash.resetCounters();
+        CHECK(s.begin("ion"));
+        CHECK(s.getString("ssid") == "home");
+        CHECK_EQ(hostFlash.erases, 0); // Not converted a second time
+    }
+    
+    return finish("test_eeprom_storage");
+}
@@ -0,0 +1,192 @@
+// First boot over the layout older firmware left behind: saved networks as
+// plaintext JSON under `saved_networks` in the config blob, and secrets as
+// `enc:<hex>` text. Every network and secret must come back byte for byte,
+// from the wifi_nets record and raw ciphertext once converted, and a power
+// cut after any write of the conversion must leave all of them readable:
+// the old keys may only go once the new records are stored.
+#include "WiFiHarness.h"
+#include "utils/Crypto.h"
+#include "utils/Hash.h"
+
+using namespace IonConnect;
+
+struct Legacy {
+    const char* ssid;
+    const char* pass;
+    int priority;
+    uint32_t lastConnected;
+    int lastRSSI;
+};
+
+// Quotes, backslashes, UTF-8, spaces and the longest WPA2 passphrase
+static const Legacy NETWORKS[] = {
+    {"home", "correct horse", 2, 7, -48},
+    {"caf\xC3\xA9 \"upstairs\"", "p\\a\"ss\xE2\x82\xAC", 0, 3, -70},
+    {"office-5g", "0123456789012345678901234567890123456789012345678901234567890ab", -1, 0, 0},
+};
+static const char* WIFI_PASS = "s3cr\xC3\xABt \"pass\"\\";
+static const char* MQTT_PASS = "mqtt \xF0\x9F\x94\x91 token";
+
+// Drops every write after the first `budget`, like a power cut part way
+// through the conversion: what was written before it stays
+struct CutStorage : public HostStorage {
+    long budget = -1;       // -1 = never
+    int writes = 0;
+    
+    bool spend() {
+        writes++;
+        if (budget < 0) return true;
+        if (budget == 0) return false;
+        budget--;
+        return true;
+    }
+    bool putString(const char* key, const String& value) override {
+        return !spend() || HostStorage::putString(key, value);
+    }
+    bool putInt(const char* key, int value) override { return !spend() || HostStorage::putInt(key, value); }
+    bool putUInt(const char* key, uint32_t value) override {
+        return !spend() || HostStorage::putUInt(key, value);
+    }
+    bool putBool(const char* key, bool value) override { return !spend() || HostStorage::putBool(key, value); }
+    bool putBytes(const char* key, const void* value, size_t len) override {
+        return !spend() || HostStorage::putBytes(key, value, len);
+    }
+    bool remove(const char* key) override { return !spend() || HostStorage::remove(key); }
+};
+
+static String recordKey(const char* id) {
+    char key[16];
+    snprintf(key, sizeof(key), "f%08lx", (unsigned long)Hash::fnv1a(id));
+    return key;
+}
+
+static void wipe() {
+    #if defined(ESP32)
+    hostNvsReset();
+    #else
+    hostFlash.reset();
+    #endif
+}
+
+// The old layout, written as the old firmware did
+static void seed() {
+    wipe();
+    HostStorage storage;
+    CHECK(storage.begin("wifi"));
+    
+    DynamicJsonDocument list(2048);
+    for (const Legacy& net : NETWORKS) {
+        JsonObject obj = list.createNestedObject();
+        obj["ssid"] = net.ssid;
+        obj["pass"] = net.pass;
+        obj["priority"] = net.priority;
+        obj["lastConnected"] = net.lastConnected;
+        obj["lastRSSI"] = net.lastRSSI;
+    }
+    String networks;
+    serializeJson(list, networks);
+    
+    DynamicJsonDocument blob(2048);
+    blob["saved_networks"] = networks;
+    blob["mqtt_pass"] = "enc:" + Crypto::encrypt(MQTT_PASS);
+    blob["mqtt_host"] = "broker.local";
+    String json;
+    serializeJson(blob, json);
+    
+    CHECK(storage.putString("config_data", json));
+    CHECK(storage.putString(recordKey("wifi_ssid").c_str(), "home"));
+    CHECK(storage.putString(recordKey("wifi_pass").c_str(), "enc:" + Crypto::encrypt(WIFI_PASS)));
+    CHECK(storage.commit());
+}
+
+// One boot: config, then the WiFi core, which converts the networks
+static void boot(HostStorage& storage) {
+    CHECK(storage.begin("wifi"));
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA));
+    config.load();
+    WiFiConnectionCore wifi(&config);
+    wifi.begin();
+    config.flush();
+}
+
+// Every network and secret as seeded; `converted`: in the new layout only
+static bool intact(bool converted) {
+    HostStorage storage;
+    CHECK(storage.begin("wifi"));
+    ConfigManager config(&storage);
+    CHECK(config.loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA));
+    CHECK(config.load());
+    bool ok = config.get("wifi_pass") == WIFI_PASS && config.get("mqtt_pass") == MQTT_PASS &&
+              config.get("mqtt_host") == "broker.local" && config.get("wifi_ssid") == "home";
+    if (converted) {
+        std::vector<uint8_t> record(config.getBytesLength("wifi_nets"));
+        config.getBytes("wifi_nets", record.data(), record.size());
+        ok = ok && config.get("saved_networks", "gone") == "gone" && !record.empty() &&
+             record[0] == 4;    // Not marked as converting
+    }
+    
+    WiFiConnectionCore wifi(&config);
+    wifi.begin();
+    std::vector<WiFiCredential> saved = wifi.getSavedNetworks();
+    ok = ok && saved.size() == sizeof(NETWORKS) / sizeof(NETWORKS[0]);
+    for (size_t i = 0; ok && i < saved.size(); i++) {
+        const Legacy& net = NETWORKS[i];
+        ok = saved[i].ssid == net.ssid && saved[i].password == net.pass && saved[i].priority == net.priority &&
+             saved[i].lastConnected == net.lastConnected && saved[i].lastRSSI == net.lastRSSI;
+    }
+    return ok;
+}
+
+int main() {
+    // Conversion: the networks move to wifi_nets and out of the blob
+    seed();
+    CutStorage storage;
+    boot(storage);
+    int writes = storage.writes;
+    CHECK(writes > 0);
+    CHECK(intact(true));
+    
+    // Secrets stay readable as text until rewritten, then are raw
+    // ciphertext, half the size of the hex
+    {
+        HostStorage raw;
+        CHECK(raw.begin("wifi"));
+        String key = recordKey("wifi_pass");
+        CHECK(raw.getString(key.c_str()).startsWith("enc:"));
+        
+        ConfigManager config(&raw);
+        CHECK(config.loadSchema(DEFAULT_SCHEMA_FIELDS, DEFAULT_SCHEMA_FIELD_COUNT, DEFAULT_SCHEMA));
+        CHECK(config.load());
+        CHECK(config.set("wifi_pass", "rotated-pass"));
+        CHECK(config.set("wifi_pass", WIFI_PASS));
+        CHECK(config.flush());
+        CHECK_EQ(raw.getBytesLength(key.c_str()), strlen(WIFI_PASS));
+    }
+    CHECK(intact(true));
+    
+    // A power cut after each write of the conversion: the next boot still
+    // finds everything, and converts what is left
+    int survived = 0;
+    for (int cut = 0; cut <= writes; cut++) {
+        seed();
+        {
+            CutStorage storage;
+            storage.budget = cut;
+            boot(storage);
+        }
+        bool ok = intact(false);
+        if (!ok) {
+            printf("  cut after %d of %d writes: data lost\n", cut, writes);
+        }
+        CHECK(ok);
+        survived += ok;
+        
+        HostStorage storage;
+        boot(storage);
+        CHECK(intact(true));
+    }
+    printf("Conversion of %d writes, cut after each: %d kept every network and secret\n", writes, survived);
+    
+    return finish("test_legacy_migration");
+}
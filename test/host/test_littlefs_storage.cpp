@@ -0,0 +1,229 @@
+// StorageLittleFS against a directory on the host: values of every type
+// survive a commit and a reload, removals and clear() are persisted, and a
+// power cut at any byte of a commit leaves either the previous or the new
+// contents. On a filesystem whose rename() fails when the target exists,
+// commit() removes the old file first, and a cut between the two steps is
+// recovered from the .tmp at the next begin().
+#include "FS.h"
+#include "HostTest.h"
+#include "core/IonTypes.h"
+#include "storage/StorageLittleFS.h"
+
+using namespace IonConnect;
+
+static fs::FS disk("littlefs_test");
+
+static bool previousState(StorageLittleFS& s) {
+    return s.getString("ssid") == "home" && s.getInt("n", -1) == 1 && s.getBool("flag") &&
+           s.getString("note", "none") == "kept";
+}
+
+static bool newState(StorageLittleFS& s) {
+    return s.getString("ssid") == "office-2g" && s.getInt("n", -1) == 2 && s.getBool("flag") &&
+           s.getString("note", "none") == "none";
+}
+
+static void seed() {
+    disk.restorePower();
+    disk.wipe();
+    StorageLittleFS s(disk);
+    CHECK(s.begin("ion"));
+    s.putString("ssid", "home");
+    s.putInt("n", 1);
+    s.putBool("flag", true);
+    s.putString("note", "kept");
+    CHECK(s.commit());
+}
+
+// The commit under test: two changes and a removal
+static void update(StorageLittleFS& s) {
+    s.putString("ssid", "office-2g");
+    s.putInt("n", 2);
+    s.remove("note");
+    s.commit();
+}
+
+// Bytes written by update(), counting a rename or remove as one
+static size_t budgetOf() {
+    seed();
+    disk.bytesWritten = 0;
+    {
+        StorageLittleFS s(disk);
+        s.begin("ion");
+        update(s);
+    }
+    return disk.bytesWritten;
+}
+
+// Cuts the power after each byte of update(), reboots and checks the
+// outcome; returns how many cuts kept the previous commit
+static int cutEveryByte(size_t budget) {
+    int kept = 0;
+    for (size_t cut = 0; cut <= budget; cut++) {
+        seed();
+        {
+            StorageLittleFS s(disk);
+            s.begin("ion");
+            disk.cutAfter = cut;
+            update(s);
+        }
+        disk.restorePower();
+        
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        bool previous = previousState(s);
+        bool next = newState(s);
+        if (!previous && !next) {
+            printf("  cut after %zu of %zu bytes: neither state\n", cut, budget);
+        }
+        CHECK(previous || next);
+        kept += previous;
+    }
+    return kept;
+}
+
+int main() {
+    // Round trip: every type, read back from the file by a new instance
+    disk.wipe();
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        uint8_t blob[300];
+        for (size_t i = 0; i < sizeof(blob); i++) blob[i] = i * 7;
+        CHECK(s.putString("ssid", "home"));
+        CHECK(s.putString("empty", ""));
+        CHECK(s.putInt("n", -123456));
+        CHECK(s.putUInt("u", 0xFEEDBEEF));
+        CHECK(s.putBool("flag", true));
+        CHECK(s.putBytes("blob", blob, sizeof(blob)));
+        CHECK(s.commit());
+        CHECK(disk.exists("/ionconnect/ion.dat"));
+        CHECK(!disk.exists("/ionconnect/ion.tmp"));
+    }
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(s.getString("ssid") == "home");
+        CHECK(s.exists("empty") && s.getString("empty", "x") == "");
+        CHECK_EQ(s.getInt("n"), -123456);
+        CHECK_EQ(s.getUInt("u"), 0xFEEDBEEF);
+        CHECK(s.getBool("flag"));
+        uint8_t blob[300] = {};
+        CHECK_EQ(s.getBytesLength("blob"), sizeof(blob));
+        CHECK_EQ(s.getBytes("blob", blob, sizeof(blob)), sizeof(blob));
+        bool same = true;
+        for (size_t i = 0; i < sizeof(blob); i++) same = same && blob[i] == (uint8_t)(i * 7);
+        CHECK(same);
+        CHECK_EQ(s.getInt("ssid", 9), 9);      // Typed: a string is not an int
+        
+        // Namespaces are separate files
+        StorageLittleFS other(disk);
+        CHECK(other.begin("other"));
+        CHECK(!other.exists("ssid"));
+        CHECK(other.putString("ssid", "elsewhere"));
+        CHECK(other.commit());
+        CHECK(s.getString("ssid") == "home");
+    }
+    
+    // Tombstones: a removal is persisted, and a key removed and written
+    // again before the commit keeps the new value
+    seed();
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(s.remove("note"));
+        CHECK(!s.exists("note"));
+        CHECK(!s.remove("note"));
+        CHECK(s.remove("flag"));
+        CHECK(s.putBool("flag", true));
+        CHECK(s.commit());
+    }
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(!s.exists("note"));
+        CHECK(s.getBool("flag"));
+        CHECK(s.getString("ssid") == "home");
+        
+        // clear() empties the file at the next commit
+        CHECK(s.clear());
+        CHECK(s.commit());
+    }
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(!s.exists("ssid"));
+    }
+    
+    // Uncommitted changes are written by end()
+    seed();
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        s.putInt("n", 5);
+    }
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK_EQ(s.getInt("n"), 5);
+    }
+    
+    // Power cut at every byte of a commit, rename replacing the old file
+    size_t budget = budgetOf();
+    int kept = cutEveryByte(budget);
+    printf("Commit of %zu bytes, cut at each: %d kept the previous state, %zu the new\n", budget, kept,
+           budget + 1 - kept);
+    CHECK(kept > 0 && kept <= (int)budget);
+    
+    // A filesystem whose rename fails when the target exists: the old file
+    // is removed first
+    disk.renameReplaces = false;
+    seed();
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        File scratch = disk.open("/ionconnect/scratch", "w");
+        scratch.close();
+        CHECK(!disk.rename("/ionconnect/scratch", "/ionconnect/ion.dat"));
+        CHECK(disk.remove("/ionconnect/scratch"));
+        update(s);
+        CHECK(disk.exists("/ionconnect/ion.dat"));
+        CHECK(!disk.exists("/ionconnect/ion.tmp"));
+    }
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(newState(s));
+    }
+    
+    // Power cut between the remove and the rename: only the .tmp is left,
+    // and begin() takes it and renames it into place
+    size_t removeFirst = budgetOf();
+    CHECK_EQ(removeFirst, budget + 1);
+    seed();
+    {
+        StorageLittleFS s(disk);
+        s.begin("ion");
+        disk.cutAfter = removeFirst - 1;
+        update(s);
+    }
+    disk.restorePower();
+    CHECK(!disk.exists("/ionconnect/ion.dat"));
+    CHECK(disk.exists("/ionconnect/ion.tmp"));
+    {
+        StorageLittleFS s(disk);
+        CHECK(s.begin("ion"));
+        CHECK(newState(s));
+        CHECK(disk.exists("/ionconnect/ion.dat"));
+        CHECK(!disk.exists("/ionconnect/ion.tmp"));
+    }
+    
+    kept = cutEveryByte(removeFirst);
+    printf("Same on a filesystem without replacing rename: %d kept, %zu new\n", kept, removeFirst + 1 - kept);
+    CHECK(kept > 0 && kept <= (int)removeFirst);
+    
+    disk.renameReplaces = true;
+    disk.wipe();
+    
+    return finish("test_littlefs_storage");
+}
@@ -0,0 +1,102 @@
+// StorageNVS batching, checked with its write counters and the NVS
+// stand-in: one nvs_commit() per commit(), repeated writes to a key before
+// a commit set the item once, a key written as another type has its old
+// item erased, and the queue is kept for the next commit when nvs_commit()
+// fails.
+#include "HostTest.h"
+#include "core/IonTypes.h"
+#include "nvs.h"
+#include "storage/StorageNVS.h"
+
+using namespace IonConnect;
+
+// Reads straight from NVS, past the queue
+static bool storedString(const char* key, const char* expected) {
+    nvs_handle_t handle;
+    nvs_open("batch", NVS_READONLY, &handle);
+    char value[32];
+    size_t length = sizeof(value);
+    return nvs_get_str(handle, key, value, &length) == ESP_OK && strcmp(value, expected) == 0;
+}
+
+static bool storedInt(const char* key, int32_t expected) {
+    nvs_handle_t handle;
+    nvs_open("batch", NVS_READONLY, &handle);
+    int32_t value;
+    return nvs_get_i32(handle, key, &value) == ESP_OK && value == expected;
+}
+
+int main() {
+    hostNvsReset();
+    StorageNVS storage;
+    CHECK(storage.begin("batch"));
+    
+    // Ten puts, five of them to one key: one nvs_commit() and six items
+    StorageNVS::Stats before = StorageNVS::getStats();
+    uint32_t commits = hostNvsCommits();
+    for (int i = 0; i < 5; i++) {
+        CHECK(storage.putString("ssid", "net" + String(i)));
+        CHECK(storage.putInt(("n" + String(i)).c_str(), i));
+    }
+    CHECK(storage.putBool("flag", true));
+    CHECK(storage.getString("ssid") == "net4");     // Reads see the queue
+    CHECK(!storedString("ssid", "net4"));
+    CHECK(storage.commit());
+    StorageNVS::Stats after = StorageNVS::getStats();
+    CHECK_EQ(hostNvsCommits() - commits, 1);
+    CHECK_EQ(after.commits - before.commits, 1);
+    CHECK_EQ(after.writes - before.writes, 7);
+    CHECK_EQ(after.bytes - before.bytes, 5 + 5 * 4 + 1);
+    CHECK(storedString("ssid", "net4"));
+    CHECK(storedInt("n3", 3));
+    
+    // Nothing queued: no nvs_commit()
+    CHECK(storage.commit());
+    CHECK_EQ(hostNvsCommits() - commits, 1);
+    
+    // The same key as another type: the string item is erased, not left
+    // beside the new one
+    CHECK(storage.putInt("ssid", 7));
+    CHECK(storage.commit());
+    CHECK(storedInt("ssid", 7));
+    nvs_handle_t handle;
+    nvs_open("batch", NVS_READONLY, &handle);
+    size_t length = 0;
+    CHECK_EQ(nvs_get_str(handle, "ssid", nullptr, &length), ESP_ERR_NVS_NOT_FOUND);
+    CHECK_EQ(storage.getInt("ssid"), 7);
+    CHECK(storage.getString("ssid", "none") == "none");
+    
+    // nvs_commit() fails: the writes stay queued, reads still see them, and
+    // the next commit sets them again. A write made in between wins.
+    CHECK(storage.putString("a", "one"));
+    CHECK(storage.putString("b", "two"));
+    storage.remove("n0");
+    hostNvsFailCommits(1);
+    before = StorageNVS::getStats();
+    CHECK(!storage.commit());
+    CHECK(storage.getString("a") == "one");
+    CHECK(!storage.exists("n0"));
+    CHECK(storage.putString("b", "three"));
+    CHECK(storage.commit());
+    after = StorageNVS::getStats();
+    CHECK_EQ(after.commits - before.commits, 2);
+    CHECK_EQ(after.writes - before.writes, 6);
+    CHECK(storedString("a", "one"));
+    CHECK(storedString("b", "three"));
+    CHECK(!storedInt("n0", 0));
+    CHECK(storage.commit());
+    CHECK_EQ(StorageNVS::getStats().commits, after.commits);
+    
+    // A failed commit of clear() keeps the clear queued
+    CHECK(storage.clear());
+    CHECK(storage.putString("kept", "yes"));
+    hostNvsFailCommits(1);
+    CHECK(!storage.commit());
+    CHECK(!storage.exists("a"));
+    CHECK(storage.commit());
+    CHECK(!storedString("a", "one"));
+    CHECK(storedString("kept", "yes"));
+    
+    storage.end();
+    return finish("test_nvs_storage");
+}
@@ -0,0 +1,91 @@
+// Pattern: the supported regex subset, whole-value matching, rejected
+// syntax, and inputs that make backtracking matchers blow up.
+#include "HostTest.h"
+#include "utils/Pattern.h"
+
+using namespace IonConnect;
+
+struct Case {
+    const char* pattern;
+    const char* text;
+    bool matches;
+};
+
+static const char* HOSTNAME = "[a-zA-Z0-9]([a-zA-Z0-9-]{0,61}[a-zA-Z0-9])?(\\.[a-zA-Z0-9]([a-zA-Z0-9-]{0,61}[a-zA-Z0-9])?)*";
+static const char* IPV4 = "^\\d{1,3}(\\.\\d{1,3}){3}$";
+static const char* TOPIC = "[^#+]+(/[^#+]*)*";
+
+static const Case CASES[] = {
+    {"abc", "abc", true},
+    {"abc", "abcd", false},             // Whole value, like HTML pattern
+    {"abc", "xabc", false},
+    {"a|b", "b", true},
+    {"(a|b)*c", "ababc", true},
+    {"(a|b)*c", "abab", false},
+    {"(?:ab)+", "ababab", true},
+    {"x?", "", true},
+    {"a{2,}", "a", false},
+    {"a{2,}", "aaaa", true},
+    {"a{2,3}", "aaaa", false},
+    {"[]a]", "]", true},
+    {"[^0-9]+", "abc", true},
+    {"[^0-9]+", "ab1", false},
+    {"[\\d-]+", "12-3", true},
+    {"\\w+@\\w+\\.com", "joe@x.com", true},
+    {"\\s*\\S+", "  x", true},
+    {"\\D", "5", false},
+    {".", "\n", false},
+    {IPV4, "192.168.4.1", true},
+    {IPV4, "192.168.4", false},
+    {IPV4, "1921.168.4.1", false},
+    {HOSTNAME, "my-host.local", true},
+    {HOSTNAME, "-bad", false},
+    {HOSTNAME, "bad-.local", false},
+    {TOPIC, "home/sensor/temp", true},
+    {TOPIC, "home/#", false},
+    {TOPIC, "home/+/temp", false},
+    {"(a*)*b", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaac", false},
+    {"(a|aa)*c", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", false},
+};
+
+int main() {
+    for (const Case& c : CASES) {
+        Pattern p;
+        CHECK(p.compile(c.pattern));
+        if (p.matches(c.text) != c.matches) {
+            printf("  pattern %s on \"%s\"\n", c.pattern, c.text);
+            CHECK(false);
+        }
+    }
+    
+    // Not compiled: matches anything, as validation of a field without one
+    Pattern none;
+    CHECK(!none.isCompiled());
+    CHECK(none.matches("anything"));
+    
+    // Unsupported or malformed syntax is rejected at compile time
+    const char* invalid[] = {"(?=a)", "(?!a)", "a{2", "(ab", "ab)", "[ab", "\\1", "*a"};
+    for (const char* pattern : invalid) {
+        Pattern p;
+        if (p.compile(pattern)) {
+            printf("  compiled: %s\n", pattern);
+            CHECK(false);
+        }
+    }
+    
+    // Programs are capped at MAX_PROGRAM instructions
+    Pattern big;
+    CHECK(!big.compile("(abcdefghij){30}"));
+    CHECK(!big.isCompiled());
+    
+    // Long input: linear, no recursion on the input
+    String text;
+    for (int i = 0; i < 20000; i++) text += 'a';
+    Pattern p;
+    CHECK(p.compile("(a|aa)*b"));
+    CHECK(!p.matches(text.c_str()));
+    CHECK(p.compile("(a|aa)*"));
+    CHECK(p.matches(text.c_str()));
+    
+    return finish("test_pattern");
+}
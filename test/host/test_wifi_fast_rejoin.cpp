@@ -0,0 +1,104 @@
+// Joins with the cached channel and BSSID: a dropped link and a cold boot
+// rejoin without scanning, an AP that moved costs one scan, and an AP that
+// refuses the password ends in the portal fallback instead of alternating
+// cached joins and scans.
+#include "WiFiHarness.h"
+
+using namespace IonConnect;
+
+static const WiFiCredential* saved(std::vector<WiFiCredential>& nets, const char* ssid) {
+    for (const WiFiCredential& net : nets) {
+        if (net.ssid == ssid) return &net;
+    }
+    return nullptr;
+}
+
+int main() {
+    WiFiHarness host;
+    sim.aps = {{"office", -55, 11, {0xB0, 1}}};
+    
+    {
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.begin());
+        CHECK(wifi.connect("office", "password2"));
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        
+        // The association was recorded
+        std::vector<WiFiCredential> nets = wifi.getSavedNetworks();
+        const WiFiCredential* office = saved(nets, "office");
+        CHECK(office && office->channel == 11 && office->bssid[0] == 0xB0);
+        
+        // Link lost with the AP still there: rejoined directly
+        host.run(wifi, 61000);
+        int scans = sim.scans;
+        int fast = sim.fastBegins;
+        sim.dropLink();
+        host.tick(wifi);
+        unsigned long took = 10 + host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        CHECK_EQ(sim.scans, scans);
+        CHECK_EQ(sim.fastBegins, fast + 1);
+        printf("Rejoin with cached BSSID: %lu ms\n", took);
+        wifi.end();
+    }
+    
+    {
+        // Cold boot: a new instance loads the cache and connect() skips the scan
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.begin());
+        int scans = sim.scans;
+        int fast = sim.fastBegins;
+        CHECK(wifi.connect("office", "password2"));
+        unsigned long took = host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        CHECK_EQ(sim.scans, scans);
+        CHECK_EQ(sim.fastBegins, fast + 1);
+        printf("Boot connect with cached BSSID: %lu ms\n", took);
+        
+        // AP moved to another channel: the cached join fails, one scan finds
+        // it, and both joins are in the history
+        host.run(wifi, 61000);
+        std::vector<WiFiCredential> nets = wifi.getSavedNetworks();
+        const WiFiCredential* office = saved(nets, "office");
+        uint8_t attempts = office ? office->attempts : 0;
+        uint8_t successes = office ? office->successes : 0;
+        sim.aps = {{"office", -50, 6, {0xB0, 2}}};
+        sim.dropLink();
+        host.tick(wifi);
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        CHECK_EQ(sim.scans, scans + 1);
+        CHECK_EQ(sim.joinedChannel, 6);
+        nets = wifi.getSavedNetworks();
+        office = saved(nets, "office");
+        CHECK(office && office->channel == 6 && office->bssid[1] == 2);
+        CHECK(office && office->attempts == attempts + 2 && office->successes == successes + 1);
+        
+        // Password rejected: each attempt makes at most one fallback scan,
+        // and the attempts run out into the portal
+        int fallbacks = 0;
+        wifi.onPortalFallback([&] { fallbacks++; });
+        host.run(wifi, 61000);
+        sim.rejectAuth = true;
+        scans = sim.scans;
+        fast = sim.fastBegins;
+        sim.dropLink();
+        host.tick(wifi);
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_PORTAL_FALLBACK; }, 600000);
+        CHECK(wifi.getState() == WIFI_PORTAL_FALLBACK);
+        CHECK_EQ(fallbacks, 1);
+        CHECK_EQ(sim.fastBegins, fast + 1);
+        CHECK(sim.scans - scans <= 6);  // One per attempt: 5 reconnects
+        nets = wifi.getSavedNetworks();
+        office = saved(nets, "office");
+        CHECK(office && office->failStreak == 1 + sim.scans - scans);  // Every join failed
+        printf("Rejected password: %d scans, %d cached joins before the portal\n", sim.scans - scans,
+               sim.fastBegins - fast);
+        wifi.end();
+    }
+    
+    CHECK_EQ(host.worstBlocked, 0);
+    
+    return finish("test_wifi_fast_rejoin");
+}
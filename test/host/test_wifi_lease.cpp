@@ -0,0 +1,118 @@
+// Cached DHCP leases with the driver's events on: the first connect caches
+// the lease, a reconnect applies it before joining, and the renewal in the
+// background stores the lease from the got-IP event, not the address the
+// interface still shows. Also a renewal that never completes, and static
+// addresses.
+#include "WiFiHarness.h"
+
+using namespace IonConnect;
+
+int main() {
+    WiFiHarness host;
+    sim.events = true;
+    sim.aps = {{"lab", -50, 3, {0xC0, 1}}};
+    
+    WiFiConnectionCore wifi(&host.config);
+    CHECK(wifi.begin());
+    int connects = 0;
+    int disconnects = 0;
+    wifi.onConnect([&] { connects++; });
+    wifi.onDisconnect([&] { disconnects++; });
+    auto online = [&] { return wifi.getState() == WIFI_CONNECTED && (uint32_t)WiFi.localIP() != 0; };
+    
+    // First connect runs DHCP and caches the lease
+    CHECK(wifi.addNetwork("lab", "password3", 0));
+    CHECK(wifi.setNetworkIP("lab", IP_CACHED_LEASE));
+    CHECK(!wifi.setNetworkIP("nope", IP_STATIC));
+    CHECK(wifi.connect("lab", "password3"));
+    unsigned long took = host.runUntil(wifi, online);
+    host.tick(wifi);
+    printf("First connect (DHCP): %lu ms\n", took);
+    std::vector<WiFiCredential> nets = wifi.getSavedNetworks();
+    CHECK(nets.size() == 1 && nets[0].ipMode == IP_CACHED_LEASE);
+    CHECK(nets[0].ipSettings.ip == sim.lease[0]);
+    CHECK(nets[0].ipSettings.subnet == sim.lease[1]);
+    CHECK(nets[0].ipSettings.gateway == sim.lease[2]);
+    
+    // Reconnect: the lease is applied before joining, no DHCP wait
+    int configs = sim.configs;
+    sim.dropLink();
+    host.tick(wifi);
+    took = 10 + host.runUntil(wifi, online);
+    printf("Reconnect on the cached lease: %lu ms\n", took);
+    CHECK(took < 1000);
+    CHECK_EQ(sim.configs, configs + 1);
+    CHECK(!sim.dhcp && sim.ip == sim.lease[0]);
+    
+    // Renewal after LEASE_CONFIRM_DELAY: DHCP hands out a new address and
+    // the link stays up. Until the server answers, the ESP8266 still shows
+    // the cached address and the ESP32 none; neither is the new lease.
+    sim.lease[0] = IPAddress(192, 168, 1, 77);
+    connects = 0;
+    disconnects = 0;
+    bool down = false;
+    for (int i = 0; i < 3500; i++) {
+        host.tick(wifi);
+        down = down || wifi.getState() != WIFI_CONNECTED;
+        nets = wifi.getSavedNetworks();
+        CHECK(nets[0].ipSettings.ip == IPAddress(192, 168, 1, 50) || nets[0].ipSettings.ip == sim.lease[0]);
+    }
+    CHECK(!down);
+    CHECK(sim.dhcp && sim.ip == sim.lease[0]);
+    CHECK_EQ(connects, 0);
+    CHECK_EQ(disconnects, 0);
+    nets = wifi.getSavedNetworks();
+    CHECK(nets[0].ipSettings.ip == IPAddress(192, 168, 1, 77));
+    
+    // The link lost during a renewal: the disconnect event ends it at once,
+    // although the status may report down while DHCP runs
+    sim.dropLink();
+    host.tick(wifi);
+    host.runUntil(wifi, online);
+    host.run(wifi, 30500);  // Renewing: DHCP answers after 1.5 s
+    disconnects = 0;
+    sim.dropLink();
+    host.tick(wifi);
+    CHECK(wifi.getState() == WIFI_RECONNECTING);
+    CHECK_EQ(disconnects, 1);
+    nets = wifi.getSavedNetworks();
+    CHECK(nets[0].ipSettings.ip == sim.lease[0]);
+    
+    // A renewal that never completes: reconnect and forget the lease
+    sim.dropLink();
+    host.tick(wifi);
+    host.runUntil(wifi, online);
+    CHECK(!sim.dhcp);
+    sim.dhcpTime = 1000000;
+    disconnects = 0;
+    host.run(wifi, 30000 + 11000);
+    CHECK_EQ(disconnects, 1);
+    nets = wifi.getSavedNetworks();
+    CHECK(!nets[0].ipSettings.isSet());
+    sim.dhcpTime = 1500;
+    
+    // Static addresses, then back to DHCP
+    IPSettings fixed;
+    fixed.ip = IPAddress(10, 0, 0, 9);
+    fixed.gateway = IPAddress(10, 0, 0, 1);
+    fixed.subnet = IPAddress(255, 0, 0, 0);
+    CHECK(wifi.setNetworkIP("lab", IP_STATIC, fixed));
+    CHECK(wifi.connect("lab", "password3"));
+    host.runUntil(wifi, online);
+    CHECK(!sim.dhcp && WiFi.localIP() == IPAddress(10, 0, 0, 9));
+    CHECK(wifi.setNetworkIP("lab", IP_DHCP));
+    CHECK(wifi.connect("lab", "password3"));
+    host.runUntil(wifi, online);
+    CHECK(sim.dhcp && WiFi.localIP() == sim.lease[0]);
+    
+    // Defaults apply to IP_DEFAULT networks
+    CHECK(wifi.setNetworkIP("lab", IP_DEFAULT));
+    wifi.setIPDefaults(IP_STATIC, fixed);
+    CHECK(wifi.connect("lab", "password3"));
+    host.runUntil(wifi, online);
+    CHECK(!sim.dhcp && WiFi.localIP() == IPAddress(10, 0, 0, 9));
+    
+    CHECK_EQ(host.worstBlocked, 0);
+    
+    return finish("test_wifi_lease");
+}
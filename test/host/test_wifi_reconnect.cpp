@@ -0,0 +1,102 @@
+// Reconnection on the simulated clock: a lost link is recovered by a scan
+// and a join driven from handle(), an empty neighbourhood ends in a single
+// portal fallback, a scan that never completes times out, and no handle()
+// call waits on the radio.
+#include "WiFiHarness.h"
+
+using namespace IonConnect;
+
+int main() {
+    WiFiHarness host;
+    WiFiConnectionCore wifi(&host.config);
+    CHECK(wifi.begin());
+    int fallbacks = 0;
+    wifi.onPortalFallback([&] { fallbacks++; });
+    
+    CHECK(wifi.addNetwork("home", "password1", 10));
+    CHECK(wifi.addNetwork("office", "password2", 0));
+    sim.aps = {{"cafe", -40, 1, {0xA0, 9}}, {"home", -70, 6, {0xA0, 1}}, {"office", -55, 11, {0xB0, 1}}};
+    CHECK(wifi.connect("home", "password1"));
+    host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+    CHECK(wifi.getState() == WIFI_CONNECTED);
+    CHECK(sim.joined == "home");
+    
+    // Link lost and home gone: one scan from handle(), then office
+    sim.dropLink();
+    sim.aps = {{"cafe", -40, 1, {0xA0, 9}}, {"office", -55, 11, {0xB0, 1}}};
+    int scans = sim.scans;
+    bool scanned = false;
+    host.tick(wifi);
+    unsigned long took = 10 + host.runUntil(wifi, [&] {
+        scanned = scanned || wifi.getState() == WIFI_SCANNING;
+        return wifi.getState() == WIFI_CONNECTED;
+    });
+    CHECK(scanned);
+    CHECK_EQ(sim.scans, scans + 1);
+    CHECK(wifi.getState() == WIFI_CONNECTED);
+    CHECK(sim.joined == "office");
+    printf("Reconnect to another network: %lu ms\n", took);
+    
+    // Stored priorities are untouched by reconnects
+    for (const WiFiCredential& net : wifi.getSavedNetworks()) {
+        CHECK_EQ(net.priority, net.ssid == "home" ? 10 : 0);
+    }
+    
+    // Storm: nothing in range, every attempt comes back empty
+    sim.dropLink();
+    sim.aps.clear();
+    host.run(wifi, 200000);
+    CHECK_EQ(fallbacks, 1);
+    CHECK(wifi.getState() == WIFI_PORTAL_FALLBACK);
+    
+    // A scan that never completes times out instead of holding WIFI_SCANNING
+    sim.scanTime = 1000000;
+    sim.aps = {{"office", -50, 11, {0xB0, 1}}};
+    CHECK(wifi.connectToBest());
+    CHECK(wifi.getState() == WIFI_SCANNING);
+    host.run(wifi, 11000);
+    CHECK(wifi.getState() != WIFI_SCANNING);
+    
+    // The radio recovers: the next attempt scans again and connects
+    sim.scanning = false;
+    sim.scanTime = 2000;
+    scans = sim.scans;
+    CHECK(wifi.connectToBest());
+    CHECK_EQ(sim.scans, scans + 1);
+    host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+    CHECK(wifi.getState() == WIFI_CONNECTED);
+    CHECK(sim.joined == "office");
+    
+    // With the driver's events on, handle() still makes the changes: a drop
+    // within STABLE_CONNECTION counts against the network, and each
+    // callback runs once
+    sim.events = true;
+    int connects = 0;
+    int disconnects = 0;
+    wifi.onConnect([&] { connects++; });
+    wifi.onDisconnect([&] { disconnects++; });
+    host.run(wifi, 5000);
+    std::vector<WiFiCredential> nets = wifi.getSavedNetworks();
+    const WiFiCredential* office = nets[0].ssid == "office" ? &nets[0] : &nets[1];
+    uint8_t successes = office->successes;
+    uint8_t failStreak = office->failStreak;
+    sim.dropLink();
+    host.tick(wifi);
+    CHECK(wifi.getState() == WIFI_RECONNECTING);
+    CHECK_EQ(disconnects, 1);
+    nets = wifi.getSavedNetworks();
+    office = nets[0].ssid == "office" ? &nets[0] : &nets[1];
+    CHECK_EQ(office->successes, successes - 1);
+    CHECK_EQ(office->failStreak, failStreak + 1);
+    host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+    CHECK(wifi.getState() == WIFI_CONNECTED);
+    CHECK_EQ(connects, 1);
+    CHECK_EQ(disconnects, 1);
+    
+    // No call waited: every state change above came from later handle() calls
+    CHECK_EQ(host.worstBlocked, 0);
+    CHECK(host.worstMicros < 1000);
+    printf("Worst handle(): %.1f us wall, %lu ms simulated\n", host.worstMicros, host.worstBlocked);
+    
+    return finish("test_wifi_reconnect");
+}
@@ -0,0 +1,114 @@
+// Scan cache: results merged by BSSID with averaged RSSI, served without
+// rescanning while fresh, and refreshed in the background once stale. Scan
+// requests only take effect from handle(). On the ESP32 a second thread
+// stands in for the web server and BLE tasks, reading the cache and asking
+// for scans while handle() merges; built with ThreadSanitizer.
+#include "WiFiHarness.h"
+#if defined(ESP32)
+#include <atomic>
+#include <thread>
+#endif
+
+using namespace IonConnect;
+
+static const NetworkInfo* find(const std::vector<NetworkInfo>& results, const char* ssid) {
+    for (const NetworkInfo& info : results) {
+        if (info.ssid == ssid) return &info;
+    }
+    return nullptr;
+}
+
+int main() {
+    WiFiHarness host;
+    sim.aps = {{"home", -70, 6, {0xA0, 1}}, {"office", -55, 11, {0xB0, 1}}, {"cafe", -80, 1, {0xC0, 1}}};
+    WiFiConnectionCore wifi(&host.config);
+    CHECK(wifi.begin());
+    
+    // Nothing cached: an empty list and a request, served by handle()
+    CHECK(wifi.getScanResults().empty());
+    CHECK_EQ(wifi.getScanAge(), UINT32_MAX);
+    CHECK_EQ(sim.scans, 0);
+    host.tick(wifi);
+    CHECK_EQ(sim.scans, 1);
+    host.run(wifi, 3000);
+    std::vector<NetworkInfo> results = wifi.getScanResults();
+    CHECK_EQ(results.size(), 3);
+    CHECK(results.size() == 3 && results[0].ssid == "office" && results[2].ssid == "cafe");
+    CHECK_EQ(sim.deletes, 1);  // The driver's copy is freed after the merge
+    
+    // Fresh: served from the cache
+    host.run(wifi, 10000);
+    results = wifi.getScanResults();
+    host.tick(wifi);
+    CHECK_EQ(sim.scans, 1);
+    CHECK(wifi.getScanAge() >= 10000 && wifi.getScanAge() < 20000);
+    
+    // Readings are averaged over scans; an AP missing from one scan stays
+    sim.aps = {{"home", -50, 6, {0xA0, 1}}, {"office", -55, 11, {0xB0, 1}}};
+    CHECK(wifi.startScan());
+    CHECK_EQ(sim.scans, 1);
+    host.run(wifi, 3000);
+    CHECK_EQ(sim.scans, 2);
+    results = wifi.getScanResults();
+    CHECK(find(results, "home") && find(results, "home")->rssi == -60);
+    CHECK(find(results, "cafe") != nullptr);
+    
+    // Stale after SCAN_CACHE_TTL: the next read asks for a background scan,
+    // and an AP unseen for SCAN_ENTRY_TTL is dropped
+    host.run(wifi, 31000);
+    results = wifi.getScanResults();
+    CHECK_EQ(results.size(), 3);
+    host.run(wifi, 3000);
+    CHECK_EQ(sim.scans, 3);
+    host.run(wifi, 31000);
+    wifi.getScanResults();
+    host.run(wifi, 3000);
+    CHECK_EQ(sim.scans, 4);
+    results = wifi.getScanResults();
+    CHECK_EQ(results.size(), 2);
+    CHECK(find(results, "cafe") == nullptr);
+    
+    // No scan while a join is in progress: the request waits for handle()
+    // to find the join over
+    CHECK(wifi.addNetwork("office", "password2", 0));
+    CHECK(wifi.connect("office", "password2"));
+    CHECK(wifi.startScan());
+    host.tick(wifi);
+    CHECK_EQ(sim.scans, 4);
+    host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+    host.tick(wifi);
+    CHECK_EQ(sim.scans, 5);
+    
+    #if defined(ESP32)
+    // Readers on another task while scans complete and merge
+    host.run(wifi, 5000);
+    std::atomic<bool> done(false);
+    std::atomic<long> reads(0);
+    std::thread reader([&] {
+        while (!done) {
+            std::vector<NetworkInfo> copy = wifi.getScanResults();
+            for (const NetworkInfo& info : copy) {
+                if (info.ssid.isEmpty() || info.rssi > 0) reads = -1000000;
+            }
+            wifi.getScanAge();
+            if (reads % 16 == 0) wifi.startScan();
+            reads++;
+        }
+    });
+    int scans = sim.scans;
+    for (int i = 0; i < 20; i++) {
+        sim.aps[0].rssi = -40 - i;
+        wifi.startScan();
+        host.run(wifi, 3000);
+    }
+    done = true;
+    reader.join();
+    CHECK(reads > 0);
+    CHECK(sim.scans - scans >= 20);
+    printf("%ld reads on another thread during %d scans\n", reads.load(), sim.scans - scans);
+    #endif
+    
+    CHECK_EQ(host.worstBlocked, 0);
+    
+    return finish("test_wifi_scan_cache");
+}
@@ -0,0 +1,95 @@
+// Network scoring: WeightedScoringPolicy's terms, the connection history
+// kept in the saved record, and hysteresis in favour of the network joined
+// last, including one joined in an earlier boot.
+#include "WiFiHarness.h"
+
+using namespace IonConnect;
+
+int main() {
+    WiFiHarness host;
+    
+    // History and priority move the score; no history is neutral
+    WeightedScoringPolicy weighted;
+    NetworkInfo seen;
+    seen.rssi = -70;
+    WiFiCredential fresh("x", "p");
+    CHECK_EQ(weighted.score(fresh, seen), -70);
+    WiFiCredential flaky("x", "p");
+    flaky.attempts = 4;
+    flaky.successes = 1;
+    flaky.failStreak = 2;
+    flaky.lastFailure = millis();
+    CHECK_EQ(weighted.score(flaky, seen), -70 - 22 - 20);
+    hostClock += ScoringPolicy::FAILURE_WINDOW + 1;
+    CHECK_EQ(weighted.score(flaky, seen), -70 - 22);
+    WiFiCredential slow("x", "p", 5);
+    slow.connectTime = 9000;
+    CHECK_EQ(weighted.score(slow, seen), -70 + 10 - 10);
+    
+    // The history survives a save
+    sim.aps = {{"alpha", -62, 1, {0xA1}}, {"beta", -60, 6, {0xB1}}};
+    {
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.begin());
+        CHECK(wifi.addNetwork("alpha", "password1", 0));
+        CHECK(wifi.connect("beta", "password2"));
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        wifi.end();
+    }
+    {
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.loadNetworks());
+        std::vector<WiFiCredential> nets = wifi.getSavedNetworks();
+        CHECK_EQ(nets.size(), 2);
+        const WiFiCredential& beta = nets[0].ssid == "beta" ? nets[0] : nets[1];
+        CHECK_EQ(beta.attempts, 1);
+        CHECK_EQ(beta.successes, 1);
+        CHECK(beta.connectTime >= 4800 && beta.connectTime <= 5000);
+    }
+    
+    // The incumbent across boots. Boot 1 joined beta an hour after power
+    // on (above, the clock already ran for FAILURE_WINDOW); boot 2 joins
+    // alpha right away.
+    hostClock = 1000;
+    {
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.begin());
+        CHECK(wifi.connect("alpha", "password1"));
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(sim.joined == "alpha");
+        wifi.end();
+    }
+    
+    // Boot 3: both APs moved, so the cached join fails and a scan decides.
+    // Beta is 2 dB stronger, within the hysteresis: alpha, joined last,
+    // is kept.
+    hostClock = 1000;
+    sim.aps = {{"alpha", -62, 11, {0xA1}}, {"beta", -60, 1, {0xB1}}};
+    {
+        RSSIScoringPolicy rssi;
+        WiFiConnectionCore wifi(&host.config);
+        CHECK(wifi.begin());
+        wifi.setScoringPolicy(&rssi, 8);
+        int scans = sim.scans;
+        CHECK(wifi.connectToBest());
+        host.runUntil(wifi, [&] { return wifi.getState() == WIFI_CONNECTED; });
+        CHECK(wifi.getState() == WIFI_CONNECTED);
+        CHECK_EQ(sim.scans, scans + 1);
+        CHECK(sim.joined == "alpha");
+        wifi.end();
+        
+        // Without hysteresis the stronger one wins
+        hostClock = 1000;
+        sim.aps = {{"alpha", -62, 3, {0xA1}}, {"beta", -60, 4, {0xB1}}};
+        WiFiConnectionCore next(&host.config);
+        CHECK(next.begin());
+        next.setScoringPolicy(&rssi, 0);
+        CHECK(next.connectToBest());
+        host.runUntil(next, [&] { return next.getState() == WIFI_CONNECTED; });
+        CHECK(sim.joined == "beta");
+        next.end();
+    }
+    
+    return finish("test_wifi_scoring");
+}
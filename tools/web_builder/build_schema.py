@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+"""
+IonConnect Schema Compiler
+
+This script:
+1. Reads a JSON configuration schema
+2. Validates and minifies it
+3. Emits a PROGMEM field-descriptor table (ConfigField[])
+4. Generates a header file for embedding
+
+The generated table is loaded with ConfigManager::loadSchema(table, count, json),
+which skips JSON parsing and keeps every field string in flash.
+
+Usage:
+    python build_schema.py
+    python build_schema.py my_schema.json --name MY_SCHEMA --output ../../src/schemas/my_schema.h
+
+Requirements:
+    Python 3.6+ (standard library only)
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+from pathlib import Path
+
+# Paths
+SCRIPT_DIR = Path(__file__).parent
+PROJECT_ROOT = SCRIPT_DIR.parent.parent
+DEFAULT_INPUT = PROJECT_ROOT / 'src' / 'schemas' / 'schemas_src' / 'default_schema.json'
+DEFAULT_OUTPUT = PROJECT_ROOT / 'src' / 'schemas' / 'default_schema.h'
+SRC_DIR = PROJECT_ROOT / 'src'
+TYPES_HEADER = SRC_DIR / 'core' / 'IonTypes.h'
+
+# Must match the member order of ConfigField in src/core/IonTypes.h
+STRING_MEMBERS = [
+    ('id', 'id'),
+    ('label', 'label'),
+    ('type', 'type'),
+    ('default', 'defaultValue'),
+    ('placeholder', 'placeholder'),
+    ('pattern', 'pattern'),
+    ('visible_if', 'visibleIf'),
+]
+
+INT_MEMBERS = ['minLength', 'maxLength', 'min', 'max']
+
+# Schema `type` -> FieldType in src/core/IonTypes.h
+FIELD_TYPES = {
+    'text': 'FIELD_TEXT',
+    'password': 'FIELD_PASSWORD',
+    'number': 'FIELD_NUMBER',
+    'checkbox': 'FIELD_CHECKBOX',
+    'select': 'FIELD_SELECT',
+}
+
+
+def c_string(value):
+    """Quote a Python string as a C string literal"""
+    out = []
+    for ch in value:
+        if ch == '\\':
+            out.append('\\\\')
+        elif ch == '"':
+            out.append('\\"')
+        elif ch == '\n':
+            out.append('\\n')
+        elif ch == '\r':
+            out.append('\\r')
+        elif ch == '\t':
+            out.append('\\t')
+        elif ord(ch) < 0x20:
+            out.append(f'\\x{ord(ch):02x}')
+        else:
+            out.append(ch)
+    return '"' + ''.join(out) + '"'
+
+
+def scalar_to_string(value):
+    """Schema defaults may be written as numbers or booleans"""
+    if value is None:
+        return ''
+    if isinstance(value, bool):
+        return 'true' if value else 'false'
+    return str(value)
+
+
+class StringPool:
+    """Deduplicated PROGMEM string literals"""
+
+    def __init__(self, prefix):
+        self.prefix = prefix
+        self.index = {}
+        self.items = []
+
+    def ref(self, value):
+        if value not in self.index:
+            self.index[value] = f'{self.prefix}_STR_{len(self.items)}'
+            self.items.append(value)
+        return self.index[value]
+
+    def emit(self):
+        return '\n'.join(
+            f'const char {self.index[s]}[] PROGMEM = {c_string(s)};'
+            for s in self.items)
+
+
+def field_limits():
+    """ION_MAX_CONFIG_FIELDS from IonTypes.h as (minimal mode, full)"""
+    try:
+        text = TYPES_HEADER.read_text(encoding='utf-8')
+    except OSError:
+        return 8, 32
+    found = [int(n) for n in re.findall(r'#define\s+ION_MAX_CONFIG_FIELDS\s+(\d+)', text)]
+    if len(found) != 2:
+        return 8, 32
+    return min(found), max(found)
+
+
+def compile_schema(schema, name, max_fields):
+    """Build the C++ declarations for one schema"""
+    fields = schema.get('fields')
+    if not isinstance(fields, list):
+        raise ValueError("Schema missing 'fields' array")
+    if len(fields) > max_fields:
+        raise ValueError(f'Schema has {len(fields)} fields, ConfigManager holds at most '
+                         f'{max_fields} (ION_MAX_CONFIG_FIELDS)')
+
+    pool = StringPool(name)
+    pool.ref('')  # Shared empty string for unset members
+
+    option_arrays = []
+    rows = []
+    seen = set()
+
+    for i, field in enumerate(fields):
+        field_id = field.get('id')
+        if not field_id:
+            raise ValueError(f'Field #{i} has no id')
+        if field_id in seen:
+            raise ValueError(f'Duplicate field id: {field_id}')
+        seen.add(field_id)
+
+        values = []
+        for key, _member in STRING_MEMBERS:
+            default = 'text' if key == 'type' else ''
+            values.append(pool.ref(scalar_to_string(field.get(key, default))))
+
+        options = field.get('options') or []
+        if options:
+            opts_name = f'{name}_OPTS_{i}'
+            refs = ', '.join(pool.ref(scalar_to_string(o)) for o in options)
+            option_arrays.append(f'const char* const {opts_name}[] PROGMEM = {{ {refs} }};')
+            values.append(opts_name)
+        else:
+            values.append('nullptr')
+        values.append(str(len(options)))
+
+        for key in INT_MEMBERS:
+            values.append(str(int(field.get(key, 0))))
+
+        values.append('true' if field.get('required', False) else 'false')
+        values.append('true' if field.get('encrypted', False) else 'false')
+        values.append(FIELD_TYPES.get(field.get('type', 'text'), 'FIELD_OTHER'))
+
+        rows.append(f'    // {field_id}\n    {{ ' + ', '.join(values) + ' },')
+
+    minified = json.dumps(schema, separators=(',', ':'), ensure_ascii=False)
+    if ')json"' in minified:
+        raise ValueError('Schema contains the raw string delimiter )json"')
+
+    parts = [
+        '// Schema JSON served to the portal UI and BLE clients',
+        f'const char {name}[] PROGMEM = R"json({minified})json";',
+        '',
+        '// Field strings (deduplicated)',
+        pool.emit(),
+    ]
+    if option_arrays:
+        parts += ['', '// Select options'] + option_arrays
+    parts += [
+        '',
+        '// Field descriptor table - use with ConfigManager::loadSchema(table, count, json)',
+        f'const ConfigField {name}_FIELDS[] PROGMEM = {{',
+        '\n'.join(rows),
+        '};',
+        '',
+        f'const size_t {name}_FIELD_COUNT = {len(rows)};',
+    ]
+    return '\n'.join(parts), len(rows), len(pool.items)
+
+
+def types_include(output_path):
+    """#include line for IonTypes.h as seen from the generated header
+
+    Inside the library's src/ the path is relative, like the rest of the
+    library's own includes; anywhere else (a sketch, a project's include/)
+    it goes through the library's src/ on the include path.
+    """
+    out_dir = output_path.resolve().parent
+    src_dir = SRC_DIR.resolve()
+    if out_dir == src_dir or src_dir in out_dir.parents:
+        rel = Path(os.path.relpath(TYPES_HEADER.resolve(), out_dir)).as_posix()
+        return f'#include "{rel}"'
+    return '#include <core/IonTypes.h>'
+
+
+def build_header_file(output_path, input_path, body):
+    """Build complete header file"""
+    guard_name = output_path.name.upper().replace('.', '_')
+    try:
+        source = input_path.resolve().relative_to(PROJECT_ROOT.resolve()).as_posix()
+    except ValueError:
+        source = input_path.name
+
+    return f"""#ifndef {guard_name}
+#define {guard_name}
+
+// Generated by tools/web_builder/build_schema.py from {source}
+// Do not edit by hand - edit the JSON source and re-run the schema compiler.
+
+{types_include(output_path)}
+
+namespace IonConnect {{
+
+{body}
+
+}} // namespace IonConnect
+
+#endif // {guard_name}
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description='IonConnect schema compiler')
+    parser.add_argument('input', nargs='?', default=str(DEFAULT_INPUT),
+                        help='JSON schema source')
+    parser.add_argument('--name', default='DEFAULT_SCHEMA',
+                        help='C++ symbol prefix (default: DEFAULT_SCHEMA)')
+    parser.add_argument('--output', default=str(DEFAULT_OUTPUT),
+                        help='Generated header path')
+    parser.add_argument('--max-fields', type=int, default=None,
+                        help='Field limit (default: ION_MAX_CONFIG_FIELDS from IonTypes.h)')
+    args = parser.parse_args()
+
+    print("========================================")
+    print("  IonConnect Schema Compiler")
+    print("========================================\n")
+
+    input_path = Path(args.input)
+    output_path = Path(args.output)
+
+    if not input_path.exists():
+        print(f"ERROR: Schema not found: {input_path}")
+        return 1
+
+    with open(input_path, 'r', encoding='utf-8') as f:
+        try:
+            schema = json.load(f)
+        except json.JSONDecodeError as e:
+            print(f"ERROR: Invalid JSON: {e}")
+            return 1
+
+    minimal_limit, full_limit = field_limits()
+    max_fields = args.max_fields if args.max_fields is not None else full_limit
+
+    try:
+        body, field_count, string_count = compile_schema(schema, args.name, max_fields)
+    except ValueError as e:
+        print(f"ERROR: {e}")
+        return 1
+
+    print(f"  ✓ {field_count} fields, {string_count} unique strings")
+    if field_count > minimal_limit:
+        print(f"  ! ION_MINIMAL_MODE keeps only the first {minimal_limit} fields")
+
+    output_path.parent.mkdir(parents=True, exist_ok=True)
+    with open(output_path, 'w', encoding='utf-8') as f:
+        f.write(build_header_file(output_path, input_path, body))
+
+    print(f"\n✓ Generated: {output_path}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())